@@ -109,6 +109,7 @@ SECTIONS
 
    ramgs0           : > RAMGS0,    PAGE = 1
    ramgs1           : > RAMGS1,    PAGE = 1
+   ramgs2           : > RAMGS2,    PAGE = 1
 
    .TI.ramfunc      : LOAD = FLASH_BANK0_SEC1,
                          RUN = RAMLS0 | RAMLS1 | RAMLS2 |RAMLS3,
@@ -110,5 +110,6 @@ SECTIONS
 
    ramgs0           : > RAMGS0,    PAGE = 1
    ramgs1           : > RAMGS1,    PAGE = 1  
+   ramgs2           : > RAMGS2,    PAGE = 1
 }
 
@@ -0,0 +1,239 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "CharacterLCD.h"
+
+
+// Lower the 74HC595 latch line
+#define LATCH_LOW GpioDataRegs.GPBCLEAR.bit.GPIO39 = 1
+
+// Raise the 74HC595 latch line, transferring the shifted data to the outputs
+#define LATCH_HIGH GpioDataRegs.GPBSET.bit.GPIO39 = 1
+
+// HD44780 commands
+#define LCD_CLEAR 0x01
+#define LCD_ENTRY_MODE_INCREMENT 0x06
+#define LCD_DISPLAY_ON 0x0C
+#define LCD_FUNCTION_4BIT_2LINE 0x28
+#define LCD_SET_ADDRESS 0x80
+
+// DDRAM address of the start of each row
+#define LCD_ROW_ADDRESS(row) ((row) * 0x40)
+
+// Marker for an unknown cursor position
+#define LCD_CURSOR_UNKNOWN 0xFFFF
+
+
+CharacterLCD :: CharacterLCD(SPIBus *spiBus)
+{
+    this->spiBus = spiBus;
+    this->cursor = LCD_CURSOR_UNKNOWN;
+    this->backlight = 0;
+    this->shownMessage = NULL;
+    this->shownLeds.all = 0;
+    this->dirty = (1 << DISPLAY_FIELD_COUNT) - 1;
+
+    for( int row = 0; row < LCD_ROWS; row++ ) {
+        for( int column = 0; column < LCD_COLUMNS; column++ ) {
+            this->shown[row][column] = ' ';
+            this->frame[row][column] = ' ';
+        }
+    }
+}
+
+void CharacterLCD :: initHardware(void)
+{
+    EALLOW;
+
+    // use GPIO39 as the shift register latch
+    GpioCtrlRegs.GPBMUX1.bit.GPIO39 = 0x0;      // SELECT GPIO39
+    GpioCtrlRegs.GPBDIR.bit.GPIO39 = 1;         // output
+    LATCH_HIGH;
+
+    EDIS;
+
+    configureSpiBus();
+
+    // give the LCD time to power up
+    DELAY_US(50000);
+
+    // force 8-bit mode from any starting state, then switch to 4-bit mode
+    sendNibble(0x3, 0);
+    DELAY_US(4500);
+    sendNibble(0x3, 0);
+    DELAY_US(150);
+    sendNibble(0x3, 0);
+    sendNibble(0x2, 0);
+
+    sendCommand(LCD_FUNCTION_4BIT_2LINE);
+    sendCommand(LCD_DISPLAY_ON);
+    sendCommand(LCD_CLEAR);
+    DELAY_US(2000);
+    sendCommand(LCD_ENTRY_MODE_INCREMENT);
+
+    // the screen is now blank, which matches the render cache
+    this->cursor = LCD_CURSOR_UNKNOWN;
+}
+
+void CharacterLCD :: configureSpiBus( void )
+{
+    // configure the shared bus
+    this->spiBus->setFourWire();
+    this->spiBus->setEightBits();
+}
+
+void CharacterLCD :: shiftOut(Uint16 data)
+{
+    LATCH_LOW;
+    this->spiBus->sendWord(data << 8);
+    LATCH_HIGH;
+}
+
+void CharacterLCD :: sendNibble(Uint16 nibble, Uint16 rs)
+{
+    Uint16 data = (nibble & LCD_DATA_MASK) | rs | this->backlight;
+
+    // the LCD reads the data on the falling edge of E; each transfer takes
+    // far longer than the minimum pulse width and execution time
+    shiftOut(data | LCD_E);
+    shiftOut(data);
+}
+
+void CharacterLCD :: sendCommand(Uint16 command)
+{
+    sendNibble(command >> 4, 0);
+    sendNibble(command, 0);
+}
+
+void CharacterLCD :: sendCharacter(char c)
+{
+    sendNibble(c >> 4, LCD_RS);
+    sendNibble(c, LCD_RS);
+}
+
+void CharacterLCD :: put(Uint16 row, Uint16 column, const char *text, Uint16 maxLength)
+{
+    if( text == NULL ) return;
+
+    for( ; *text != '\0' && maxLength > 0 && column < LCD_COLUMNS; text++, maxLength--, column++ ) {
+        this->frame[row][column] = *text;
+    }
+}
+
+void CharacterLCD :: compose(void)
+{
+    for( int row = 0; row < LCD_ROWS; row++ ) {
+        for( int column = 0; column < LCD_COLUMNS; column++ ) {
+            this->frame[row][column] = ' ';
+        }
+    }
+
+    // a message takes over the whole screen
+    if( this->message != NULL ) {
+        put(0, 4, this->message, LCD_COLUMNS);
+        return;
+    }
+
+    // top row: RPM and mode
+    put(0, 0, "RPM", 3);
+    put(0, 4, getText(DISPLAY_FIELD_RPM), 4);
+
+    if( ! this->leds.bit.POWER ) {
+        put(0, 10, "OFF", 3);
+    }
+    else if( this->leds.bit.THREAD ) {
+        put(0, 10, "THREAD", 6);
+    }
+    else if( this->leds.bit.FEED ) {
+        put(0, 10, "FEED", 4);
+    }
+
+    // bottom row: readout, or value, units and direction
+    if( getText(DISPLAY_FIELD_READOUT) != NULL ) {
+        put(1, 0, getText(DISPLAY_FIELD_READOUT), LCD_COLUMNS);
+        return;
+    }
+
+    put(1, 0, getText(DISPLAY_FIELD_VALUE), 6);
+
+    if( this->leds.bit.TPI ) {
+        put(1, 7, "TPI", 3);
+    }
+    else if( this->leds.bit.INCH ) {
+        put(1, 7, "in", 2);
+    }
+    else if( this->leds.bit.MM ) {
+        put(1, 7, "mm", 2);
+    }
+
+    if( this->leds.bit.FORWARD ) {
+        put(1, 13, "FWD", 3);
+    }
+    else if( this->leds.bit.REVERSE ) {
+        put(1, 13, "REV", 3);
+    }
+}
+
+void CharacterLCD :: refresh(void)
+{
+    Uint16 budget = LCD_MAX_CHARS_PER_REFRESH;
+
+    configureSpiBus();
+
+    // the backlight is either on or off
+    Uint16 backlight = (this->brightness > 0) ? LCD_BACKLIGHT : 0;
+    if( backlight != this->backlight ) {
+        this->backlight = backlight;
+        shiftOut(backlight);
+    }
+
+    // rebuild the frame only if the content changed
+    if( this->dirty != 0 || this->message != this->shownMessage || this->leds.all != this->shownLeds.all ) {
+        this->shownMessage = this->message;
+        this->shownLeds = this->leds;
+        this->dirty = 0;
+        compose();
+    }
+
+    // send only the characters that changed; anything left over will go out
+    // on the next refresh
+    for( int row = 0; row < LCD_ROWS && budget > 0; row++ ) {
+        for( int column = 0; column < LCD_COLUMNS && budget > 0; column++ ) {
+            if( this->frame[row][column] != this->shown[row][column] ) {
+                Uint16 address = LCD_ROW_ADDRESS(row) + column;
+
+                if( this->cursor != address ) {
+                    sendCommand(LCD_SET_ADDRESS | address);
+                }
+                sendCharacter(this->frame[row][column]);
+
+                this->shown[row][column] = this->frame[row][column];
+                this->cursor = address + 1;
+                budget--;
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __CHARACTER_LCD_H
+#define __CHARACTER_LCD_H
+
+#include "F28x_Project.h"
+#include "SPIBus.h"
+#include "Display.h"
+
+
+// Display geometry
+#define LCD_ROWS 2
+#define LCD_COLUMNS 16
+
+// Maximum number of characters sent per refresh, to bound the time spent
+#define LCD_MAX_CHARS_PER_REFRESH 8
+
+// 74HC595 output bits
+#define LCD_DATA_MASK 0x0F      // Q0-Q3 = D4-D7
+#define LCD_RS 0x10             // Q4 = RS
+#define LCD_E 0x20              // Q5 = E
+#define LCD_BACKLIGHT 0x80      // Q7 = backlight
+
+
+//
+// HD44780 character LCD
+//
+// 16x2 character LCD driven in 4-bit mode through a 74HC595 shift register on
+// the shared SPI bus, with the register latch on GPIO39.  Each nibble takes two
+// transfers, so the screen is slow to write; a render cache of the characters
+// on screen is kept, and only characters that changed are sent.
+//
+class CharacterLCD : public Display
+{
+private:
+    // Common SPI Bus
+    SPIBus *spiBus;
+
+    // characters currently on the screen
+    char shown[LCD_ROWS][LCD_COLUMNS];
+
+    // characters we want on the screen
+    char frame[LCD_ROWS][LCD_COLUMNS];
+
+    // current DDRAM address, or LCD_CURSOR_UNKNOWN
+    Uint16 cursor;
+
+    // current backlight output bit
+    Uint16 backlight;
+
+    // message and LEDs the frame was composed from
+    const char *shownMessage;
+    LED_REG shownLeds;
+
+    void configureSpiBus(void);
+    void shiftOut(Uint16 data);
+    void sendNibble(Uint16 nibble, Uint16 rs);
+    void sendCommand(Uint16 command);
+    void sendCharacter(char c);
+    void put(Uint16 row, Uint16 column, const char *text, Uint16 maxLength);
+    void compose(void);
+
+public:
+    CharacterLCD(SPIBus *spiBus);
+
+    // initialize the hardware for operation
+    void initHardware(void);
+
+    // refresh the hardware display
+    void refresh(void);
+};
+
+
+#endif // __CHARACTER_LCD_H
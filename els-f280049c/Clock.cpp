@@ -0,0 +1,57 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Clock.h"
+
+
+Clock :: Clock( void )
+{
+    this->lastCycles = 0;
+    this->millis = 0;
+}
+
+void Clock :: initHardware(void)
+{
+    // CPU Timer 1 has already been stopped and set to the maximum period
+    // by InitCpuTimers(); disable its interrupt and let it run
+    CpuTimer1Regs.TCR.bit.TIE = 0;
+    CpuTimer1Regs.TCR.bit.TRB = 1;
+    CpuTimer1Regs.TCR.bit.TSS = 0;
+
+    this->lastCycles = getCycles();
+    this->millis = 0;
+}
+
+Uint32 Clock :: getMillis(void)
+{
+    Uint32 elapsedMillis = (getCycles() - this->lastCycles) / CYCLES_PER_MS;
+
+    // only consume whole milliseconds, so we never lose the remainder
+    this->lastCycles += elapsedMillis * CYCLES_PER_MS;
+    this->millis += elapsedMillis;
+
+    return this->millis;
+}
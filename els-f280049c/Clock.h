@@ -0,0 +1,76 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __CLOCK_H
+#define __CLOCK_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+
+
+#define CYCLES_PER_MS (CPU_CLOCK_HZ / 1000)
+
+
+//
+// Free-running system timebase
+//
+// CPU Timer 1 is left running at SYSCLK with the maximum period, so it can be
+// read at any time (even from the ISR) to get a cycle count.  The cycle count
+// wraps every 2^32 cycles (about 43 seconds at 100MHz), so the millisecond count
+// is accumulated in software and must be read at least that often from the
+// background loop.
+//
+class Clock
+{
+private:
+    // cycle count at the last millisecond boundary we accounted for
+    Uint32 lastCycles;
+
+    // milliseconds since initHardware()
+    Uint32 millis;
+
+public:
+    Clock(void);
+
+    // initialize the hardware for operation
+    void initHardware(void);
+
+    // free-running CPU cycle count; safe to call from the ISR
+    Uint32 getCycles(void);
+
+    // milliseconds since startup; background loop only
+    Uint32 getMillis(void);
+};
+
+
+inline Uint32 Clock :: getCycles(void)
+{
+    // the timer counts down from the period
+    return 0xFFFFFFFF - CpuTimer1Regs.TIM.all;
+}
+
+
+#endif // __CLOCK_H
@@ -115,6 +115,12 @@
 // Use floating-point math for gear ratios
 #define USE_FLOATING_POINT
 
+// Spindle travel, in encoder counts, over which a feed change made while the
+// spindle is turning ramps from the old ratio to the new one.  The carriage
+// stays where it is and its speed changes evenly over this distance instead of
+// all at once.  Changes made with the spindle stopped take effect immediately.
+#define FEED_RAMP_COUNTS (ENCODER_RESOLUTION / 2)
+
 
 
 
@@ -133,6 +139,21 @@
 
 
 
+//================================================================================
+//                                 DISPLAY
+//
+// Define which display to use.  The TM1638 LED&KEY control panel always
+// provides the keys, but its display can be replaced with a 16x2 character LCD
+// (HD44780) driven through a 74HC595 shift register on the SPI bus, with the
+// register latch on GPIO39.  Define only one.
+//================================================================================
+
+#define DISPLAY_TM1638
+//#define DISPLAY_CHARACTER_LCD
+
+
+
+
 //================================================================================
 //                                FEATURES
 //
@@ -146,6 +167,96 @@
 
 
 
+//================================================================================
+//                                  KEYPAD
+//
+// Key scanning, debounce, auto-repeat and long press timing.  Holding UP or DOWN
+// repeats the key, starting slowly and speeding up the longer it is held.
+// Holding any other key registers a long press.  All times are in milliseconds.
+//================================================================================
+
+// How often the keys are read from the control panel
+#define KEY_SCAN_INTERVAL_MS 2
+
+// Time a key state must be read consistently before it is accepted
+#define KEY_DEBOUNCE_MS 6
+
+// Time UP or DOWN must be held before it starts repeating
+#define KEY_REPEAT_DELAY_MS 500
+
+// Initial and fastest repeat intervals
+#define KEY_REPEAT_INTERVAL_MS 200
+#define KEY_REPEAT_MIN_INTERVAL_MS 40
+
+// Amount the repeat interval is shortened after each repeat
+#define KEY_REPEAT_ACCELERATION_MS 10
+
+// Time a key must be held to register a long press
+#define KEY_LONG_PRESS_MS 1000
+
+
+
+
+//================================================================================
+//                             SETTINGS STORAGE
+//
+// Settings are saved to the EEPROM through a write-back cache, so a burst of
+// changes (like scrolling through the feeds) is coalesced into one write once
+// the settings have been left alone for the flush delay.  Writes are also
+// limited to one per minimum interval to protect the EEPROM's endurance.
+// Pending changes are written immediately when the power is turned off with
+// the POWER key.  All times are in milliseconds.
+//
+// Brown-out flushing is optional, and needs the supply voltage brought to an
+// ADC-B input through a divider.  When the reading drops below the threshold
+// (12-bit counts against the 3.3V reference), the pending changes are written
+// while the regulator still holds the processor up.
+//================================================================================
+
+// Time settings must be left unchanged before they are written
+#define SETTINGS_FLUSH_DELAY_MS 3000
+
+// Shortest time between writes
+#define SETTINGS_MIN_WRITE_INTERVAL_MS 10000
+
+// Flush the settings when the supply voltage drops
+//#define USE_BROWNOUT_FLUSH
+#define BROWNOUT_ADC_CHANNEL 1          // ADCINB1
+#define BROWNOUT_THRESHOLD 1800
+
+
+
+//================================================================================
+//                           SERIAL PORT/TELEMETRY
+//
+// The serial port is SCI-A, which the LaunchPad brings out as a virtual COM
+// port on the debug USB connection.  It carries the post-mortem trace when it
+// freezes, and can stream samples of the engine (spindle count, carriage
+// position, step backlog and RPM) for plotting.  Decode the stream to CSV with
+// tools/telemetry.py.  Each sample takes 18 bytes on the wire, so the sample
+// rate is limited by the baud rate.
+//
+// Instead of the telemetry, it can stream the raw spindle encoder count from
+// every ISR tick, to replay a customer's spindle through the engine on a PC or
+// through the encoder simulator.  Record and replay it with tools/capture.py
+// and host/replay.  The capture needs about 690000 baud; use 1562500 so the
+// background loop has room to fall behind while the display updates.
+//================================================================================
+
+// Enable the telemetry stream
+//#define USE_TELEMETRY
+
+// Enable the encoder capture stream
+//#define USE_ENCODER_CAPTURE
+
+// Serial port speed; 781250 and 1562500 are exact with a 100MHz CPU clock
+#define SERIAL_BAUD 781250
+
+// Samples per second; must divide evenly into the ISR rate
+#define TELEMETRY_RATE_HZ 2500
+
+
+
 //================================================================================
 //                              VALIDATION/TRIP
 //
@@ -158,6 +269,24 @@
 // when the buffered step count exceeds this value.
 #define MAX_BUFFERED_STEPS 100
 
+// Post-mortem trace
+// The engine is sampled every TRACE_DIVIDER ISR cycles into a trace of the
+// last 2048 samples, which freezes when the step backlog trips, the servo
+// alarm asserts or the carriage reaches a soft limit.  The frozen trace is sent
+// out of the serial port as CSV (see TELEMETRY) and can be stepped through on
+// the trace page of the display.  Once sent, it starts again when the power is
+// switched on, on the console's "trace arm", or when a soft limit clears.
+// Comment out USE_TRACE to take the sampling out of the ISR and free the RAM.
+#define USE_TRACE
+#define TRACE_DIVIDER 5
+
+// ISR benchmark
+// Builds an image that times the ISR against every feed table row and encoder
+// state and sends the report out of the serial port, instead of running the
+// lathe.  Compare runs with tools/isr_bench.py.  The step outputs run while it
+// works, so leave the spindle stopped and the motor free to turn, or unplug it.
+//#define ENABLE_ISR_BENCHMARK
+
 
 //================================================================================
 //                               CPU / TIMING
@@ -0,0 +1,604 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Console.h"
+#include "CRC.h"
+
+
+// Reply storage lives in global RAM; the default data section is full
+#pragma DATA_SECTION(console_output, "ramgs1")
+char console_output[CONSOLE_OUTPUT_SIZE];
+
+
+// Settings that can be read and changed at runtime
+#define SETTING_BACKLOG 0
+#define SETTING_BRIGHTNESS 1
+#define SETTING_TELEMETRY 2
+#define SETTING_COUNT 3
+
+typedef struct CONSOLE_SETTING
+{
+    const char *name;
+    int32 minimum;
+    int32 maximum;
+    const char *description;
+} CONSOLE_SETTING;
+
+static const CONSOLE_SETTING SETTINGS[SETTING_COUNT] =
+{
+    { "backlog", 1, 10000, "steps behind before the drive trips" },
+    { "brightness", 0, 8, "display brightness, 0-8" },
+    { "telemetry", 0, 1, "telemetry stream on/off" }
+};
+
+#ifdef USE_TRACE
+static const char *TRACE_STATES[] =
+{
+    "running",
+    "frozen: step backlog",
+    "frozen: servo alarm",
+    "frozen: soft limit",
+    "frozen: requested"
+};
+#endif
+
+static const char *HELP_TEXT =
+    "status                  machine state and counters\r\n"
+    "get [name]              show settings\r\n"
+    "set <name> <value>      change a setting\r\n"
+    "limit [min|max <steps|here|off>]\r\n"
+    "                        show or set the soft limits\r\n"
+#ifdef USE_TRACE
+    "trace [dump|arm]        show, freeze and send, or restart the trace\r\n"
+#endif
+    "test                    run the self-tests\r\n";
+
+
+// C28x strings have no library here; these are all the console needs
+static bool isEqual(const char *a, const char *b)
+{
+    while( *a && *a == *b ) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static bool parseNumber(const char *text, int32 *value)
+{
+    bool negative = false;
+    int32 result = 0;
+
+    if( *text == '-' ) {
+        negative = true;
+        text++;
+    }
+    if( *text == 0 ) {
+        return false;
+    }
+    while( *text ) {
+        if( *text < '0' || *text > '9' || result > 99999999 ) {
+            return false;
+        }
+        result = result * 10 + (*text++ - '0');
+    }
+
+    *value = negative ? -result : result;
+    return true;
+}
+
+
+Console :: Console(SerialPort *serialPort, Core *core, StepperDrive *stepperDrive, Monitor *monitor,
+                   Trace *trace, Display *display, EEPROM *eeprom, EEPROMCache *eepromCache,
+                   FeedTableFactory *feedTableFactory, Telemetry *telemetry)
+{
+    this->serialPort = serialPort;
+    this->core = core;
+    this->stepperDrive = stepperDrive;
+    this->monitor = monitor;
+    this->trace = trace;
+    this->display = display;
+    this->eeprom = eeprom;
+    this->eepromCache = eepromCache;
+    this->feedTableFactory = feedTableFactory;
+    this->telemetry = telemetry;
+
+    this->lineLength = 0;
+    this->lineReady = false;
+    this->lineTooLong = false;
+    this->lastReceived = 0;
+
+    this->output = console_output;
+    this->outputHead = 0;
+    this->outputTail = 0;
+
+    this->testing = false;
+    this->testPage = 0;
+    this->testSame = true;
+}
+
+bool Console :: service(void)
+{
+    // a self-test takes a step per call until it's done, and holds off the
+    // next command
+    if( this->testing ) {
+        return continueTest();
+    }
+
+    // a complete line waits for its own call
+    if( this->lineReady ) {
+        execute();
+        this->lineLength = 0;
+        this->lineReady = false;
+        this->lineTooLong = false;
+        if( ! this->testing ) {
+            print("> ");
+        }
+        return true;
+    }
+
+    // take what's arrived, up to the end of a line
+    Uint16 count = serialPort->getReadCount();
+    while( count-- > 0 && ! this->lineReady ) {
+        receive(serialPort->readByte());
+    }
+
+    return false;
+}
+
+void Console :: receive(Uint16 c)
+{
+    Uint16 last = this->lastReceived;
+    this->lastReceived = c;
+
+    if( c == '\r' || c == '\n' ) {
+        // CR LF is one line end
+        if( c == '\n' && last == '\r' ) {
+            return;
+        }
+        print("\r\n");
+        this->line[this->lineLength] = 0;
+        this->lineReady = true;
+    }
+    else if( c == '\b' || c == 0x7f ) {
+        if( this->lineLength > 0 ) {
+            this->lineLength--;
+            print("\b \b");
+        }
+    }
+    else if( c >= ' ' && c <= '~' ) {
+        if( this->lineLength < CONSOLE_LINE_LENGTH - 1 ) {
+            this->line[this->lineLength++] = c;
+            char echo[2] = { (char)c, 0 };
+            print(echo);
+        }
+        else {
+            this->lineTooLong = true;
+        }
+    }
+}
+
+void Console :: execute(void)
+{
+    char *words[CONSOLE_MAX_WORDS];
+    Uint16 count = 0;
+
+    if( this->lineTooLong ) {
+        print("line too long\r\n");
+        return;
+    }
+
+    // split the line into words, in place
+    char *p = this->line;
+    while( *p && count < CONSOLE_MAX_WORDS ) {
+        while( *p == ' ' ) *p++ = 0;
+        if( *p == 0 ) break;
+        words[count++] = p;
+        while( *p && *p != ' ' ) p++;
+    }
+    while( *p == ' ' ) *p++ = 0;
+    if( *p ) {
+        print("too many words\r\n");
+        return;
+    }
+
+    if( count == 0 ) {
+        return;
+    }
+
+    if( isEqual(words[0], "help") ) commandHelp();
+    else if( isEqual(words[0], "status") ) commandStatus();
+    else if( isEqual(words[0], "get") ) commandGet(count, words);
+    else if( isEqual(words[0], "set") ) commandSet(count, words);
+    else if( isEqual(words[0], "limit") ) commandLimit(count, words);
+#ifdef USE_TRACE
+    else if( isEqual(words[0], "trace") ) commandTrace(count, words);
+#endif
+    else if( isEqual(words[0], "test") ) commandTest();
+    else print("unknown command; try help\r\n");
+}
+
+void Console :: send(void)
+{
+    Uint16 space = serialPort->getWriteSpace();
+
+    while( space > 0 && this->outputTail != this->outputHead ) {
+        serialPort->writeByte(this->output[this->outputTail]);
+        this->outputTail = (this->outputTail + 1) & CONSOLE_OUTPUT_MASK;
+        space--;
+    }
+}
+
+void Console :: print(const char *text)
+{
+    // whatever doesn't fit is lost
+    while( *text ) {
+        Uint16 next = (this->outputHead + 1) & CONSOLE_OUTPUT_MASK;
+        if( next == this->outputTail ) {
+            return;
+        }
+        this->output[this->outputHead] = *text++;
+        this->outputHead = next;
+    }
+}
+
+void Console :: printNumber(int32 value, Uint16 decimals)
+{
+    char digits[DISPLAY_MAX_DIGITS + 2];
+    Display::formatNumber(digits, DISPLAY_MAX_DIGITS, value, decimals);
+
+    // drop the padding the display wants
+    char *d = digits;
+    while( *d == ' ' ) {
+        d++;
+    }
+    print(d);
+}
+
+void Console :: printPercent(Uint16 tenths)
+{
+    printNumber(tenths, 1);
+    print("%");
+}
+
+void Console :: printOnOff(bool on)
+{
+    print(on ? "on" : "off");
+}
+
+void Console :: printLimit(const char *name, bool enabled, int32 position)
+{
+    print(name);
+    print(" ");
+    if( enabled ) {
+        printNumber(position, 0);
+    }
+    else {
+        print("off");
+    }
+}
+
+void Console :: report(const char *name, bool pass)
+{
+    print(name);
+    print(pass ? "  pass\r\n" : "  FAIL\r\n");
+}
+
+void Console :: commandHelp(void)
+{
+    print(HELP_TEXT);
+}
+
+void Console :: commandStatus(void)
+{
+    int32 position;
+    bool enabled;
+
+    print("rpm ");
+    printNumber(core->getRPM(), 0);
+    print("  power ");
+    printOnOff(core->isPowerOn());
+    print("\r\nposition ");
+    printNumber(monitor->getPosition(), 0);
+    print(" steps  rate ");
+    printNumber(monitor->getStepRate(), 0);
+    print(" steps/s  backlog ");
+    printNumber(monitor->getBacklog(), 0);
+    print("/");
+    printNumber(monitor->getBacklogLimit(), 0);
+
+    print("\r\nisr load ");
+    printPercent(monitor->getLoad());
+    print(" peak ");
+    printPercent(monitor->getPeakLoad());
+    print("\r\nbackground ");
+    printPercent(monitor->getBackgroundLoad());
+    print("  idle ");
+    printPercent(monitor->getIdle());
+    print("  refresh peak ");
+    printPercent(monitor->getRefreshPeak());
+    print("  overruns ");
+    printNumber(monitor->getOverruns(), 0);
+
+    print("\r\neeprom writes ");
+    printNumber(eepromCache->getWriteCount(), 0);
+    print("  failures ");
+    printNumber(eeprom->getFailureCount(), 0);
+    print("  tables ");
+    print(feedTableFactory->isLoaded() ? "user" : "built-in");
+
+    if( telemetry != NULL ) {
+        print("\r\ntelemetry ");
+        printOnOff(telemetry->isEnabled());
+        print("  dropped ");
+        printNumber(telemetry->getDropped(), 0);
+    }
+
+#ifdef USE_TRACE
+    print("\r\ntrace ");
+    print(TRACE_STATES[trace->getReason()]);
+#endif
+
+    print("\r\nlimits ");
+    enabled = stepperDrive->getMinLimit(&position);
+    printLimit("min", enabled, position);
+    print("  ");
+    enabled = stepperDrive->getMaxLimit(&position);
+    printLimit("max", enabled, position);
+    print("\r\n");
+}
+
+int16 Console :: findSetting(const char *name)
+{
+    for( Uint16 i = 0; i < SETTING_COUNT; i++ ) {
+        if( isEqual(name, SETTINGS[i].name) ) {
+            return i;
+        }
+    }
+    print("no such setting; try get\r\n");
+    return -1;
+}
+
+int32 Console :: getSetting(Uint16 setting)
+{
+    switch( setting ) {
+    case SETTING_BACKLOG:
+        return stepperDrive->getBacklogLimit();
+    case SETTING_BRIGHTNESS:
+        return display->getBrightness();
+    case SETTING_TELEMETRY:
+        return telemetry != NULL && telemetry->isEnabled();
+    }
+    return 0;
+}
+
+bool Console :: setSetting(Uint16 setting, int32 value)
+{
+    switch( setting ) {
+    case SETTING_BACKLOG:
+        stepperDrive->setBacklogLimit(value);
+        return true;
+    case SETTING_BRIGHTNESS:
+        display->setBrightness(value);
+        return true;
+    case SETTING_TELEMETRY:
+        if( telemetry == NULL ) {
+            print("telemetry isn't built in; see USE_TELEMETRY\r\n");
+            return false;
+        }
+        telemetry->setEnabled(value != 0);
+        return true;
+    }
+    return false;
+}
+
+void Console :: commandGet(Uint16 count, char **words)
+{
+    for( Uint16 i = 0; i < SETTING_COUNT; i++ ) {
+        if( count < 2 || isEqual(words[1], SETTINGS[i].name) ) {
+            print(SETTINGS[i].name);
+            print(" = ");
+            printNumber(getSetting(i), 0);
+            print("    ");
+            print(SETTINGS[i].description);
+            print("\r\n");
+        }
+    }
+    if( count >= 2 ) {
+        findSetting(words[1]);
+    }
+}
+
+void Console :: commandSet(Uint16 count, char **words)
+{
+    int32 value;
+
+    if( count != 3 ) {
+        print("usage: set <name> <value>\r\n");
+        return;
+    }
+
+    int16 setting = findSetting(words[1]);
+    if( setting < 0 ) {
+        return;
+    }
+    if( ! parseNumber(words[2], &value) || value < SETTINGS[setting].minimum || value > SETTINGS[setting].maximum ) {
+        print("value must be ");
+        printNumber(SETTINGS[setting].minimum, 0);
+        print(" to ");
+        printNumber(SETTINGS[setting].maximum, 0);
+        print("\r\n");
+        return;
+    }
+
+    if( setSetting(setting, value) ) {
+        print(SETTINGS[setting].name);
+        print(" = ");
+        printNumber(getSetting(setting), 0);
+        print("\r\n");
+    }
+}
+
+void Console :: commandLimit(Uint16 count, char **words)
+{
+    int32 minimum, maximum, position;
+    bool useMinimum = stepperDrive->getMinLimit(&minimum);
+    bool useMaximum = stepperDrive->getMaxLimit(&maximum);
+
+    if( count == 3 ) {
+        bool isMinimum = isEqual(words[1], "min");
+        bool enabled = true;
+
+        if( ! isMinimum && ! isEqual(words[1], "max") ) {
+            print("usage: limit min|max <steps|here|off>\r\n");
+            return;
+        }
+
+        if( isEqual(words[2], "off") ) {
+            enabled = false;
+            position = 0;
+        }
+        else if( isEqual(words[2], "here") ) {
+            position = monitor->getPosition();
+        }
+        else if( ! parseNumber(words[2], &position) ) {
+            print("usage: limit min|max <steps|here|off>\r\n");
+            return;
+        }
+
+        if( enabled ) {
+            // a limit the carriage is already past would make it jump
+            int32 carriage = monitor->getPosition();
+            if( (isMinimum && carriage < position) || (! isMinimum && carriage > position) ) {
+                print("the carriage is past that limit\r\n");
+                return;
+            }
+            if( (isMinimum && useMaximum && position >= maximum) || (! isMinimum && useMinimum && position <= minimum) ) {
+                print("min must be below max\r\n");
+                return;
+            }
+        }
+
+        if( isMinimum ) {
+            stepperDrive->setMinLimit(enabled, position);
+        }
+        else {
+            stepperDrive->setMaxLimit(enabled, position);
+        }
+        useMinimum = stepperDrive->getMinLimit(&minimum);
+        useMaximum = stepperDrive->getMaxLimit(&maximum);
+    }
+    else if( count != 1 ) {
+        print("usage: limit min|max <steps|here|off>\r\n");
+        return;
+    }
+
+    printLimit("min", useMinimum, minimum);
+    print("  ");
+    printLimit("max", useMaximum, maximum);
+    print("  position ");
+    printNumber(monitor->getPosition(), 0);
+    print("\r\n");
+}
+
+#ifdef USE_TRACE
+void Console :: commandTrace(Uint16 count, char **words)
+{
+    if( count == 2 && isEqual(words[1], "dump") ) {
+        // the ISR has to stop writing it first
+        trace->freeze(TRACE_REQUESTED);
+        trace->dump();
+    }
+    else if( count == 2 && isEqual(words[1], "arm") ) {
+        // starts again once any dump has gone out
+        trace->arm();
+    }
+    else if( count != 1 ) {
+        print("usage: trace [dump|arm]\r\n");
+        return;
+    }
+
+    print("trace ");
+    print(TRACE_STATES[trace->getReason()]);
+    print(", ");
+    printNumber(trace->getCount(), 0);
+    print(" samples\r\n");
+}
+#endif
+
+void Console :: commandTest(void)
+{
+    // the CRC against the standard check value for "12345678"
+    static const Uint16 CHECK_WORDS[] = { 0x3132, 0x3334, 0x3536, 0x3738 };
+    report("crc", crc16(CRC16_INIT, CHECK_WORDS, 4) == 0xA12B);
+
+    // the EEPROM is read a page per call to service() from here on
+    this->testing = true;
+    this->testPage = 0;
+    this->testSame = true;
+}
+
+bool Console :: continueTest(void)
+{
+    Uint16 first[EEPROM_PAGE_SIZE], second[EEPROM_PAGE_SIZE];
+
+    // read only while no write is queued, so the read never waits for a write
+    // cycle and both copies come from the chip
+    if( eeprom->isBusy() ) {
+        return false;
+    }
+
+    // the page reads back the same way twice
+    if( this->testPage < EEPROM_PAGE_COUNT ) {
+        Uint16 address = EEPROM_PAGE_ADDRESS(this->testPage);
+        eeprom->beginRead(address);
+        eeprom->readNext(EEPROM_PAGE_SIZE, first);
+        eeprom->endRead();
+        eeprom->beginRead(address);
+        eeprom->readNext(EEPROM_PAGE_SIZE, second);
+        eeprom->endRead();
+
+        for( Uint16 i = 0; i < EEPROM_PAGE_SIZE; i++ ) {
+            if( first[i] != second[i] ) this->testSame = false;
+        }
+        this->testPage++;
+        return true;
+    }
+
+    // every page read back the same, and no write has failed since startup
+    report("eeprom", this->testSame && eeprom->getFailureCount() == 0);
+
+    // the ISR fits in its period, and the user interface in its refresh
+    report("isr timing", monitor->getPeakLoad() < 1000);
+    report("refresh timing", monitor->getOverruns() == 0);
+
+    // the servo drive isn't reporting a fault
+    report("servo alarm", ! stepperDrive->isAlarm());
+
+    this->testing = false;
+    print("> ");
+    return true;
+}
@@ -0,0 +1,149 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __CONSOLE_H
+#define __CONSOLE_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+#include "SerialPort.h"
+#include "Core.h"
+#include "StepperDrive.h"
+#include "Monitor.h"
+#include "Trace.h"
+#include "Telemetry.h"
+#include "Display.h"
+#include "EEPROM.h"
+#include "EEPROMCache.h"
+#include "Tables.h"
+
+
+// Longest command line, including the terminator
+#define CONSOLE_LINE_LENGTH 64
+
+// Words in a command line that are looked at
+#define CONSOLE_MAX_WORDS 4
+
+// Replies waiting to be sent; must be a power of two
+#define CONSOLE_OUTPUT_SIZE 1024
+#define CONSOLE_OUTPUT_MASK (CONSOLE_OUTPUT_SIZE - 1)
+
+
+//
+// Serial command console
+//
+// A line-oriented console on the serial port, for looking at the state of the
+// machine and changing a few things at runtime.  Everything happens in the
+// background loop: service() takes whatever has arrived in the receive FIFO,
+// echoes it, and runs at most one complete command per call.  Replies are
+// queued and sent by send() as the serial port has room, so nothing here ever
+// waits on the port, and the ISR only ever sees the settings it already reads.
+// The self-test reads the EEPROM one page per call, and only while no write is
+// queued, so it doesn't wait on the chip either.
+//
+// Type "help" for the list of commands.
+//
+class Console
+{
+private:
+    SerialPort *serialPort;
+    Core *core;
+    StepperDrive *stepperDrive;
+    Monitor *monitor;
+    Trace *trace;                   // NULL without USE_TRACE
+    Display *display;
+    EEPROM *eeprom;
+    EEPROMCache *eepromCache;
+    FeedTableFactory *feedTableFactory;
+    Telemetry *telemetry;           // NULL without USE_TELEMETRY
+
+    // line being typed, and whether it's complete
+    char line[CONSOLE_LINE_LENGTH];
+    Uint16 lineLength;
+    bool lineReady;
+    bool lineTooLong;
+    Uint16 lastReceived;
+
+    // queued replies
+    char *output;
+    Uint16 outputHead;
+    Uint16 outputTail;
+
+    // self-test in progress: the next EEPROM page to check, and whether every
+    // page so far has read back the same
+    bool testing;
+    Uint16 testPage;
+    bool testSame;
+
+    void receive(Uint16 c);
+    void execute(void);
+
+    void print(const char *text);
+    void printNumber(int32 value, Uint16 decimals);
+    void printPercent(Uint16 tenths);
+    void printOnOff(bool on);
+    void printLimit(const char *name, bool enabled, int32 position);
+    void report(const char *name, bool pass);
+
+    void commandHelp(void);
+    void commandStatus(void);
+    void commandGet(Uint16 count, char **words);
+    void commandSet(Uint16 count, char **words);
+    void commandLimit(Uint16 count, char **words);
+#ifdef USE_TRACE
+    void commandTrace(Uint16 count, char **words);
+#endif
+    void commandTest(void);
+    bool continueTest(void);
+
+    int16 findSetting(const char *name);
+    int32 getSetting(Uint16 setting);
+    bool setSetting(Uint16 setting, int32 value);
+
+public:
+    Console(SerialPort *serialPort, Core *core, StepperDrive *stepperDrive, Monitor *monitor,
+            Trace *trace, Display *display, EEPROM *eeprom, EEPROMCache *eepromCache,
+            FeedTableFactory *feedTableFactory, Telemetry *telemetry);
+
+    // read what has arrived and run at most one command; returns true if a
+    // command ran.  Call from the background loop.
+    bool service(void);
+
+    // true while there are replies waiting to be sent
+    bool hasOutput(void);
+
+    // send queued replies as far as the serial port will take
+    void send(void);
+};
+
+
+inline bool Console :: hasOutput(void)
+{
+    return this->outputHead != this->outputTail;
+}
+
+
+#endif // __CONSOLE_H
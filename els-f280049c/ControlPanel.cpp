@@ -25,16 +25,24 @@
 
 
 #include "ControlPanel.h"
+#include "Configuration.h"
 
 // Time delay to allow CS (STB) line to reach high state and be registered
 #define CS_RISE_TIME_US 10
 
+// Number of refreshes between unconditional rewrites of the display
+#define FULL_REFRESH_INTERVAL 100
+
+// Display layouts
+#define LAYOUT_NORMAL 0     // RPM and value
+#define LAYOUT_READOUT 1    // readout
+#define LAYOUT_MESSAGE 2    // message
+
+#define ALL_FIELDS ((1 << DISPLAY_FIELD_COUNT) - 1)
+
 // Time delay after sending read command, before clocking in data
 #define DELAY_BEFORE_READING_US 3
 
-// Number of times a key state must be read consecutively to be considered stable
-#define MIN_CONSECUTIVE_READS 3
-
 
 // Lower the TM1638 CS (STB) line
 #define CS_ASSERT GpioDataRegs.GPBCLEAR.bit.GPIO33 = 1
@@ -46,14 +54,15 @@
 ControlPanel :: ControlPanel(SPIBus *spiBus)
 {
     this->spiBus = spiBus;
-    this->rpm = 0;
-    this->value = NULL;
-    this->leds.all = 0;
     this->keys.all = 0;
-    this->stableKeys.all = 0;
-    this->stableCount = 0;
-    this->message = NULL;
-    this->brightness = 3;
+    this->candidateKeys.all = 0;
+    this->candidateTime = 0;
+    this->shownLayout = LAYOUT_NORMAL;
+    this->shownMessage = NULL;
+    this->shownLeds.all = 0;
+    this->shownBrightness = 0;
+    this->refreshCount = 0;
+    this->dirty = ALL_FIELDS;
 }
 
 void ControlPanel :: initHardware(void)
@@ -135,13 +144,37 @@ Uint16 ControlPanel :: lcd_char(Uint16 x)
     return table[sizeof(table)-1];
 }
 
+Uint16 ControlPanel :: segmentsFor(char c)
+{
+    static const Uint16 letters[] = {
+        LETTER_A, LETTER_B, LETTER_C, LETTER_D, LETTER_E, LETTER_F, LETTER_G,
+        LETTER_H, LETTER_I, LETTER_J, LETTER_K, LETTER_L, LETTER_M, LETTER_N,
+        LETTER_O, LETTER_P, LETTER_Q, LETTER_R, LETTER_S, LETTER_T, LETTER_U,
+        LETTER_V, LETTER_W, LETTER_X, LETTER_Y, LETTER_Z
+    };
+
+    if( c >= '0' && c <= '9' ) {
+        return lcd_char(c - '0');
+    }
+    if( c >= 'A' && c <= 'Z' ) {
+        return letters[c - 'A'];
+    }
+    if( c >= 'a' && c <= 'z' ) {
+        return letters[c - 'a'];
+    }
+    if( c == '-' ) {
+        return DASH;
+    }
+    return BLANK;
+}
+
 void ControlPanel :: sendData()
 {
     int i;
-    Uint16 ledMask = this->leds.all;
+    Uint16 ledMask = this->shownLeds.all;
     Uint16 briteVal = 0x80;
-    if( this->brightness > 0 ) {
-        briteVal = 0x87 + this->brightness;
+    if( this->shownBrightness > 0 ) {
+        briteVal = 0x87 + this->shownBrightness;
     }
 
     SpibRegs.SPICTL.bit.TALK = 1;
@@ -159,14 +192,7 @@ void ControlPanel :: sendData()
     CS_ASSERT;
     spiBus->sendWord(reverse_byte(0xc0));           // display data
     for( i=0; i < 8; i++ ) {
-        if( this->message != NULL )
-        {
-            spiBus->sendWord(this->message[i]);
-        }
-        else
-        {
-            spiBus->sendWord(this->sevenSegmentData[i]);
-        }
+        spiBus->sendWord(this->sevenSegmentData[i]);
         spiBus->sendWord( (ledMask & 0x80) ? 0xff00 : 0x0000 );
         ledMask <<= 1;
     }
@@ -176,40 +202,47 @@ void ControlPanel :: sendData()
     SpibRegs.SPICTL.bit.TALK = 0;
 }
 
-void ControlPanel :: decomposeRPM()
+void ControlPanel :: decomposeText(const char *text, Uint16 *segments, Uint16 count)
 {
-    Uint16 rpm = this->rpm;
-    int i;
+    Uint16 i = 0;
+    bool canTakePoint = false;
 
-    for(i=3; i>=0; i--) {
-        this->sevenSegmentData[i] = (rpm == 0 && i != 3) ? 0 : lcd_char(rpm % 10);
-        rpm = rpm / 10;
-    }
-}
-
-void ControlPanel :: decomposeValue()
-{
-    if( this->value != NULL )
+    if( text != NULL )
     {
-        int i;
-        for( i=0; i < 4; i++ )
+        for( ; *text != '\0'; text++ )
         {
-            this->sevenSegmentData[i+4] = this->value[i];
+            if( *text == '.' && canTakePoint )
+            {
+                // a decimal point shares the previous character's digit
+                segments[i-1] |= POINT;
+                canTakePoint = false;
+            }
+            else
+            {
+                if( i >= count ) break;
+
+                segments[i] = (*text == '.') ? POINT : segmentsFor(*text);
+                canTakePoint = (*text != ' ' && *text != '.');
+                i++;
+            }
         }
     }
+
+    // blank any unused digits
+    for( ; i < count; i++ )
+    {
+        segments[i] = BLANK;
+    }
 }
 
 KEY_REG ControlPanel :: readKeys(void)
 {
     SpibRegs.SPICTL.bit.TALK = 1;
 
+    // the read command is a complete data command on its own, so there is no
+    // need to set the address mode first
     CS_ASSERT;
-    spiBus->sendWord(reverse_byte(0x40));           // auto-increment
-    CS_RELEASE;
-    DELAY_US(CS_RISE_TIME_US);              // give CS line time to register high
-
-    CS_ASSERT;
-    spiBus->sendWord(reverse_byte(0x42));
+    spiBus->sendWord(reverse_byte(0x42));           // read key scan data
 
     SpibRegs.SPICTL.bit.TALK = 0;
 
@@ -233,27 +266,22 @@ KEY_REG ControlPanel :: readKeys(void)
     return keyMask;
 }
 
-KEY_REG ControlPanel :: getKeys()
+KEY_REG ControlPanel :: getKeyState(Uint32 now)
 {
     KEY_REG newKeys;
-    static KEY_REG noKeys;
 
     configureSpiBus();
 
     newKeys = readKeys();
-    if( isValidKeyState(newKeys) && isStable(newKeys) && newKeys.all != this->keys.all ) {
-        KEY_REG previousKeys = this->keys; // remember the previous stable value
+    if( isValidKeyState(newKeys) && isStable(newKeys, now) ) {
         this->keys = newKeys;
-
-        if( previousKeys.all == 0 ) {     // only act if the previous stable value was no keys pressed
-            return newKeys;
-        }
     }
-    return noKeys;
+    return this->keys;
 }
 
 bool ControlPanel :: isValidKeyState(KEY_REG testKeys) {
-    // filter out any states with multiple keys pressed (bad communication filter)
+    // filter out any states with multiple keys pressed, other than the chords
+    // (bad communication filter)
     switch(testKeys.all) {
     case 0:
     case 1 << 0:
@@ -264,54 +292,104 @@ bool ControlPanel :: isValidKeyState(KEY_REG testKeys) {
     case 1 << 6:
     case 1 << 7:
         return true;
+
+    // SET chords for the favorites
+    case 1 << 6 | 1 << 0:
+    case 1 << 6 | 1 << 2:
+    case 1 << 6 | 1 << 3:
+    case 1 << 6 | 1 << 4:
+        return true;
     }
 
     return false;
 }
 
 
-bool ControlPanel :: isStable(KEY_REG testKeys) {
-    // don't trust any read key state until we've seen it multiple times consecutively (noise filter)
-    if( testKeys.all != stableKeys.all )
+bool ControlPanel :: isStable(KEY_REG testKeys, Uint32 now) {
+    // don't trust any read key state until it has held steady for the debounce
+    // time (noise filter)
+    if( testKeys.all != candidateKeys.all )
     {
-        this->stableKeys = testKeys;
-        this->stableCount = 1;
+        this->candidateKeys = testKeys;
+        this->candidateTime = now;
     }
-    else
-    {
-        if( this->stableCount < MIN_CONSECUTIVE_READS )
-        {
-            this->stableCount++;
-        }
-    }
-
-    return this->stableCount >= MIN_CONSECUTIVE_READS;
-}
-
-void ControlPanel :: setMessage( const Uint16 *message )
-{
-    this->message = message;
-}
-
-void ControlPanel :: setBrightness( Uint16 brightness )
-{
-    if( brightness > 8 ) brightness = 8;
 
-    this->brightness = brightness;
+    return now - this->candidateTime >= KEY_DEBOUNCE_MS;
 }
 
 void ControlPanel :: refresh()
 {
-    configureSpiBus();
-
-    decomposeRPM();
-    decomposeValue();
+    Uint16 layout;
+    bool changed = false;
 
-    sendData();
-}
+    if( this->message != NULL )
+    {
+        layout = LAYOUT_MESSAGE;
+    }
+    else if( getText(DISPLAY_FIELD_READOUT) != NULL )
+    {
+        layout = LAYOUT_READOUT;
+    }
+    else
+    {
+        layout = LAYOUT_NORMAL;
+    }
 
+    // a different layout or message means every digit must be re-rendered
+    if( layout != this->shownLayout || this->message != this->shownMessage )
+    {
+        this->shownLayout = layout;
+        this->shownMessage = this->message;
+        this->dirty = ALL_FIELDS;
+        changed = true;
+    }
 
+    // convert only the fields that changed to segments
+    switch( layout )
+    {
+    case LAYOUT_MESSAGE:
+        if( changed )
+        {
+            decomposeText(this->message, this->sevenSegmentData, 8);
+        }
+        break;
 
+    case LAYOUT_READOUT:
+        if( this->dirty & (1 << DISPLAY_FIELD_READOUT) )
+        {
+            decomposeText(getText(DISPLAY_FIELD_READOUT), this->sevenSegmentData, 8);
+            changed = true;
+        }
+        break;
 
+    case LAYOUT_NORMAL:
+        if( this->dirty & (1 << DISPLAY_FIELD_RPM) )
+        {
+            decomposeText(getText(DISPLAY_FIELD_RPM), this->sevenSegmentData, 4);
+            changed = true;
+        }
+        if( this->dirty & (1 << DISPLAY_FIELD_VALUE) )
+        {
+            decomposeText(getText(DISPLAY_FIELD_VALUE), &this->sevenSegmentData[4], 4);
+            changed = true;
+        }
+        break;
+    }
+    this->dirty = 0;
 
+    if( this->leds.all != this->shownLeds.all || this->brightness != this->shownBrightness )
+    {
+        this->shownLeds = this->leds;
+        this->shownBrightness = this->brightness;
+        changed = true;
+    }
 
+    // only talk to the hardware when something changed, but rewrite it
+    // periodically anyway in case it was upset by noise
+    if( changed || ++this->refreshCount >= FULL_REFRESH_INTERVAL )
+    {
+        configureSpiBus();
+        sendData();
+        this->refreshCount = 0;
+    }
+}
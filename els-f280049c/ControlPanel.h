@@ -29,6 +29,7 @@
 
 #include "F28x_Project.h"
 #include "SPIBus.h"
+#include "Display.h"
 
 
 #define ZERO    0b1111110000000000 // 0
@@ -73,33 +74,6 @@
 
 #define DASH 0b0000001000000000
 
-#define LED_TPI 1
-#define LED_INCH (1<<1)
-#define LED_MM (1<<2)
-#define LED_THREAD (1<<3)
-#define LED_FEED (1<<4)
-#define LED_REVERSE (1<<5)
-#define LED_FORWARD (1<<6)
-#define LED_POWER (1<<7)
-
-struct LED_BITS
-{
-    Uint16 TPI:1;
-    Uint16 INCH:1;
-    Uint16 MM:1;
-    Uint16 THREAD:1;
-    Uint16 FEED:1;
-    Uint16 REVERSE:1;
-    Uint16 FORWARD:1;
-    Uint16 POWER:1;
-};
-
-typedef union LED_REG
-{
-    Uint16 all;
-    struct LED_BITS bit;
-} LED_REG;
-
 struct KEY_BITS
 {
     Uint16 UP:1;
@@ -119,44 +93,43 @@ typedef union KEY_REG
 } KEY_REG;
 
 
-class ControlPanel
+//
+// TM1638 "LED&KEY" control panel
+//
+// Eight seven-segment digits, eight LEDs and eight keys on one board.  The
+// display text is converted to segment patterns here; the keys are read by the
+// Keypad.
+//
+class ControlPanel : public Display
 {
 private:
     // Common SPI Bus
     SPIBus *spiBus;
 
-    // Current RPM value; 4 decimal digits
-    Uint16 rpm;
-
-    // Current displayed setting value, 4 digits
-    const Uint16 *value;
-
-    // Current LED states
-    LED_REG leds;
-
     // current key states
     KEY_REG keys;
 
-    // number of times current key state has been seen
-    KEY_REG stableKeys;
-    Uint16 stableCount;
-
-    // current override message, or NULL if none
-    const Uint16 *message;
-
-    // brightness, levels 1-8, 0=off
-    Uint16 brightness;
+    // candidate key state, and when it was first seen
+    KEY_REG candidateKeys;
+    Uint32 candidateTime;
 
     // Derived state, calculated internally
     Uint16 sevenSegmentData[8];
 
+    // What was last rendered, so unchanged fields can be skipped
+    Uint16 shownLayout;
+    const char *shownMessage;
+    LED_REG shownLeds;
+    Uint16 shownBrightness;
+    Uint16 refreshCount;
+
     // dummy register, for SPI
     Uint16 dummy;
 
-    void decomposeRPM(void);
-    void decomposeValue(void);
+    void decomposeText(const char *text, Uint16 *segments, Uint16 count);
     KEY_REG readKeys(void);
     Uint16 lcd_char(Uint16 x);
+    Uint16 segmentsFor(char c);
     void sendByte(Uint16 data);
     Uint16 receiveByte(void);
     void sendData(void);
@@ -164,7 +137,7 @@ private:
     void initSpi();
     void configureSpiBus(void);
     bool isValidKeyState(KEY_REG);
-    bool isStable(KEY_REG);
+    bool isStable(KEY_REG, Uint32 now);
 
 public:
     ControlPanel(SPIBus *spiBus);
@@ -172,43 +145,13 @@ public:
     // initialize the hardware for operation
     void initHardware(void);
 
-    // poll the keys and return a mask
-    KEY_REG getKeys(void);
-
-    // set the RPM value to display
-    void setRPM(Uint16 rpm);
-
-    // set the value to display
-    void setValue(const Uint16 *value);
-
-    // set the LED states
-    void setLEDs(LED_REG leds);
-
-    // set a message that overrides the display, 8 characters required
-    void setMessage(const Uint16 *message);
-
-    // set a brightness value, 0 (off) to 8 (max)
-    void setBrightness(Uint16 brightness);
+    // poll the keys and return the current debounced key state; the
+    // current time, in milliseconds, is used for debouncing
+    KEY_REG getKeyState(Uint32 now);
 
     // refresh the hardware display
     void refresh(void);
 };
 
 
-inline void ControlPanel :: setRPM(Uint16 rpm)
-{
-    this->rpm = rpm;
-}
-
-inline void ControlPanel :: setValue(const Uint16 *value)
-{
-    this->value = value;
-}
-
-inline void ControlPanel :: setLEDs(LED_REG leds)
-{
-    this->leds = leds;
-}
-
-
 #endif // __CONTROL_PANEL_H
@@ -34,27 +34,128 @@ Core :: Core( Encoder *encoder, StepperDrive *stepperDrive )
     this->encoder = encoder;
     this->stepperDrive = stepperDrive;
 
-    this->feed = NULL;
-    this->feedDirection = 0;
+    this->pending.feed = NULL;
+    this->pending.feedDirection = 0;
+    this->pending.generation = 0;
+    this->pendingChanged = false;
+
+    for( Uint16 i = 0; i < 2; i++ )
+    {
+        this->parameters[i].feed = NULL;
+        this->parameters[i].feedDirection = 0;
+        this->parameters[i].generation = 0;
+    }
+    this->active = 0;
+
+    this->pendingWrap.steps = 0;
+    this->pendingWrap.remainder = 0;
+    this->pendingWrap.denominator = 1;
+    for( Uint16 i = 0; i < 2; i++ )
+    {
+        this->wrapTravel[i].steps = 0;
+        this->wrapTravel[i].remainder = 0;
+        this->wrapTravel[i].denominator = 1;
+    }
+    this->wrap = this->pendingWrap;
+    this->wrapFraction = 0;
+
+    this->previous.feed = NULL;
+    this->previous.feedDirection = 0;
+    this->previous.generation = 0;
 
     this->previousSpindlePosition = 0;
-    this->previousFeedDirection = 0;
-    this->previousFeed = NULL;
+    this->spindleIdleTicks = SPINDLE_IDLE_TICKS;
+
+    this->ramping = false;
+    this->rampFrom = this->previous;
+    this->rampTravel = 0;
 
     this->powerOn = true; // default to power on
 }
 
+void Core :: setFeed(const FEED_THREAD *feed)
+{
+#ifdef USE_FLOATING_POINT
+    this->pending.feed = (float)feed->numerator / feed->denominator;
+#else
+    this->pending.feed = feed;
+#endif // USE_FLOATING_POINT
+
+    // travel for a whole turn of the count, straight from the table fraction
+    Uint64 travel = ((Uint64)encoder->getMaxCount() + 1) * feed->numerator;
+    this->pendingWrap.steps = travel / feed->denominator;
+    this->pendingWrap.remainder = travel % feed->denominator;
+    this->pendingWrap.denominator = feed->denominator;
+
+    this->pendingChanged = true;
+}
+
 void Core :: setReverse(bool reverse)
 {
     if( reverse )
     {
-        this->feedDirection = -1;
+        this->pending.feedDirection = -1;
     }
     else
     {
-        this->feedDirection = 1;
+        this->pending.feedDirection = 1;
+    }
+    this->pendingChanged = true;
+}
+
+void Core :: publish(void)
+{
+    if( ! this->pendingChanged )
+    {
+        return;
+    }
+
+    // never hand out zero, which means nothing has been published
+    if( ++this->pending.generation == 0 )
+    {
+        this->pending.generation++;
+    }
+
+    // the ISR only reads the active buffer, and runs to completion before the
+    // background loop continues, so the other one is free to fill
+    Uint16 next = 1 - this->active;
+    this->parameters[next].feed = this->pending.feed;
+    this->parameters[next].feedDirection = this->pending.feedDirection;
+    this->parameters[next].generation = this->pending.generation;
+    this->wrapTravel[next].steps = this->pendingWrap.steps;
+    this->wrapTravel[next].remainder = this->pendingWrap.remainder;
+    this->wrapTravel[next].denominator = this->pendingWrap.denominator;
+    this->active = next;
+
+    this->pendingChanged = false;
+}
+
+#ifdef USE_FLOATING_POINT
+bool Core :: isFeedInUse(const FEED_THREAD *)
+{
+    // the ISR works from its own copy of the ratio
+    return false;
+}
+#else
+bool Core :: isFeedInUse(const FEED_THREAD *feed)
+{
+    // only the background loop switches buffers, and publish() overwrites the
+    // one the ISR isn't using
+    if( this->pending.feed == feed || this->parameters[this->active].feed == feed )
+    {
+        return true;
+    }
+
+    // the ISR only takes up a feed from the active buffer and passes it on to
+    // previous and then to the ramp, so checking in that order can't miss one
+    // that moves while we look
+    if( this->previous.feed == feed )
+    {
+        return true;
     }
+    return this->ramping && this->rampFrom.feed == feed;
 }
+#endif // USE_FLOATING_POINT
 
 void Core :: setPowerOn(bool powerOn)
 {
@@ -29,56 +29,133 @@
 
 #include "StepperDrive.h"
 #include "Encoder.h"
-#include "ControlPanel.h"
 #include "Tables.h"
 
 
-class Core
-{
-private:
-    Encoder *encoder;
-    StepperDrive *stepperDrive;
+// ticks without an encoder count before the spindle is taken to be stopped
+#define SPINDLE_IDLE_TICKS (10000 / STEPPER_CYCLE_US)
 
+// 1/(2 * FEED_RAMP_COUNTS) as a 0.32 fraction
+#define FEED_RAMP_RECIPROCAL ((Uint32)(4294967296ULL / (2 * FEED_RAMP_COUNTS)))
+
+// Everything the ISR needs to turn spindle position into steps
+typedef struct CORE_PARAMETERS
+{
 #ifdef USE_FLOATING_POINT
     float feed;
-    float previousFeed;
 #else
     const FEED_THREAD *feed;
-    const FEED_THREAD *previousFeed;
 #endif // USE_FLOATING_POINT
 
     int16 feedDirection;
-    int16 previousFeedDirection;
+
+    // changes with every published set; zero until the first
+    Uint16 generation;
+} CORE_PARAMETERS;
+
+// Carriage travel for one full turn of the encoder count, (maxCount + 1) *
+// ratio, as whole steps and a fraction remainder/denominator.  The fraction is
+// carried from wrap to wrap, so any number of wraps add up exactly.
+typedef struct WRAP_TRAVEL
+{
+    Uint32 steps;
+    Uint64 remainder;
+    Uint64 denominator;
+} WRAP_TRAVEL;
+
+
+//
+// Core engine
+//
+// The feed and direction are handed to the ISR as one parameter block.
+// setFeed() and setReverse() only change a pending copy; publish() writes it
+// to whichever of two buffers the ISR isn't using and then switches the ISR
+// over with a single store.  The ISR can't be interrupted by the background
+// loop, so it always sees one complete set, picked up at the start of a tick,
+// and a feed and direction changed together take effect together.
+//
+// A change never moves the carriage.  The ISR re-bases the step count on the
+// new ratio at the current spindle position, keeping any buffered steps, and
+// if the spindle is turning it blends from the old ratio to the new one over
+// FEED_RAMP_COUNTS of spindle travel, so the carriage speed changes at a
+// bounded rate.  A change in the middle of a ramp starts a new one from the
+// ratio that ramp was heading for.
+//
+// When the encoder count wraps, the step count is shifted by the exact travel
+// of a whole turn of the count, taken from the table fraction rather than the
+// (possibly floating-point) ratio, so long runs don't drift.
+//
+class Core
+{
+private:
+    Encoder *encoder;
+    StepperDrive *stepperDrive;
+
+    // parameters being prepared by the background loop
+    CORE_PARAMETERS pending;
+    bool pendingChanged;
+
+    // published parameters, and which buffer the ISR should use; volatile so
+    // the buffer is always filled before the switch
+    volatile CORE_PARAMETERS parameters[2];
+    volatile Uint16 active;
+
+    // wrap travel to go with each of the buffers above; only read when the
+    // ISR takes up a new set
+    WRAP_TRAVEL pendingWrap;
+    volatile WRAP_TRAVEL wrapTravel[2];
+
+    // wrap travel of the parameters in use, and the fraction of a step
+    // carried, in 1/denominator steps
+    WRAP_TRAVEL wrap;
+    Uint64 wrapFraction;
+
+    // parameters used on the previous tick
+    CORE_PARAMETERS previous;
 
     Uint32 previousSpindlePosition;
+    Uint16 spindleIdleTicks;
 
-    int32 feedRatio(Uint32 count);
+    // feed change ramp: the outgoing parameters and spindle travel since
+    bool ramping;
+    CORE_PARAMETERS rampFrom;
+    int32 rampTravel;
+
+    int32 feedRatio(const CORE_PARAMETERS *parameters, Uint32 count);
+    int32 rampCorrection(const CORE_PARAMETERS *parameters, int32 travel);
+    void changeParameters(const CORE_PARAMETERS *parameters, Uint32 spindlePosition);
+    void takeWrapTravel(const volatile WRAP_TRAVEL *travel);
+    int32 wrapForward(void);
+    int32 wrapBackward(void);
 
     bool powerOn;
 
 public:
     Core( Encoder *encoder, StepperDrive *stepperDrive );
 
+    // change the pending parameters; nothing reaches the ISR until publish()
     void setFeed(const FEED_THREAD *feed);
     void setReverse(bool reverse);
+
+    // hand any pending changes to the ISR, all at once
+    void publish(void);
+
+    // might the ISR still read this feed, now or later?  A feed that isn't in
+    // use may be rewritten and passed to setFeed() again.
+    bool isFeedInUse(const FEED_THREAD *feed);
+
     Uint16 getRPM(void);
     bool isAlarm();
 
     bool isPowerOn();
     void setPowerOn(bool);
 
+    // generation of the parameters the ISR used last; call from the ISR
+    Uint16 getGeneration(void);
+
     void ISR( void );
 };
 
-inline void Core :: setFeed(const FEED_THREAD *feed)
-{
-#ifdef USE_FLOATING_POINT
-    this->feed = (float)feed->numerator / feed->denominator;
-#else
-    this->feed = feed;
-#endif // USE_FLOATING_POINT
-}
-
 inline Uint16 Core :: getRPM(void)
 {
     return encoder->getRPM();
@@ -94,42 +171,175 @@ inline bool Core :: isPowerOn()
     return this->powerOn;
 }
 
-inline int32 Core :: feedRatio(Uint32 count)
+inline Uint16 Core :: getGeneration(void)
+{
+    return this->previous.generation;
+}
+
+inline int32 Core :: feedRatio(const CORE_PARAMETERS *parameters, Uint32 count)
 {
 #ifdef USE_FLOATING_POINT
-    return ((float)count) * this->feed * feedDirection;
+    return ((float)count) * parameters->feed * parameters->feedDirection;
 #else // USE_FLOATING_POINT
-    return ((long long)count) * feed->numerator / feed->denominator * feedDirection;
+    const FEED_THREAD *feed = parameters->feed;
+    if( feed->fits32 )
+    {
+        // split the multiply so nothing overflows 32 bits
+        Uint32 numerator = feed->numerator;
+        Uint32 denominator = feed->denominator;
+        Uint32 whole = count / denominator;
+        Uint32 remainder = count - whole * denominator;
+        return (int32)(whole * numerator + remainder * numerator / denominator) * parameters->feedDirection;
+    }
+    return ((long long)count) * feed->numerator / feed->denominator * parameters->feedDirection;
 #endif // USE_FLOATING_POINT
 }
 
+inline int32 Core :: rampCorrection(const CORE_PARAMETERS *parameters, int32 travel)
+{
+    // how much further the outgoing ratio would have moved the carriage
+    Uint32 distance = (travel < 0) ? -travel : travel;
+    int32 difference = feedRatio(&this->rampFrom, distance) - feedRatio(parameters, distance);
+
+    // with the ratio changing evenly, difference * (1 - distance/2L) of that
+    // is still owed to the outgoing ratio
+    Uint32 fraction = distance * FEED_RAMP_RECIPROCAL;
+    int32 correction = difference - (int32)(((int64)difference * fraction) >> 32);
+
+    return (travel < 0) ? -correction : correction;
+}
+
+inline void Core :: takeWrapTravel(const volatile WRAP_TRAVEL *travel)
+{
+    this->wrap.steps = travel->steps;
+    this->wrap.remainder = travel->remainder;
+    this->wrap.denominator = travel->denominator;
+    this->wrapFraction = 0;
+}
+
+inline int32 Core :: wrapForward(void)
+{
+    int32 steps = this->wrap.steps;
+    this->wrapFraction += this->wrap.remainder;
+    if( this->wrapFraction >= this->wrap.denominator ) {
+        this->wrapFraction -= this->wrap.denominator;
+        steps++;
+    }
+    return steps;
+}
+
+inline int32 Core :: wrapBackward(void)
+{
+    int32 steps = this->wrap.steps;
+    if( this->wrapFraction < this->wrap.remainder ) {
+        this->wrapFraction += this->wrap.denominator;
+        steps++;
+    }
+    this->wrapFraction -= this->wrap.remainder;
+    return steps;
+}
+
+inline void Core :: changeParameters(const CORE_PARAMETERS *parameters, Uint32 spindlePosition)
+{
+    // where the outgoing parameters put the carriage right now
+    int32 outgoing = feedRatio(&this->previous, spindlePosition);
+    if( this->ramping ) {
+        outgoing += rampCorrection(&this->previous, this->rampTravel);
+    }
+
+    // re-base on the new ratio without moving the carriage or dropping any
+    // buffered steps
+    stepperDrive->incrementCurrentPosition(feedRatio(parameters, spindlePosition) - outgoing);
+
+    // if the spindle is turning, ease over to the new ratio from here
+    this->ramping = this->spindleIdleTicks < SPINDLE_IDLE_TICKS;
+    this->rampFrom = this->previous;
+    this->rampTravel = 0;
+}
+
 inline void Core :: ISR( void )
 {
-    if( this->feed != NULL ) {
+    // pick up the parameters once, so the whole tick uses the same set
+    Uint16 index = this->active;
+    const volatile CORE_PARAMETERS *published = &this->parameters[index];
+    CORE_PARAMETERS current;
+    current.feed = published->feed;
+    current.feedDirection = published->feedDirection;
+    current.generation = published->generation;
+    const CORE_PARAMETERS *parameters = &current;
+
+    if( parameters->generation != 0 ) {
         // read the encoder
         Uint32 spindlePosition = encoder->getPosition();
 
+        // spindle travel since the last tick, through any wrap of the count
+        Uint32 maxCount = encoder->getMaxCount();
+        int32 travel = spindlePosition - previousSpindlePosition;
+        bool wrapped = false;
+        if( travel > (int32)(maxCount/2) ) {
+            travel -= maxCount + 1;
+            wrapped = true;
+        }
+        else if( travel < -(int32)(maxCount/2) ) {
+            travel += maxCount + 1;
+            wrapped = true;
+        }
+
+        if( travel != 0 ) {
+            spindleIdleTicks = 0;
+        }
+        else if( spindleIdleTicks < SPINDLE_IDLE_TICKS ) {
+            spindleIdleTicks++;
+        }
+
+        // advance any feed change ramp, folding what's left of it into the
+        // position once the new ratio has fully taken over
+        if( ramping ) {
+            rampTravel += travel;
+            if( rampTravel >= FEED_RAMP_COUNTS || rampTravel <= -FEED_RAMP_COUNTS ) {
+                int32 end = (rampTravel < 0) ? -FEED_RAMP_COUNTS : FEED_RAMP_COUNTS;
+                stepperDrive->incrementCurrentPosition(-rampCorrection(&previous, end));
+                ramping = false;
+            }
+        }
+
+        // if the feed or direction changed, carry on from where the carriage is
+        if( parameters->generation != previous.generation && previous.generation != 0 ) {
+            if( wrapped ) {
+                // compensate the wrap with the ratio that produced it and take
+                // the change on the next tick
+                current = previous;
+            }
+            else {
+                changeParameters(parameters, spindlePosition);
+                takeWrapTravel(&this->wrapTravel[index]);
+            }
+        }
+
         // calculate the desired stepper position
-        int32 desiredSteps = feedRatio(spindlePosition);
+        int32 desiredSteps = feedRatio(parameters, spindlePosition);
+        if( ramping ) {
+            desiredSteps += rampCorrection(parameters, rampTravel);
+        }
         stepperDrive->setDesiredPosition(desiredSteps);
 
         // compensate for encoder overflow/underflow
         if( spindlePosition < previousSpindlePosition && previousSpindlePosition - spindlePosition > encoder->getMaxCount()/2 ) {
-            stepperDrive->incrementCurrentPosition(-1 * feedRatio(encoder->getMaxCount()));
+            stepperDrive->incrementCurrentPosition(-wrapForward() * parameters->feedDirection);
         }
         if( spindlePosition > previousSpindlePosition && spindlePosition - previousSpindlePosition > encoder->getMaxCount()/2 ) {
-            stepperDrive->incrementCurrentPosition(feedRatio(encoder->getMaxCount()));
+            stepperDrive->incrementCurrentPosition(wrapBackward() * parameters->feedDirection);
         }
 
-        // if the feed or direction changed, reset sync to avoid a big step
-        if( feed != previousFeed || feedDirection != previousFeedDirection) {
+        // the very first parameters just sync to wherever the spindle is
+        if( previous.generation == 0 ) {
             stepperDrive->setCurrentPosition(desiredSteps);
+            takeWrapTravel(&this->wrapTravel[index]);
         }
 
         // remember values for next time
         previousSpindlePosition = spindlePosition;
-        previousFeedDirection = feedDirection;
-        previousFeed = feed;
+        previous = current;
 
         // service the stepper drive state machine
         stepperDrive->ISR();
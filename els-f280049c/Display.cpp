@@ -0,0 +1,192 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Display.h"
+
+
+// Width of each field, in cells
+static const Uint16 FIELD_WIDTH[DISPLAY_FIELD_COUNT] = { 4, 4, 8 };
+
+// Powers of ten, for number conversion
+static const Uint32 POWERS_OF_TEN[DISPLAY_MAX_DIGITS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+
+Display :: Display(void)
+{
+    for( int i = 0; i < DISPLAY_FIELD_COUNT; i++ )
+    {
+        this->fields[i].text[0] = '\0';
+        this->fields[i].visible = false;
+        this->fields[i].numeric = false;
+        this->fields[i].value = 0;
+        this->fields[i].decimals = 0;
+    }
+    this->dirty = 0;
+    this->message = NULL;
+    this->leds.all = 0;
+    this->brightness = 3;
+}
+
+void Display :: setText(Uint16 field, const char *text)
+{
+    DISPLAY_FIELD *f = &this->fields[field];
+    bool changed;
+    Uint16 i;
+
+    if( text == NULL )
+    {
+        changed = f->visible;
+        f->visible = false;
+    }
+    else
+    {
+        // compare and copy in one pass
+        changed = ! f->visible || f->numeric;
+        for( i = 0; i < DISPLAY_FIELD_LENGTH - 1 && text[i] != '\0'; i++ )
+        {
+            if( f->text[i] != text[i] )
+            {
+                f->text[i] = text[i];
+                changed = true;
+            }
+        }
+        if( f->text[i] != '\0' )
+        {
+            f->text[i] = '\0';
+            changed = true;
+        }
+
+        f->visible = true;
+        f->numeric = false;
+    }
+
+    if( changed )
+    {
+        this->dirty |= 1 << field;
+    }
+}
+
+void Display :: setNumber(Uint16 field, int32 value, Uint16 decimals)
+{
+    DISPLAY_FIELD *f = &this->fields[field];
+
+    // nothing to do if we're already showing this number
+    if( f->visible && f->numeric && f->value == value && f->decimals == decimals )
+    {
+        return;
+    }
+
+    formatNumber(f->text, FIELD_WIDTH[field], value, decimals);
+    f->visible = true;
+    f->numeric = true;
+    f->value = value;
+    f->decimals = decimals;
+
+    this->dirty |= 1 << field;
+}
+
+void Display :: setBrightness( Uint16 brightness )
+{
+    if( brightness > 8 ) brightness = 8;
+
+    this->brightness = brightness;
+}
+
+char *Display :: formatNumber(char *text, Uint16 width, int32 value, Uint16 decimals)
+{
+    char digits[DISPLAY_MAX_DIGITS];
+    bool negative = value < 0;
+    Uint32 magnitude = negative ? -value : value;
+    bool fits = true;
+    char *p = text;
+    Uint16 first = 0;
+    Uint16 i;
+
+    if( width > DISPLAY_MAX_DIGITS ) width = DISPLAY_MAX_DIGITS;
+    if( decimals >= width ) decimals = width - 1;
+
+    if( magnitude >= POWERS_OF_TEN[width] )
+    {
+        fits = false;
+    }
+    else
+    {
+        // convert by subtracting powers of ten; the C28x has no divide
+        // instruction, so this is much cheaper than dividing by ten per digit
+        for( i = 0; i < width; i++ )
+        {
+            Uint32 power = POWERS_OF_TEN[width - 1 - i];
+            char digit = '0';
+            while( magnitude >= power )
+            {
+                magnitude -= power;
+                digit++;
+            }
+            digits[i] = digit;
+        }
+
+        // blank leading zeros, keeping at least one digit before the point
+        while( first + decimals + 1 < width && digits[first] == '0' )
+        {
+            digits[first++] = ' ';
+        }
+
+        if( negative )
+        {
+            if( first > 0 )
+            {
+                digits[first - 1] = '-';
+            }
+            else
+            {
+                fits = false;
+            }
+        }
+    }
+
+    // show dashes instead of a misleading value
+    if( ! fits )
+    {
+        for( i = 0; i < width; i++ )
+        {
+            digits[i] = '-';
+        }
+    }
+
+    for( i = 0; i < width; i++ )
+    {
+        if( decimals > 0 && i == width - decimals )
+        {
+            *p++ = '.';
+        }
+        *p++ = digits[i];
+    }
+    *p = '\0';
+
+    return p;
+}
@@ -0,0 +1,175 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __DISPLAY_H
+#define __DISPLAY_H
+
+#include "F28x_Project.h"
+
+
+#define LED_TPI 1
+#define LED_INCH (1<<1)
+#define LED_MM (1<<2)
+#define LED_THREAD (1<<3)
+#define LED_FEED (1<<4)
+#define LED_REVERSE (1<<5)
+#define LED_FORWARD (1<<6)
+#define LED_POWER (1<<7)
+
+struct LED_BITS
+{
+    Uint16 TPI:1;
+    Uint16 INCH:1;
+    Uint16 MM:1;
+    Uint16 THREAD:1;
+    Uint16 FEED:1;
+    Uint16 REVERSE:1;
+    Uint16 FORWARD:1;
+    Uint16 POWER:1;
+};
+
+typedef union LED_REG
+{
+    Uint16 all;
+    struct LED_BITS bit;
+} LED_REG;
+
+
+// Display fields, laid out on the 8 cells of the original panel
+#define DISPLAY_FIELD_RPM 0         // left 4 cells
+#define DISPLAY_FIELD_VALUE 1       // right 4 cells
+#define DISPLAY_FIELD_READOUT 2     // all 8 cells, replacing the RPM and value
+#define DISPLAY_FIELD_COUNT 3
+
+// Longest field text, including the terminator
+#define DISPLAY_FIELD_LENGTH 12
+
+// Longest number, in digits
+#define DISPLAY_MAX_DIGITS 9
+
+
+typedef struct DISPLAY_FIELD
+{
+    // current text
+    char text[DISPLAY_FIELD_LENGTH];
+
+    // false if the field is not shown
+    bool visible;
+
+    // the number the text was rendered from, if it was
+    bool numeric;
+    int32 value;
+    Uint16 decimals;
+} DISPLAY_FIELD;
+
+
+//
+// Display interface
+//
+// Everything the user interface shows is passed in as text, so it can be
+// rendered on any kind of display.  The text is laid out for the original
+// 8-digit panel: fields and messages are measured in character cells, and a
+// '.' shares the cell of the character before it, the way a seven-segment
+// digit shows its decimal point.  Text displays can simply print the text
+// as-is.
+//
+// Field text is cached, and numbers are only converted to text when they
+// change.  Each field that changed is flagged dirty, so display types can
+// implement refresh() to render only what changed onto their hardware.
+//
+class Display
+{
+protected:
+    // Current field text
+    DISPLAY_FIELD fields[DISPLAY_FIELD_COUNT];
+
+    // Fields changed since the last refresh, one bit per field
+    Uint16 dirty;
+
+    // Current override message, 8 cells, or NULL if none
+    const char *message;
+
+    // Current LED states
+    LED_REG leds;
+
+    // brightness, levels 1-8, 0=off
+    Uint16 brightness;
+
+    // text of a field, or NULL if it is not shown
+    const char *getText(Uint16 field);
+
+public:
+    Display(void);
+
+    // set the text of a field, or NULL to hide it
+    void setText(Uint16 field, const char *text);
+
+    // set a field to a number, right-aligned, with a fixed number of decimals
+    void setNumber(Uint16 field, int32 value, Uint16 decimals);
+
+    // set a message that overrides the display
+    void setMessage(const char *message);
+
+    // set the LED (mode indicator) states
+    void setLEDs(LED_REG leds);
+
+    // set a brightness value, 0 (off) to 8 (max)
+    void setBrightness(Uint16 brightness);
+    Uint16 getBrightness(void);
+
+    // refresh the hardware display
+    virtual void refresh(void) = 0;
+
+    // render a number right-aligned into width cells, with the decimal point
+    // sharing a cell; fills with dashes if it doesn't fit.  Returns a pointer
+    // to the terminator, so numbers can be strung together.
+    static char *formatNumber(char *text, Uint16 width, int32 value, Uint16 decimals);
+};
+
+
+inline Uint16 Display :: getBrightness(void)
+{
+    return this->brightness;
+}
+
+
+inline const char *Display :: getText(Uint16 field)
+{
+    return this->fields[field].visible ? this->fields[field].text : NULL;
+}
+
+inline void Display :: setMessage(const char *message)
+{
+    this->message = message;
+}
+
+inline void Display :: setLEDs(LED_REG leds)
+{
+    this->leds = leds;
+}
+
+
+#endif // __DISPLAY_H
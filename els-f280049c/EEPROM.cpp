@@ -35,9 +35,32 @@
 // enough time for the CS line to rise and be deteted
 #define CS_RISE_TIME_US 5
 
+// Commands common to both chips
+#define COMMAND_WRITE 0b00000010
+#define COMMAND_READ 0b00000011
+#define COMMAND_RDSR 0b00000101
+#define COMMAND_WREN 0b00000110
+
+// Write-in-progress bit of the status register
+#define STATUS_WIP 0b0000000000000001
+
+// Time between status polls while waiting for a write cycle
+#define WRITE_POLL_INTERVAL_US 100
+
 EEPROM :: EEPROM(SPIBus *spiBus)
 {
     this->spiBus = spiBus;
+
+    this->head = 0;
+    this->tail = 0;
+    this->writing = false;
+    this->writeStartTime = 0;
+    this->readAddress = 0;
+
+    this->nextTicket = 1;
+    this->lastFinishedTicket = EEPROM_NO_TICKET;
+    this->failedTickets = 0;
+    this->failureCount = 0;
 }
 
 void EEPROM :: initHardware(void)
@@ -68,12 +91,10 @@ void EEPROM :: configureSpiBus16Bit( void )
 
 Uint16 EEPROM :: readStatusRegister(void)
 {
-    Uint16 command = 0b0000010100000000;
-
     configureSpiBus8Bit();
 
     CS_ASSERT;
-    this->spiBus->sendWord(command);
+    this->spiBus->sendWord(COMMAND_RDSR << 8);
     Uint16 status = this->spiBus->receiveWord();
     CS_RELEASE;
     DELAY_US(CS_RISE_TIME_US);
@@ -83,116 +104,239 @@ Uint16 EEPROM :: readStatusRegister(void)
 
 void EEPROM :: setWriteLatch(void)
 {
-    Uint16 command = 0b0000011000000000;
-
     configureSpiBus8Bit();
 
     CS_ASSERT;
-    this->spiBus->sendWord(command);
+    this->spiBus->sendWord(COMMAND_WREN << 8);
     CS_RELEASE;
     DELAY_US(CS_RISE_TIME_US);
-
 }
 
-void EEPROM :: waitForWriteCycle(void)
+bool EEPROM :: waitForWriteCycle(void)
 {
-    while( readStatusRegister() & 0b0000000000000001 );
+    // give up after the same timeout service() uses, so a missing chip can't
+    // hang the caller
+    for( Uint16 i = 0; i < EEPROM_WRITE_TIMEOUT_MS * (1000 / WRITE_POLL_INTERVAL_US); i++ )
+    {
+        if( (readStatusRegister() & STATUS_WIP) == 0 )
+        {
+            return true;
+        }
+        DELAY_US(WRITE_POLL_INTERVAL_US);
+    }
+    return false;
 }
 
-void EEPROM :: sendReadCommand(Uint16 blockNumber)
+void EEPROM :: sendCommand(Uint16 command, Uint16 wordAddress)
 {
-    Uint16 command = 0b0000001100000000;            // read
-    Uint16 address = blockNumber << 4;
+    Uint16 address = wordAddress << 1;              // byte address
 
-#ifdef EEPROM_CHIP_25AA040A
-    // combine the address with the command
-    command +=
-            (address & 0b0000000011111111) +        // bits 0-7 of address
-            ((address & 0b0000000100000000) << 3);  // bit 8 of address
-
-    // send the command-address
-    configureSpiBus16Bit();
-    this->spiBus->sendWord(command);
-#endif
-
-#ifdef EEPROM_CHIP_AT25080B
-    // send the command
     configureSpiBus8Bit();
-    this->spiBus->sendWord(command);
 
-    // send the address
-    configureSpiBus16Bit();
-    this->spiBus->sendWord(address);
+#ifdef EEPROM_CHIP_25AA040A
+    // bit 8 of the address goes in bit 3 of the command
+    command |= (address & 0b0000000100000000) >> 5;
 #endif
+
+    this->spiBus->sendWord(command << 8);
+    for( Uint16 i = EEPROM_ADDRESS_BYTES; i > 0; i-- ) {
+        this->spiBus->sendWord(((address >> (8 * (i - 1))) & 0xFF) << 8);
+    }
 }
 
-void EEPROM :: sendWriteCommand(Uint16 blockNumber)
+Uint16 EEPROM :: readQueued(Uint16 address, Uint16 word)
 {
-    Uint16 command = 0b0000001000000000;            // write
-    Uint16 address = blockNumber << 4;
+    // later writes to the same word replace earlier ones
+    for( Uint16 i = this->tail; i != this->head; i = (i + 1) % EEPROM_QUEUE_SIZE )
+    {
+        EEPROM_WRITE *write = &this->queue[i];
+
+        if( address >= write->address && address - write->address < write->numWords )
+        {
+            word = write->data[address - write->address];
+        }
+    }
+    return word;
+}
 
-#ifdef EEPROM_CHIP_25AA040A
-    // combine the address with the command
-    command +=
-            (address & 0b0000000011111111) +        // bits 0-7 of address
-            ((address & 0b0000000100000000) << 3);  // bit 8 of address
+void EEPROM :: beginRead(Uint16 address)
+{
+    // the chip ignores reads during a write cycle; the rest of the queue can
+    // wait, as readNext() picks up any data still in it
+    if( this->writing )
+    {
+        finishWrite(waitForWriteCycle());
+    }
+    this->readAddress = address;
 
-    // send the command-address
+    CS_ASSERT;
+    sendCommand(COMMAND_READ, address);
     configureSpiBus16Bit();
-    this->spiBus->sendWord(command);
-#endif
+}
 
-#ifdef EEPROM_CHIP_AT25080B
-    // send the command
-    configureSpiBus8Bit();
-    this->spiBus->sendWord(command);
+void EEPROM :: readNext(Uint16 numWords, Uint16 *buffer)
+{
+    // the chip keeps sending sequential data as long as CS stays low
+    for( Uint16 i = 0; i < numWords; i++ ) {
+        buffer[i] = readQueued(this->readAddress++, this->spiBus->receiveWord());
+    }
+}
 
-    // send the address
-    configureSpiBus16Bit();
-    this->spiBus->sendWord(address);
-#endif
+void EEPROM :: endRead(void)
+{
+    CS_RELEASE;
+    DELAY_US(CS_RISE_TIME_US);
 }
 
-void EEPROM :: receivePage(Uint16 pageSize, Uint16 *buffer)
+void EEPROM :: read(Uint16 address, Uint16 numWords, Uint16 *buffer)
 {
-    configureSpiBus16Bit();
+    beginRead(address);
+    readNext(numWords, buffer);
+    endRead();
+}
 
-    for( Uint16 i=0; i < pageSize; i++ ) {
-        buffer[i] = this->spiBus->receiveWord();
-    }
+Uint16 EEPROM :: queueSpace(void)
+{
+    return (this->tail + EEPROM_QUEUE_SIZE - this->head - 1) % EEPROM_QUEUE_SIZE;
 }
 
-void EEPROM :: sendPage(Uint16 pageSize, Uint16 *buffer)
+Uint16 EEPROM :: write(Uint16 address, Uint16 numWords, const Uint16 *buffer)
 {
-    configureSpiBus16Bit();
+    // number of pages the write touches
+    Uint16 firstPage = address / EEPROM_PAGE_SIZE;
+    Uint16 lastPage = (address + numWords - 1) / EEPROM_PAGE_SIZE;
+
+    if( numWords == 0 || address >= EEPROM_SIZE || numWords > EEPROM_SIZE - address ||
+            lastPage - firstPage + 1 > queueSpace() )
+    {
+        return EEPROM_NO_TICKET;
+    }
 
-    for( Uint16 i=0; i < pageSize; i++ ) {
-        this->spiBus->sendWord(buffer[i]);
+    Uint16 ticket = this->nextTicket;
+    this->failedTickets &= ~(1U << (ticket % EEPROM_STATUS_HISTORY));
+
+    // never hand out the "no ticket" value
+    if( ++this->nextTicket == EEPROM_NO_TICKET )
+    {
+        this->nextTicket++;
+    }
+
+    // split the write on page boundaries, since the chip wraps within a page
+    while( numWords > 0 )
+    {
+        EEPROM_WRITE *write = &this->queue[this->head];
+        Uint16 roomInPage = EEPROM_PAGE_SIZE - address % EEPROM_PAGE_SIZE;
+        Uint16 count = (numWords < roomInPage) ? numWords : roomInPage;
+
+        write->ticket = ticket;
+        write->address = address;
+        write->numWords = count;
+        for( Uint16 i = 0; i < count; i++ )
+        {
+            write->data[i] = buffer[i];
+        }
+
+        address += count;
+        buffer += count;
+        numWords -= count;
+        write->last = (numWords == 0);
+
+        this->head = (this->head + 1) % EEPROM_QUEUE_SIZE;
     }
+
+    return ticket;
 }
 
-bool EEPROM :: readPage(Uint16 pageNum, Uint16 *buffer)
+Uint16 EEPROM :: getStatus(Uint16 ticket)
 {
-    CS_ASSERT;
-    sendReadCommand(pageNum);
-    receivePage(EEPROM_PAGE_SIZE, buffer);
-    CS_RELEASE;
-    DELAY_US(CS_RISE_TIME_US);
-
-    return true;
+    // tickets are handed out in order, and may wrap
+    if( (int16)(ticket - this->lastFinishedTicket) > 0 )
+    {
+        return EEPROM_STATUS_PENDING;
+    }
+    if( (Uint16)(this->nextTicket - ticket) > EEPROM_STATUS_HISTORY )
+    {
+        return EEPROM_STATUS_EXPIRED;
+    }
+    if( this->failedTickets & (1U << (ticket % EEPROM_STATUS_HISTORY)) )
+    {
+        return EEPROM_STATUS_FAILED;
+    }
+    return EEPROM_STATUS_DONE;
 }
 
-bool EEPROM :: writePage(Uint16 pageNum, Uint16 *buffer)
+void EEPROM :: startWrite(void)
 {
+    EEPROM_WRITE *write = &this->queue[this->tail];
+
     setWriteLatch();
 
     CS_ASSERT;
-    sendWriteCommand(pageNum);
-    sendPage(EEPROM_PAGE_SIZE, buffer);
+    sendCommand(COMMAND_WRITE, write->address);
+    configureSpiBus16Bit();
+    for( Uint16 i = 0; i < write->numWords; i++ ) {
+        this->spiBus->sendWord(write->data[i]);
+    }
     CS_RELEASE;
     DELAY_US(CS_RISE_TIME_US);
 
-    waitForWriteCycle();
+    this->writing = true;
+}
+
+void EEPROM :: finishWrite(bool success)
+{
+    EEPROM_WRITE *write = &this->queue[this->tail];
+
+    if( ! success )
+    {
+        this->failedTickets |= 1U << (write->ticket % EEPROM_STATUS_HISTORY);
+        this->failureCount++;
+    }
+
+    // the ticket is finished once all of its pieces are written
+    if( write->last )
+    {
+        this->lastFinishedTicket = write->ticket;
+    }
+
+    this->tail = (this->tail + 1) % EEPROM_QUEUE_SIZE;
+    this->writing = false;
+}
 
-    return true;
+void EEPROM :: service(Uint32 now)
+{
+    if( this->writing )
+    {
+        if( (readStatusRegister() & STATUS_WIP) == 0 )
+        {
+            finishWrite(true);
+        }
+        else if( now - this->writeStartTime >= EEPROM_WRITE_TIMEOUT_MS )
+        {
+            finishWrite(false);
+        }
+        else
+        {
+            // still busy
+            return;
+        }
+    }
+
+    if( this->head != this->tail )
+    {
+        startWrite();
+        this->writeStartTime = now;
+    }
+}
+
+void EEPROM :: flush(void)
+{
+    while( this->head != this->tail )
+    {
+        if( ! this->writing )
+        {
+            startWrite();
+        }
+        finishWrite(waitForWriteCycle());
+    }
 }
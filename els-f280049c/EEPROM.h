@@ -43,22 +43,98 @@
 
 #define EEPROM_PAGE_SIZE 8 // 2-byte words
 
+#ifdef EEPROM_CHIP_25AA040A
+#  define EEPROM_PAGE_COUNT 32 // 512 bytes
+#  define EEPROM_ADDRESS_BYTES 1 // plus address bit 8 in the command byte
+#endif
+#ifdef EEPROM_CHIP_AT25080B
+#  define EEPROM_PAGE_COUNT 64 // 1024 bytes
+#  define EEPROM_ADDRESS_BYTES 2
+#endif
+
+#define EEPROM_SIZE (EEPROM_PAGE_COUNT * EEPROM_PAGE_SIZE) // 2-byte words
+
+// Word address of the start of a page
+#define EEPROM_PAGE_ADDRESS(page) ((page) * EEPROM_PAGE_SIZE)
+
+// Number of page writes that can be queued
+#define EEPROM_QUEUE_SIZE 8
+
+// How often the write engine should be serviced, in milliseconds
+#define EEPROM_SERVICE_INTERVAL_MS 1
+
+// Longest a write cycle may take before it is considered failed; the chips
+// specify 5ms maximum
+#define EEPROM_WRITE_TIMEOUT_MS 20
+
+// Ticket returned when a write could not be queued
+#define EEPROM_NO_TICKET 0
+
+// Write status
+#define EEPROM_STATUS_PENDING 0
+#define EEPROM_STATUS_DONE 1
+#define EEPROM_STATUS_FAILED 2
+#define EEPROM_STATUS_EXPIRED 3     // too old to tell; treat as failed
+
+// Number of most recent tickets whose outcome is remembered
+#define EEPROM_STATUS_HISTORY 16
+
+
+// One write to a single page; a longer write is split into several
+typedef struct EEPROM_WRITE
+{
+    Uint16 ticket;
+    bool last;                      // last piece of the write for this ticket
+    Uint16 address;                 // word address
+    Uint16 numWords;
+    Uint16 data[EEPROM_PAGE_SIZE];
+} EEPROM_WRITE;
+
+
+//
+// SPI EEPROM driver
+//
+// Addresses and lengths are in 16-bit words, stored high byte first.  Writes
+// are queued and carried out by service() in the background, so the caller
+// never waits for a write cycle.  Reads only wait for a write cycle already in
+// progress, and see data still waiting in the queue.
+//
 class EEPROM
 {
 private:
     // Shared SPI bus
     SPIBus *spiBus;
 
+    // queue of page writes; the oldest is the one in progress
+    EEPROM_WRITE queue[EEPROM_QUEUE_SIZE];
+    Uint16 head;
+    Uint16 tail;
+
+    // is the chip busy with the write at the tail of the queue?
+    bool writing;
+    Uint32 writeStartTime;
+
+    // address of the next word of a read in progress
+    Uint16 readAddress;
+
+    // ticket bookkeeping; writes complete in order, so everything up to the
+    // last finished ticket is finished.  One bit per recent ticket, indexed
+    // by ticket modulo EEPROM_STATUS_HISTORY, marks the ones that failed.
+    Uint16 nextTicket;
+    Uint16 lastFinishedTicket;
+    Uint16 failedTickets;
+    Uint16 failureCount;
+
     Uint16 readStatusRegister( void );
     void setWriteLatch( void );
-    void waitForWriteCycle( void );
-    void sendReadCommand(Uint16 blockNumber);
-    void sendWriteCommand(Uint16 blockNumber);
-    void receivePage(Uint16 numWords, Uint16 *buffer);
-    void sendPage(Uint16 numWords, Uint16 *buffer);
-    void initSpi(void);
+    bool waitForWriteCycle( void );
+    void sendCommand(Uint16 command, Uint16 wordAddress);
+    Uint16 queueSpace(void);
+    Uint16 readQueued(Uint16 address, Uint16 word);
     void configureSpiBus8Bit(void);
     void configureSpiBus16Bit(void);
+    void startWrite(void);
+    void finishWrite(bool success);
 
 public:
     EEPROM(SPIBus *spiBus);
@@ -66,9 +142,52 @@ public:
     // initialize hardware for operation
     void initHardware(void);
 
-    bool readPage(Uint16 pageNum, Uint16 *buffer);
-    bool writePage(Uint16 pageNum, Uint16 *buffer);
+    // read any number of words, crossing pages as needed, in one transfer;
+    // waits for a write cycle in progress, and takes words still in the write
+    // queue from the queue
+    void read(Uint16 address, Uint16 numWords, Uint16 *buffer);
+
+    // stream a long read in pieces, without buffering the whole thing: begin
+    // at an address, read as many pieces as needed, then end
+    void beginRead(Uint16 address);
+    void readNext(Uint16 numWords, Uint16 *buffer);
+    void endRead(void);
+
+    // queue a write of any number of words without waiting; the write is split
+    // on page boundaries.  Returns a ticket for checking its status, or
+    // EEPROM_NO_TICKET if it runs past the end of the chip or there isn't room
+    // in the queue for all of it.
+    Uint16 write(Uint16 address, Uint16 numWords, const Uint16 *buffer);
+
+    // status of a queued write; known for the last EEPROM_STATUS_HISTORY
+    // tickets handed out, and EEPROM_STATUS_EXPIRED before that
+    Uint16 getStatus(Uint16 ticket);
+
+    // number of writes that have failed since startup
+    Uint16 getFailureCount(void);
+
+    // are there writes waiting or in progress?
+    bool isBusy(void);
+
+    // advance the write engine; call every EEPROM_SERVICE_INTERVAL_MS with the
+    // current time, in milliseconds
+    void service(Uint32 now);
+
+    // finish every queued write, waiting as necessary; a write the chip
+    // doesn't finish within EEPROM_WRITE_TIMEOUT_MS is counted as failed
+    void flush(void);
 };
 
 
+inline Uint16 EEPROM :: getFailureCount(void)
+{
+    return this->failureCount;
+}
+
+inline bool EEPROM :: isBusy(void)
+{
+    return this->head != this->tail;
+}
+
+
 #endif // __EEPROM_H
@@ -0,0 +1,306 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "EEPROMCache.h"
+
+
+EEPROMCache :: EEPROMCache(EEPROM *eeprom, Clock *clock)
+{
+    this->eeprom = eeprom;
+    this->clock = clock;
+
+    for( Uint16 i = 0; i < EEPROM_CACHE_LINES; i++ )
+    {
+        this->lines[i].valid = false;
+        this->lines[i].dirty = false;
+        this->lines[i].ticket = EEPROM_NO_TICKET;
+    }
+
+    this->lastWriteTime = 0;
+    this->written = false;
+    this->writeCount = 0;
+}
+
+EEPROM_CACHE_LINE *EEPROMCache :: find(Uint16 page)
+{
+    for( Uint16 i = 0; i < EEPROM_CACHE_LINES; i++ )
+    {
+        if( this->lines[i].valid && this->lines[i].page == page )
+        {
+            return &this->lines[i];
+        }
+    }
+    return NULL;
+}
+
+EEPROM_CACHE_LINE *EEPROMCache :: allocate(Uint16 page)
+{
+    EEPROM_CACHE_LINE *line = find(page);
+    if( line != NULL )
+    {
+        return line;
+    }
+
+    // take an empty line, or else the settled line that changed longest ago;
+    // a line still being written may be needed again if the write fails
+    for( Uint16 i = 0; i < EEPROM_CACHE_LINES; i++ )
+    {
+        EEPROM_CACHE_LINE *candidate = &this->lines[i];
+
+        if( ! candidate->valid )
+        {
+            return candidate;
+        }
+        if( ! candidate->dirty && candidate->ticket == EEPROM_NO_TICKET &&
+                (line == NULL || (int32)(candidate->changeTime - line->changeTime) < 0) )
+        {
+            line = candidate;
+        }
+    }
+
+    // NULL if every line is waiting to be written or being written
+    return line;
+}
+
+void EEPROMCache :: read(Uint16 address, Uint16 numWords, Uint16 *buffer)
+{
+    while( numWords > 0 )
+    {
+        Uint16 page = address / EEPROM_PAGE_SIZE;
+        Uint16 offset = address % EEPROM_PAGE_SIZE;
+        Uint16 count = EEPROM_PAGE_SIZE - offset;
+        if( count > numWords ) count = numWords;
+
+        EEPROM_CACHE_LINE *line = find(page);
+        if( line != NULL )
+        {
+            for( Uint16 i = 0; i < count; i++ )
+            {
+                buffer[i] = line->data[offset + i];
+            }
+        }
+        else
+        {
+            this->eeprom->read(address, count, buffer);
+        }
+
+        address += count;
+        buffer += count;
+        numWords -= count;
+    }
+}
+
+bool EEPROMCache :: write(Uint16 address, Uint16 numWords, const Uint16 *buffer)
+{
+    Uint16 firstPage = address / EEPROM_PAGE_SIZE;
+    Uint16 lastPage = (address + numWords - 1) / EEPROM_PAGE_SIZE;
+
+    if( numWords == 0 )
+    {
+        return true;
+    }
+
+    // make sure every page will fit before changing anything
+    Uint16 needed = 0;
+    Uint16 available = 0;
+    for( Uint16 page = firstPage; page <= lastPage; page++ )
+    {
+        if( find(page) == NULL ) needed++;
+    }
+    for( Uint16 i = 0; i < EEPROM_CACHE_LINES; i++ )
+    {
+        if( ! this->lines[i].valid ||
+                (! this->lines[i].dirty && this->lines[i].ticket == EEPROM_NO_TICKET) ) available++;
+    }
+    if( needed > available )
+    {
+        return false;
+    }
+
+    Uint32 now = this->clock->getMillis();
+
+    while( numWords > 0 )
+    {
+        Uint16 page = address / EEPROM_PAGE_SIZE;
+        Uint16 offset = address % EEPROM_PAGE_SIZE;
+        Uint16 count = EEPROM_PAGE_SIZE - offset;
+        if( count > numWords ) count = numWords;
+
+        EEPROM_CACHE_LINE *line = find(page);
+        if( line == NULL )
+        {
+            line = allocate(page);
+
+            // a partial page has to be filled in from the chip first
+            if( count < EEPROM_PAGE_SIZE )
+            {
+                this->eeprom->read(EEPROM_PAGE_ADDRESS(page), EEPROM_PAGE_SIZE, line->data);
+            }
+            line->valid = true;
+            line->page = page;
+        }
+
+        // only a real change needs writing
+        for( Uint16 i = 0; i < count; i++ )
+        {
+            if( line->data[offset + i] != buffer[i] )
+            {
+                line->data[offset + i] = buffer[i];
+                line->dirty = true;
+                line->changeTime = now;
+            }
+        }
+
+        address += count;
+        buffer += count;
+        numWords -= count;
+    }
+
+    return true;
+}
+
+bool EEPROMCache :: isDirty(Uint16 address)
+{
+    EEPROM_CACHE_LINE *line = find(address / EEPROM_PAGE_SIZE);
+    return line != NULL && line->dirty;
+}
+
+bool EEPROMCache :: isAnyDirty(void)
+{
+    for( Uint16 i = 0; i < EEPROM_CACHE_LINES; i++ )
+    {
+        if( this->lines[i].dirty ) return true;
+    }
+    return false;
+}
+
+bool EEPROMCache :: writeBack(EEPROM_CACHE_LINE *line, Uint32 now)
+{
+    Uint16 ticket = this->eeprom->write(EEPROM_PAGE_ADDRESS(line->page), EEPROM_PAGE_SIZE, line->data);
+    if( ticket == EEPROM_NO_TICKET )
+    {
+        // the write queue is full; try again later
+        return false;
+    }
+
+    line->dirty = false;
+    line->ticket = ticket;
+    this->lastWriteTime = now;
+    this->written = true;
+    this->writeCount++;
+    return true;
+}
+
+void EEPROMCache :: checkWrites(void)
+{
+    for( Uint16 i = 0; i < EEPROM_CACHE_LINES; i++ )
+    {
+        EEPROM_CACHE_LINE *line = &this->lines[i];
+
+        if( line->ticket == EEPROM_NO_TICKET )
+        {
+            continue;
+        }
+
+        Uint16 status = this->eeprom->getStatus(line->ticket);
+        if( status == EEPROM_STATUS_PENDING )
+        {
+            continue;
+        }
+
+        // the page is already settled, so it goes out again at the next
+        // write slot
+        if( status != EEPROM_STATUS_DONE )
+        {
+            line->dirty = true;
+        }
+        line->ticket = EEPROM_NO_TICKET;
+    }
+}
+
+void EEPROMCache :: service(void)
+{
+    Uint32 now = this->clock->getMillis();
+    EEPROM_CACHE_LINE *oldest = NULL;
+
+    checkWrites();
+
+    // rate limit writes to protect the EEPROM
+    if( this->written && now - this->lastWriteTime < SETTINGS_MIN_WRITE_INTERVAL_MS )
+    {
+        return;
+    }
+
+    // write back the page that settled first
+    for( Uint16 i = 0; i < EEPROM_CACHE_LINES; i++ )
+    {
+        EEPROM_CACHE_LINE *line = &this->lines[i];
+
+        if( line->dirty && now - line->changeTime >= SETTINGS_FLUSH_DELAY_MS &&
+                (oldest == NULL || (int32)(line->changeTime - oldest->changeTime) < 0) )
+        {
+            oldest = line;
+        }
+    }
+
+    if( oldest != NULL )
+    {
+        writeBack(oldest, now);
+    }
+}
+
+void EEPROMCache :: flush(void)
+{
+    Uint32 now = this->clock->getMillis();
+
+    for( Uint16 i = 0; i < EEPROM_CACHE_LINES; i++ )
+    {
+        if( this->lines[i].dirty )
+        {
+            writeBack(&this->lines[i], now);
+        }
+    }
+}
+
+void EEPROMCache :: sync(void)
+{
+    // the write queue may not hold everything at once, so keep going while
+    // pages are being written, but don't retry a dead chip forever
+    Uint16 failures = 0;
+    while( isAnyDirty() && failures < EEPROM_CACHE_SYNC_ATTEMPTS )
+    {
+        Uint16 before = this->eeprom->getFailureCount();
+
+        flush();
+        this->eeprom->flush();
+        checkWrites();
+
+        if( this->eeprom->getFailureCount() != before )
+        {
+            failures++;
+        }
+    }
+}
@@ -0,0 +1,126 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __EEPROM_CACHE_H
+#define __EEPROM_CACHE_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+#include "EEPROM.h"
+#include "Clock.h"
+
+
+// Number of pages that can be held in the cache
+#define EEPROM_CACHE_LINES 4
+
+// Number of times sync() tries to write a page before giving up on it
+#define EEPROM_CACHE_SYNC_ATTEMPTS 2
+
+
+// One cached page
+typedef struct EEPROM_CACHE_LINE
+{
+    bool valid;                     // holds a page
+    bool dirty;                     // changed since it was last written
+    Uint16 ticket;                  // write in progress, or EEPROM_NO_TICKET
+    Uint16 page;
+    Uint32 changeTime;              // time of the last change, in milliseconds
+    Uint16 data[EEPROM_PAGE_SIZE];
+} EEPROM_CACHE_LINE;
+
+
+//
+// Write-back cache over the EEPROM
+//
+// Writes land in RAM and mark their pages dirty.  A dirty page is written to
+// the EEPROM only after it has been left unchanged for the flush delay, so a
+// burst of changes to the same page costs a single write cycle, and no more
+// than one page is written per minimum write interval.  A page stays in the
+// cache until its write is known to have finished, and becomes dirty again if
+// the write failed, so it is retried.  Reads are served from
+// the cache where possible.  Addresses and lengths are in words, as for the
+// EEPROM itself.
+//
+class EEPROMCache
+{
+private:
+    EEPROM *eeprom;
+    Clock *clock;
+
+    EEPROM_CACHE_LINE lines[EEPROM_CACHE_LINES];
+
+    // time of the last write to the EEPROM, for rate limiting
+    Uint32 lastWriteTime;
+    bool written;
+
+    // number of pages written to the EEPROM since startup
+    Uint32 writeCount;
+
+    EEPROM_CACHE_LINE *find(Uint16 page);
+    EEPROM_CACHE_LINE *allocate(Uint16 page);
+    bool writeBack(EEPROM_CACHE_LINE *line, Uint32 now);
+    void checkWrites(void);
+
+public:
+    EEPROMCache(EEPROM *eeprom, Clock *clock);
+
+    // read any number of words, from the cache where possible
+    void read(Uint16 address, Uint16 numWords, Uint16 *buffer);
+
+    // change any number of words in the cache; returns false if there is no room
+    // for the pages, in which case nothing is changed
+    bool write(Uint16 address, Uint16 numWords, const Uint16 *buffer);
+
+    // is the page holding this address waiting to be written?
+    bool isDirty(Uint16 address);
+
+    // are there any changes waiting to be written?
+    bool isAnyDirty(void);
+
+    // number of pages written to the EEPROM since startup
+    Uint32 getWriteCount(void);
+
+    // write back pages that have settled, subject to the rate limit; call
+    // regularly from the background loop
+    void service(void);
+
+    // queue every dirty page for writing right away, ignoring the delay and
+    // rate limit; the EEPROM writes them in the background
+    void flush(void);
+
+    // write every dirty page and wait until they are in the chip, retrying a
+    // failed page up to EEPROM_CACHE_SYNC_ATTEMPTS times in all
+    void sync(void);
+};
+
+
+inline Uint32 EEPROMCache :: getWriteCount(void)
+{
+    return this->writeCount;
+}
+
+
+#endif // __EEPROM_CACHE_H
@@ -51,6 +51,7 @@ public:
     void initHardware( void );
 
     Uint16 getRPM( void );
+    Uint16 getLatestRPM( void );
     Uint32 getPosition( void );
     Uint32 getMaxCount( void );
 };
@@ -61,6 +62,12 @@ inline Uint32 Encoder :: getPosition(void)
     return ENCODER_REGS.QPOSCNT;
 }
 
+// the RPM as of the last call to getRPM(); safe to call from the ISR
+inline Uint16 Encoder :: getLatestRPM(void)
+{
+    return rpm;
+}
+
 inline Uint32 Encoder :: getMaxCount(void)
 {
     return _ENCODER_MAX_COUNT;
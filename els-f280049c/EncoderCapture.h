@@ -0,0 +1,209 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __ENCODERCAPTURE_H
+#define __ENCODERCAPTURE_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+#include "Encoder.h"
+#include "SerialPort.h"
+
+
+// ISR ticks in each block; a multiple of 8
+#define CAPTURE_BLOCK_TICKS 128
+#define CAPTURE_BLOCK_WORDS (CAPTURE_BLOCK_TICKS / 8)
+
+// Blocks held between the ISR and the serial port; must be a power of two
+#define CAPTURE_RING_SIZE 64
+#define CAPTURE_RING_MASK (CAPTURE_RING_SIZE - 1)
+
+// Change in the encoder count over one tick, two bits per tick
+#define CAPTURE_CODE_STILL 0
+#define CAPTURE_CODE_FORWARD 1
+#define CAPTURE_CODE_ESCAPE 2         // moved more than one count either way
+#define CAPTURE_CODE_BACKWARD 3
+
+// Frame layout, all fields little-endian:
+//   0  sync, 0xC3 0x3C
+//   2  sequence number, counting every block including any dropped
+//   4  encoder count on the tick before the block
+//   8  number of escape codes in the block
+//   10 codes for 128 ticks, four to a byte, first tick in the low bits
+//   42 Fletcher-16 checksum of bytes 2-41
+#define CAPTURE_SYNC1 0xC3
+#define CAPTURE_SYNC2 0x3C
+#define CAPTURE_FRAME_BYTES 44
+
+
+typedef struct CAPTURE_BLOCK
+{
+    Uint16 sequence;
+    Uint32 start;
+    Uint16 escapes;
+    Uint16 codes[CAPTURE_BLOCK_WORDS];
+} CAPTURE_BLOCK;
+
+
+//
+// Encoder capture
+//
+// Records the raw spindle encoder count on every ISR tick and streams it out
+// of the serial port, so a customer's spindle can be replayed on the bench
+// (see host/replay and tools/capture.py).  At one tick the count moves by at
+// most one unless the spindle turns faster than about 2900RPM with a 4096
+// count encoder, so each tick is packed into a two-bit code, and every block
+// carries the absolute count it starts from.  A move too big for a code is
+// marked, and the replay recovers it from the next block's start.
+//
+// Like the telemetry stream, the ISR fills a ring of blocks that only it
+// writes the head of, and the background loop drains it from the tail.  A
+// block that finds the ring full is dropped and leaves a gap in the sequence
+// numbers.
+//
+class EncoderCapture
+{
+private:
+    Encoder *encoder;
+    SerialPort *serialPort;
+
+    // ring storage, with the head advanced only by the ISR and the tail only
+    // by the background loop
+    CAPTURE_BLOCK *ring;
+    volatile Uint16 head;
+    volatile Uint16 tail;
+
+    // ISR state
+    CAPTURE_BLOCK *block;       // block being filled, or NULL if it's dropped
+    Uint32 previousCount;
+    Uint16 tick;
+    Uint16 codes;
+    Uint16 escapes;
+    Uint16 sequence;
+    Uint32 dropped;
+
+    // frame being sent
+    Uint16 frame[CAPTURE_FRAME_BYTES];
+    Uint16 framePosition;
+
+    // finish the current frame, but don't start another
+    bool paused;
+
+    void buildFrame(const CAPTURE_BLOCK *block);
+
+public:
+    EncoderCapture(Encoder *encoder, SerialPort *serialPort);
+
+    // send as much as the serial port will take; call from the background loop
+    void service(void);
+
+    // stop sending at the end of the current frame, so something else can use
+    // the serial port, or carry on; blocks are dropped while paused
+    void setPaused(bool paused);
+
+    // true when no frame is partly sent
+    bool isIdle(void);
+
+    // blocks lost because the ring was full
+    Uint32 getDropped(void);
+
+    // record this tick's count; call from the ISR
+    void ISR(void);
+};
+
+
+inline void EncoderCapture :: setPaused(bool paused)
+{
+    this->paused = paused;
+}
+
+inline bool EncoderCapture :: isIdle(void)
+{
+    return this->framePosition >= CAPTURE_FRAME_BYTES;
+}
+
+inline Uint32 EncoderCapture :: getDropped(void)
+{
+    return this->dropped;
+}
+
+inline void EncoderCapture :: ISR(void)
+{
+    if( this->tick == 0 ) {
+        // start a block, unless the ring is full
+        if( ((this->head + 1) & CAPTURE_RING_MASK) == this->tail ) {
+            this->block = NULL;
+            this->dropped++;
+        }
+        else {
+            this->block = &this->ring[this->head];
+            this->block->sequence = this->sequence;
+            this->block->start = this->previousCount;
+        }
+        this->sequence++;
+        this->escapes = 0;
+    }
+
+    Uint32 count = encoder->getPosition();
+    Uint32 delta = (count - this->previousCount) & _ENCODER_MAX_COUNT;
+    this->previousCount = count;
+
+    Uint16 code;
+    if( delta == 0 ) {
+        code = CAPTURE_CODE_STILL;
+    }
+    else if( delta == 1 ) {
+        code = CAPTURE_CODE_FORWARD;
+    }
+    else if( delta == _ENCODER_MAX_COUNT ) {
+        code = CAPTURE_CODE_BACKWARD;
+    }
+    else {
+        code = CAPTURE_CODE_ESCAPE;
+        this->escapes++;
+    }
+    this->codes |= code << ((this->tick & 7) << 1);
+    this->tick++;
+
+    if( (this->tick & 7) == 0 ) {
+        if( this->block != NULL ) {
+            this->block->codes[(this->tick >> 3) - 1] = this->codes;
+        }
+        this->codes = 0;
+
+        if( this->tick == CAPTURE_BLOCK_TICKS ) {
+            // publish the block only once it's complete
+            if( this->block != NULL ) {
+                this->block->escapes = this->escapes;
+                this->head = (this->head + 1) & CAPTURE_RING_MASK;
+            }
+            this->tick = 0;
+        }
+    }
+}
+
+
+#endif // __ENCODERCAPTURE_H
@@ -0,0 +1,112 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Favorites.h"
+#include "CRC.h"
+
+
+Favorites :: Favorites(EEPROM *eeprom)
+{
+    this->eeprom = eeprom;
+    this->saveTicket = EEPROM_NO_TICKET;
+
+    for( Uint16 i = 0; i < FAVORITES_COUNT; i++ )
+    {
+        this->slots[i] = 0;
+    }
+}
+
+void Favorites :: load(void)
+{
+    Uint16 page[EEPROM_PAGE_SIZE];
+
+    this->eeprom->read(EEPROM_PAGE_ADDRESS(FAVORITES_PAGE), EEPROM_PAGE_SIZE, page);
+
+    bool valid = page[FAVORITES_WORD_MAGIC] == FAVORITES_MAGIC &&
+            page[FAVORITES_WORD_CRC] == crc16(CRC16_INIT, page, FAVORITES_WORD_CRC);
+
+    for( Uint16 i = 0; i < FAVORITES_COUNT; i++ )
+    {
+        this->slots[i] = valid ? page[FAVORITES_WORD_SLOTS + i] : 0;
+    }
+}
+
+bool Favorites :: get(Uint16 slot, FAVORITE *favorite)
+{
+    if( slot >= FAVORITES_COUNT || (this->slots[slot] & FAVORITE_FLAG_USED) == 0 )
+    {
+        return false;
+    }
+
+    Uint16 word = this->slots[slot];
+
+    favorite->metric = (word & FAVORITE_FLAG_METRIC) != 0;
+    favorite->thread = (word & FAVORITE_FLAG_THREAD) != 0;
+    favorite->reverse = (word & FAVORITE_FLAG_REVERSE) != 0;
+    favorite->row = word & FAVORITE_ROW_MASK;
+    return true;
+}
+
+bool Favorites :: set(Uint16 slot, const FAVORITE *favorite)
+{
+    Uint16 page[EEPROM_PAGE_SIZE];
+    Uint16 word = FAVORITE_FLAG_USED | (favorite->row & FAVORITE_ROW_MASK);
+
+    if( slot >= FAVORITES_COUNT )
+    {
+        return false;
+    }
+
+    if( favorite->metric ) word |= FAVORITE_FLAG_METRIC;
+    if( favorite->thread ) word |= FAVORITE_FLAG_THREAD;
+    if( favorite->reverse ) word |= FAVORITE_FLAG_REVERSE;
+
+    page[FAVORITES_WORD_MAGIC] = FAVORITES_MAGIC;
+    for( Uint16 i = 0; i < FAVORITES_COUNT; i++ )
+    {
+        page[FAVORITES_WORD_SLOTS + i] = (i == slot) ? word : this->slots[i];
+    }
+    for( Uint16 i = FAVORITES_WORD_SLOTS + FAVORITES_COUNT; i < FAVORITES_WORD_CRC; i++ )
+    {
+        page[i] = 0;
+    }
+    page[FAVORITES_WORD_CRC] = crc16(CRC16_INIT, page, FAVORITES_WORD_CRC);
+
+    Uint16 ticket = this->eeprom->write(EEPROM_PAGE_ADDRESS(FAVORITES_PAGE), EEPROM_PAGE_SIZE, page);
+    if( ticket == EEPROM_NO_TICKET )
+    {
+        return false;
+    }
+
+    this->saveTicket = ticket;
+    this->slots[slot] = word;
+    return true;
+}
+
+Uint16 Favorites :: getSaveStatus(void)
+{
+    return this->eeprom->getStatus(this->saveTicket);
+}
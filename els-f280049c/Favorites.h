@@ -0,0 +1,102 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __FAVORITES_H
+#define __FAVORITES_H
+
+#include "F28x_Project.h"
+#include "EEPROM.h"
+
+
+// Page of the EEPROM holding the favorites, just below the feed tables
+#define FAVORITES_PAGE (EEPROM_PAGE_COUNT / 2 - 1)
+
+// Number of slots
+#define FAVORITES_COUNT 4
+
+// Identifies the favorites page, and its format version
+#define FAVORITES_MAGIC 0xFA01
+
+// Page layout
+#define FAVORITES_WORD_MAGIC 0
+#define FAVORITES_WORD_SLOTS 1          // one word per slot
+#define FAVORITES_WORD_CRC 7
+
+// Slot word: flags in the high byte, row in the low byte
+#define FAVORITE_FLAG_USED (1<<15)
+#define FAVORITE_FLAG_METRIC (1<<14)
+#define FAVORITE_FLAG_THREAD (1<<13)
+#define FAVORITE_FLAG_REVERSE (1<<12)
+#define FAVORITE_ROW_MASK 0x00FF
+
+
+typedef struct FAVORITE
+{
+    bool metric;
+    bool thread;
+    bool reverse;
+    Uint16 row;
+} FAVORITE;
+
+
+//
+// Favorites
+//
+// A few slots that each remember a complete machine setup: units, feed or
+// thread, direction and table row, so switching between the setups of
+// different operations is one key chord.  All of the slots are kept in one
+// EEPROM page with a CRC.  Saving a favorite is deliberate and rare, so it is
+// queued for writing right away rather than going through the cache.
+//
+class Favorites
+{
+private:
+    EEPROM *eeprom;
+
+    Uint16 slots[FAVORITES_COUNT];
+
+    // ticket of the last save queued
+    Uint16 saveTicket;
+
+public:
+    Favorites(EEPROM *eeprom);
+
+    // read the slots from the EEPROM; they are all empty if the page is invalid
+    void load(void);
+
+    // fetch a slot; returns false if it is empty
+    bool get(Uint16 slot, FAVORITE *favorite);
+
+    // fill a slot and queue it to be written to the EEPROM; returns false if
+    // the write queue is full
+    bool set(Uint16 slot, const FAVORITE *favorite);
+
+    // status of the last save queued by set(), as EEPROM::getStatus()
+    Uint16 getSaveStatus(void);
+};
+
+
+#endif // __FAVORITES_H
@@ -0,0 +1,298 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "IsrBenchmark.h"
+
+
+static const char *CORE_CASE_NAMES[BENCHMARK_CORE_CASES] =
+{
+    "stopped", "forward", "reverse", "wrap-forward", "wrap-reverse", "feed-change"
+};
+
+static const char *STEPPER_CASE_NAMES[BENCHMARK_STEPPER_CASES] =
+{
+    "stepper-idle", "stepper-run", "stepper-reversal", "stepper-disabled"
+};
+
+static const char *TABLE_NAMES[] =
+{
+    "inch-thread", "inch-feed", "metric-thread", "metric-feed"
+};
+#define TABLE_COUNT (sizeof(TABLE_NAMES) / sizeof(TABLE_NAMES[0]))
+
+
+IsrBenchmark :: IsrBenchmark(Clock *clock, FeedTableFactory *feedTableFactory, SerialPort *serialPort)
+{
+    this->clock = clock;
+    this->feedTableFactory = feedTableFactory;
+    this->serialPort = serialPort;
+
+    this->overhead = 0;
+
+    this->reportLine = 0;
+    this->stepperCase = 0;
+    this->table = 0;
+    this->row = 0;
+    this->coreCase = 0;
+    this->cases = 0;
+
+    this->lineLength = 0;
+    this->linePosition = 0;
+}
+
+Uint32 IsrBenchmark :: measureOverhead(void)
+{
+    Uint32 fastest = 0xFFFFFFFF;
+
+    for( Uint16 i = 0; i < BENCHMARK_CALLS; i++ ) {
+        Uint32 start = clock->getCycles();
+        Uint32 cycles = clock->getCycles() - start;
+        if( cycles < fastest ) fastest = cycles;
+    }
+
+    return fastest;
+}
+
+void IsrBenchmark :: timeCore(Uint16 testCase, const FEED_THREAD *feed, const FEED_THREAD *other, Uint32 *fastest)
+{
+    for( Uint16 repeat = 0; repeat < BENCHMARK_REPEATS; repeat++ ) {
+        Encoder encoder;
+        StepperDrive stepperDrive;
+        Core core(&encoder, &stepperDrive);
+
+        Uint32 position = (Uint32)ENCODER_RESOLUTION * 16;
+        int32 travel = BENCHMARK_COUNTS_PER_TICK;
+        if( testCase == BENCHMARK_STOPPED ) {
+            travel = 0;
+        }
+        if( testCase == BENCHMARK_REVERSE || testCase == BENCHMARK_WRAP_REVERSE ) {
+            travel = -travel;
+        }
+        if( testCase == BENCHMARK_WRAP_FORWARD || testCase == BENCHMARK_WRAP_REVERSE ) {
+            // cross the wrap half way through
+            position = (Uint32)(-travel * (BENCHMARK_CALLS / 2)) & _ENCODER_MAX_COUNT;
+        }
+
+        // the first tick just syncs the carriage
+        core.setFeed(feed);
+        core.setReverse(false);
+        core.publish();
+        core.setPowerOn(true);
+        ENCODER_REGS.QPOSCNT = position;
+        core.ISR();
+
+        if( testCase == BENCHMARK_FEED_CHANGE ) {
+            core.setFeed(other);
+            core.publish();
+        }
+
+        for( Uint16 call = 0; call < BENCHMARK_CALLS; call++ ) {
+            position = (position + travel) & _ENCODER_MAX_COUNT;
+            ENCODER_REGS.QPOSCNT = position;
+
+            Uint32 start = clock->getCycles();
+            core.ISR();
+            Uint32 cycles = clock->getCycles() - start;
+
+            if( cycles < fastest[call] ) fastest[call] = cycles;
+        }
+    }
+}
+
+void IsrBenchmark :: timeStepper(Uint16 testCase, Uint32 *fastest)
+{
+    for( Uint16 repeat = 0; repeat < BENCHMARK_REPEATS; repeat++ ) {
+        StepperDrive stepperDrive;
+        stepperDrive.setEnabled(testCase != BENCHMARK_STEPPER_DISABLED);
+
+        for( Uint16 call = 0; call < BENCHMARK_CALLS; call++ ) {
+            switch( testCase ) {
+            case BENCHMARK_STEPPER_RUN:
+                stepperDrive.setDesiredPosition(1000000);
+                break;
+            case BENCHMARK_STEPPER_REVERSAL:
+                stepperDrive.setDesiredPosition((call & 1) ? -1000000 : 1000000);
+                break;
+            case BENCHMARK_STEPPER_DISABLED:
+                stepperDrive.setDesiredPosition(call);
+                break;
+            }
+
+            Uint32 start = clock->getCycles();
+            stepperDrive.ISR();
+            Uint32 cycles = clock->getCycles() - start;
+
+            if( cycles < fastest[call] ) fastest[call] = cycles;
+        }
+    }
+}
+
+static char *appendText(char *p, const char *text)
+{
+    while( *text ) {
+        *p++ = *text++;
+    }
+    return p;
+}
+
+static char *appendNumber(char *p, int32 value)
+{
+    char digits[DISPLAY_MAX_DIGITS + 2];
+    Display::formatNumber(digits, DISPLAY_MAX_DIGITS, value, 0);
+
+    // drop the padding the display wants
+    char *d = digits;
+    while( *d == ' ' ) {
+        d++;
+    }
+    return appendText(p, d);
+}
+
+char *IsrBenchmark :: appendResult(char *p, Uint16 testCase, bool isCore, const FEED_THREAD *feed, const FEED_THREAD *other)
+{
+    Uint32 fastest[BENCHMARK_CALLS];
+    for( Uint16 call = 0; call < BENCHMARK_CALLS; call++ ) {
+        fastest[call] = 0xFFFFFFFF;
+    }
+
+    if( isCore ) {
+        timeCore(testCase, feed, other, fastest);
+    }
+    else {
+        timeStepper(testCase, fastest);
+    }
+
+    Uint32 worst = 0;
+    Uint32 total = 0;
+    for( Uint16 call = 0; call < BENCHMARK_CALLS; call++ ) {
+        Uint32 cycles = (fastest[call] > this->overhead) ? fastest[call] - this->overhead : 0;
+        if( cycles > worst ) worst = cycles;
+        total += cycles;
+    }
+
+    *p++ = ',';
+    p = appendNumber(p, worst);
+    *p++ = ',';
+    p = appendNumber(p, total / BENCHMARK_CALLS);
+
+    this->cases++;
+    return p;
+}
+
+bool IsrBenchmark :: buildLine(void)
+{
+    char *p = this->line;
+
+    if( this->reportLine == 0 ) {
+        this->overhead = measureOverhead();
+#ifdef USE_FLOATING_POINT
+        p = appendText(p, "# isr benchmark, floating point math, cycles per call");
+#else
+        p = appendText(p, "# isr benchmark, integer math, cycles per call");
+#endif
+    }
+    else if( this->reportLine == 1 ) {
+        p = appendText(p, "case,table,row,max,mean");
+    }
+    else if( this->stepperCase < BENCHMARK_STEPPER_CASES ) {
+        p = appendText(p, STEPPER_CASE_NAMES[this->stepperCase]);
+        p = appendText(p, ",,");
+        p = appendResult(p, this->stepperCase, false, NULL, NULL);
+        this->stepperCase++;
+    }
+    else {
+        // find the row, moving on to the next table at the end of one
+        FeedTable *feedTable = NULL;
+        while( this->table < TABLE_COUNT ) {
+            feedTable = feedTableFactory->getFeedTable(this->table >= 2, (this->table % 2) == 0);
+            feedTable->setSelectedRow(this->row);
+            if( feedTable->getSelectedRow() == this->row ) {
+                break;
+            }
+            this->table++;
+            this->row = 0;
+        }
+
+        if( this->table >= TABLE_COUNT ) {
+            if( this->cases == 0 ) {
+                return false;
+            }
+            p = appendText(p, "# end, ");
+            p = appendNumber(p, this->cases);
+            p = appendText(p, " cases");
+            this->cases = 0;
+        }
+        else {
+            const FEED_THREAD *feed = feedTable->current();
+
+            // any other row will do to change to
+            feedTable->setSelectedRow(this->row > 0 ? this->row - 1 : this->row + 1);
+            const FEED_THREAD *other = feedTable->current();
+
+            p = appendText(p, CORE_CASE_NAMES[this->coreCase]);
+            *p++ = ',';
+            p = appendText(p, TABLE_NAMES[this->table]);
+            *p++ = ',';
+            // the label, without the padding
+            const char *label = feed->label;
+            while( *label == ' ' ) {
+                label++;
+            }
+            while( *label != 0 && *label != ' ' ) {
+                *p++ = *label++;
+            }
+            p = appendResult(p, this->coreCase, true, feed, other);
+
+            if( ++this->coreCase >= BENCHMARK_CORE_CASES ) {
+                this->coreCase = 0;
+                this->row++;
+            }
+        }
+    }
+
+    *p++ = '\r';
+    *p++ = '\n';
+    this->lineLength = p - this->line;
+    this->linePosition = 0;
+    this->reportLine++;
+    return true;
+}
+
+bool IsrBenchmark :: service(void)
+{
+    Uint16 space = serialPort->getWriteSpace();
+
+    while( space > 0 ) {
+        if( this->linePosition >= this->lineLength && ! buildLine() ) {
+            return false;
+        }
+
+        serialPort->writeByte(this->line[this->linePosition++]);
+        space--;
+    }
+
+    return true;
+}
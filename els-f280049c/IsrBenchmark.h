@@ -0,0 +1,139 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __ISRBENCHMARK_H
+#define __ISRBENCHMARK_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+#include "Clock.h"
+#include "Core.h"
+#include "Tables.h"
+#include "SerialPort.h"
+
+
+// Timed ISR calls in each case
+#define BENCHMARK_CALLS 32
+
+// Times each case is run from the same start; every call keeps its fastest
+// time, so a stray interrupt or cache miss doesn't count.  The host build
+// raises this, as its timing is far noisier.
+#ifndef BENCHMARK_REPEATS
+#define BENCHMARK_REPEATS 16
+#endif
+
+// Spindle travel per ISR tick in the moving cases: a little over 3000 RPM
+#define BENCHMARK_COUNTS_PER_TICK ((Uint32)ENCODER_RESOLUTION * 3000 / 60 * STEPPER_CYCLE_US / 1000000 + 1)
+
+// Encoder states Core::ISR() is timed in, for every feed table row
+#define BENCHMARK_STOPPED 0
+#define BENCHMARK_FORWARD 1
+#define BENCHMARK_REVERSE 2
+#define BENCHMARK_WRAP_FORWARD 3        // forward through the top of the count
+#define BENCHMARK_WRAP_REVERSE 4        // backward through zero
+#define BENCHMARK_FEED_CHANGE 5         // forward, with a new feed ramping in
+#define BENCHMARK_CORE_CASES 6
+
+// Drive states StepperDrive::ISR() is timed in on its own
+#define BENCHMARK_STEPPER_IDLE 0
+#define BENCHMARK_STEPPER_RUN 1
+#define BENCHMARK_STEPPER_REVERSAL 2    // the target flips every tick
+#define BENCHMARK_STEPPER_DISABLED 3
+#define BENCHMARK_STEPPER_CASES 4
+
+// Longest line of the report, including the terminator
+#define BENCHMARK_LINE_LENGTH 64
+
+
+//
+// ISR benchmark
+//
+// Times the real-time path, in CPU cycles, across every feed table row and
+// encoder state, on private Core, Encoder and StepperDrive objects driven
+// through the encoder count register.  The report is CSV, one line per case
+// with the worst and mean cycles per call, and is built a line at a time so
+// each case is timed just before its line is sent.  tools/isr_bench.py keeps
+// baselines and flags any case whose worst time grew.
+//
+// On the target, ENABLE_ISR_BENCHMARK builds an image that sends the report
+// out of the serial port instead of running the lathe.  The host build in
+// host/ prints the same report, timed with the host's timestamp counter.
+//
+class IsrBenchmark
+{
+private:
+    Clock *clock;
+    FeedTableFactory *feedTableFactory;
+    SerialPort *serialPort;
+
+    // cost of reading the clock twice
+    Uint32 overhead;
+
+    // where the report is up to
+    Uint16 reportLine;
+    Uint16 stepperCase;
+    Uint16 table;
+    Uint16 row;
+    Uint16 coreCase;
+    Uint16 cases;
+
+    // line being sent
+    char line[BENCHMARK_LINE_LENGTH];
+    Uint16 lineLength;
+    Uint16 linePosition;
+
+    Uint32 measureOverhead(void);
+    void timeCore(Uint16 testCase, const FEED_THREAD *feed, const FEED_THREAD *other, Uint32 *fastest);
+    void timeStepper(Uint16 testCase, Uint32 *fastest);
+    char *appendResult(char *p, Uint16 testCase, bool isCore, const FEED_THREAD *feed, const FEED_THREAD *other);
+
+public:
+    IsrBenchmark(Clock *clock, FeedTableFactory *feedTableFactory, SerialPort *serialPort);
+
+    // time the next case and build its report line; returns false once the
+    // report is complete
+    bool buildLine(void);
+    const char *getLine(void);
+    Uint16 getLineLength(void);
+
+    // keep the serial port fed with the report; returns false once it has
+    // all been handed over
+    bool service(void);
+};
+
+
+inline const char *IsrBenchmark :: getLine(void)
+{
+    return this->line;
+}
+
+inline Uint16 IsrBenchmark :: getLineLength(void)
+{
+    return this->lineLength;
+}
+
+
+#endif // __ISRBENCHMARK_H
@@ -0,0 +1,190 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Keypad.h"
+
+
+Keypad :: Keypad(ControlPanel *controlPanel, Clock *clock)
+{
+    this->controlPanel = controlPanel;
+    this->clock = clock;
+
+    this->head = 0;
+    this->tail = 0;
+
+    this->current.all = 0;
+    this->gesture.all = 0;
+    this->pressTime = 0;
+    this->gestureTime = 0;
+
+    this->tracking = false;
+    this->longPressSent = false;
+    this->nextRepeat = 0;
+    this->repeatInterval = 0;
+
+    // by default, only UP and DOWN repeat
+    KEY_REG repeatKeys;
+    repeatKeys.all = 0;
+    repeatKeys.bit.UP = 1;
+    repeatKeys.bit.DOWN = 1;
+    setRepeat(repeatKeys, KEY_REPEAT_DELAY_MS, KEY_REPEAT_INTERVAL_MS, KEY_REPEAT_MIN_INTERVAL_MS, KEY_REPEAT_ACCELERATION_MS);
+    setLongPress(KEY_LONG_PRESS_MS);
+}
+
+void Keypad :: setRepeat(KEY_REG keys, Uint16 delay, Uint16 startInterval, Uint16 minInterval, Uint16 acceleration)
+{
+    this->repeatKeys = keys;
+    this->repeatDelay = delay;
+    this->repeatStartInterval = startInterval;
+    this->repeatMinInterval = minInterval;
+    this->repeatAcceleration = acceleration;
+}
+
+void Keypad :: setLongPress(Uint16 time)
+{
+    this->longPressTime = time;
+}
+
+void Keypad :: post(Uint16 type, KEY_REG keys, Uint32 time, Uint32 held)
+{
+    Uint16 next = (this->head + 1) % KEY_QUEUE_SIZE;
+
+    // if the UI has fallen this far behind, drop the newest events
+    if( next == this->tail ) {
+        return;
+    }
+
+    this->queue[this->head].type = type;
+    this->queue[this->head].keys = keys;
+    this->queue[this->head].time = time;
+    this->queue[this->head].held = held;
+    this->head = next;
+}
+
+void Keypad :: keysChanged(KEY_REG keys, Uint32 now)
+{
+    if( this->current.all != 0 && keys.all != 0 ) {
+        if( (keys.all & ~this->current.all) == 0 ) {
+            // letting go of part of a chord ends it: the keys still held
+            // don't repeat or long press, and the release of the whole chord
+            // is reported once they are all up
+            this->tracking = false;
+            this->current = keys;
+            return;
+        }
+
+        if( (keys.all & this->current.all) != this->current.all ) {
+            // a different key without an intervening release is most likely a
+            // bad read rather than a real press; ignore it
+            return;
+        }
+
+        // another key added to the ones held makes a chord: report it as a
+        // new press of all of them, timed from now
+        this->gesture.all |= keys.all;
+        this->pressTime = now;
+        post(KEY_PRESS, keys, now, 0);
+
+        this->tracking = true;
+        this->longPressSent = false;
+        this->nextRepeat = now + this->repeatDelay;
+        this->repeatInterval = this->repeatStartInterval;
+        this->current = keys;
+        return;
+    }
+
+    if( keys.all != 0 ) {
+        this->gesture.all = keys.all;
+        this->gestureTime = now;
+        this->pressTime = now;
+        post(KEY_PRESS, keys, now, 0);
+
+        this->tracking = true;
+        this->longPressSent = false;
+        this->nextRepeat = now + this->repeatDelay;
+        this->repeatInterval = this->repeatStartInterval;
+    }
+    else {
+        post(KEY_RELEASE, this->gesture, now, now - this->gestureTime);
+        this->tracking = false;
+    }
+
+    this->current = keys;
+}
+
+void Keypad :: keysHeld(Uint32 now)
+{
+    if( ! this->tracking ) {
+        return;
+    }
+
+    if( (this->current.all & ~this->repeatKeys.all) == 0 ) {
+        // every key held is a repeating key
+        if( (int32)(now - this->nextRepeat) >= 0 ) {
+            post(KEY_REPEAT, this->current, now, now - this->pressTime);
+
+            // speed up the longer the key is held
+            if( this->repeatInterval > this->repeatMinInterval + this->repeatAcceleration ) {
+                this->repeatInterval -= this->repeatAcceleration;
+            }
+            else {
+                this->repeatInterval = this->repeatMinInterval;
+            }
+
+            // schedule from now, so a slow UI loop doesn't cause a burst
+            this->nextRepeat = now + this->repeatInterval;
+        }
+    }
+    else if( ! this->longPressSent && now - this->pressTime >= this->longPressTime ) {
+        post(KEY_LONG_PRESS, this->current, now, now - this->pressTime);
+        this->longPressSent = true;
+    }
+}
+
+void Keypad :: scan(void)
+{
+    Uint32 now = this->clock->getMillis();
+    KEY_REG keys = this->controlPanel->getKeyState(now);
+
+    if( keys.all != this->current.all ) {
+        keysChanged(keys, now);
+    }
+    else if( keys.all != 0 ) {
+        keysHeld(now);
+    }
+}
+
+bool Keypad :: getEvent(KEY_EVENT *event)
+{
+    if( this->tail == this->head ) {
+        return false;
+    }
+
+    *event = this->queue[this->tail];
+    this->tail = (this->tail + 1) % KEY_QUEUE_SIZE;
+
+    return true;
+}
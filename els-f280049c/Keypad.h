@@ -0,0 +1,126 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __KEYPAD_H
+#define __KEYPAD_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+#include "ControlPanel.h"
+#include "Clock.h"
+
+
+// Event types
+#define KEY_PRESS 1         // one or more keys went down
+#define KEY_REPEAT 2        // a repeating key is still being held
+#define KEY_LONG_PRESS 3    // a non-repeating key has been held past the long press time
+#define KEY_RELEASE 4       // all keys are up again
+
+// Number of events that can be queued between UI loops
+#define KEY_QUEUE_SIZE 16
+
+
+typedef struct KEY_EVENT
+{
+    // one of the event types above
+    Uint16 type;
+
+    // keys involved; for a release, every key pressed since the last release
+    KEY_REG keys;
+
+    // time of the event, in milliseconds
+    Uint32 time;
+
+    // how long the keys have been held at the time of the event, in milliseconds
+    Uint32 held;
+} KEY_EVENT;
+
+
+//
+// Key event subsystem
+//
+// Polls the debounced key state from the control panel and turns it into a
+// queue of timestamped events, so nothing is lost between UI loops.  Keys in
+// the repeat mask auto-repeat while held, getting faster the longer they are
+// held.  Other keys report a long press instead.  Pressing another key while
+// holding one reports a chord of both; letting go of any key of a chord ends
+// its long press.
+//
+class Keypad
+{
+private:
+    ControlPanel *controlPanel;
+    Clock *clock;
+
+    // circular event queue
+    KEY_EVENT queue[KEY_QUEUE_SIZE];
+    Uint16 head;
+    Uint16 tail;
+
+    // current key state, and every key pressed since all keys were last up
+    KEY_REG current;
+    KEY_REG gesture;
+
+    // when the current keys went down, and when the whole gesture started
+    Uint32 pressTime;
+    Uint32 gestureTime;
+
+    // auto-repeat and long press tracking for the current keys
+    bool tracking;
+    bool longPressSent;
+    Uint32 nextRepeat;
+    Uint16 repeatInterval;
+
+    // configuration
+    KEY_REG repeatKeys;
+    Uint16 repeatDelay;
+    Uint16 repeatStartInterval;
+    Uint16 repeatMinInterval;
+    Uint16 repeatAcceleration;
+    Uint16 longPressTime;
+
+    void post(Uint16 type, KEY_REG keys, Uint32 time, Uint32 held);
+    void keysChanged(KEY_REG keys, Uint32 now);
+    void keysHeld(Uint32 now);
+
+public:
+    Keypad(ControlPanel *controlPanel, Clock *clock);
+
+    // configure which keys auto-repeat and how fast, in milliseconds
+    void setRepeat(KEY_REG keys, Uint16 delay, Uint16 startInterval, Uint16 minInterval, Uint16 acceleration);
+
+    // configure the long press time, in milliseconds
+    void setLongPress(Uint16 time);
+
+    // poll the control panel and queue any resulting events
+    void scan(void);
+
+    // fetch the next queued event; returns false if there are none
+    bool getEvent(KEY_EVENT *event);
+};
+
+
+#endif // __KEYPAD_H
@@ -0,0 +1,108 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Monitor.h"
+
+
+Monitor :: Monitor( Clock *clock, StepperDrive *stepperDrive )
+{
+    this->clock = clock;
+    this->stepperDrive = stepperDrive;
+
+    this->sampleRequested = false;
+    this->busyCycles = 0;
+    this->peakCycles = 0;
+    this->isrCycles = 0;
+
+    this->passStart = 0;
+    this->passIsrStart = 0;
+    this->refreshStart = 0;
+    this->refreshIsrStart = 0;
+    this->backgroundCycles = 0;
+    this->idleCycles = 0;
+    this->refreshPeakCycles = 0;
+    this->updateTime = 0;
+    this->overruns = 0;
+
+    this->previous.time = 0;
+    this->previous.position = 0;
+    this->previous.backlog = 0;
+    this->previous.busyCycles = 0;
+    this->previous.peakCycles = 0;
+
+    this->position = 0;
+    this->stepRate = 0;
+    this->backlog = 0;
+    this->load = 0;
+    this->peakLoad = 0;
+    this->backgroundLoad = 0;
+    this->idle = 0;
+    this->refreshPeak = 0;
+}
+
+void Monitor :: update(void)
+{
+    // the background loop's own figures don't depend on the ISR sample
+    Uint32 now = clock->getCycles();
+    Uint32 window = now - this->updateTime;
+    if( window > 0 ) {
+        this->backgroundLoad = (Uint64)this->backgroundCycles * 1000 / window;
+        if( this->backgroundLoad > 1000 ) this->backgroundLoad = 1000;
+        this->idle = (Uint64)this->idleCycles * 1000 / window;
+        if( this->idle > 1000 ) this->idle = 1000;
+    }
+    this->refreshPeak = (Uint64)this->refreshPeakCycles * 1000 / REFRESH_PERIOD_CYCLES;
+    this->backgroundCycles = 0;
+    this->idleCycles = 0;
+    this->refreshPeakCycles = 0;
+    this->updateTime = now;
+
+    // the ISR hasn't picked up the last request yet
+    if( this->sampleRequested ) {
+        return;
+    }
+
+    MONITOR_SAMPLE current;
+    current.time = this->sample.time;
+    current.position = this->sample.position;
+    current.backlog = this->sample.backlog;
+    current.busyCycles = this->sample.busyCycles;
+    current.peakCycles = this->sample.peakCycles;
+
+    Uint32 elapsed = current.time - this->previous.time;
+    if( elapsed > 0 ) {
+        this->stepRate = (int64)(current.position - this->previous.position) * CPU_CLOCK_HZ / elapsed;
+        this->load = (Uint64)current.busyCycles * 1000 / elapsed;
+    }
+    this->peakLoad = (Uint64)current.peakCycles * 1000 / ISR_PERIOD_CYCLES;
+    this->position = current.position;
+    this->backlog = current.backlog;
+
+    this->previous = current;
+
+    // ask the ISR for the next one
+    this->sampleRequested = true;
+}
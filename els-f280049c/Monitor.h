@@ -0,0 +1,281 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __MONITOR_H
+#define __MONITOR_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+#include "Clock.h"
+#include "StepperDrive.h"
+
+
+// Length of one ISR period, in CPU cycles
+#define ISR_PERIOD_CYCLES ((Uint32)STEPPER_CYCLE_US * CPU_CLOCK_MHZ)
+
+// Time budget for one user interface refresh, in CPU cycles
+#define REFRESH_PERIOD_CYCLES ((Uint32)CPU_CLOCK_HZ / UI_REFRESH_RATE_HZ)
+
+
+typedef struct MONITOR_SAMPLE
+{
+    // cycle count when the sample was taken
+    Uint32 time;
+
+    // carriage position, in steps
+    int32 position;
+
+    // steps the drive is behind the desired position
+    int32 backlog;
+
+    // total and longest ISR execution time since the previous sample, in cycles
+    Uint32 busyCycles;
+    Uint32 peakCycles;
+} MONITOR_SAMPLE;
+
+
+//
+// Real-time engine monitor
+//
+// Samples the state of the real-time engine for display.  The ISR keeps a
+// running total of its own execution time, and copies a consistent snapshot
+// only when the background loop has asked for one, so nothing in the ISR ever
+// waits on the background loop.
+//
+// The background loop is timed too, with the same cycle counter.  Each pass
+// that runs a task counts as background time and each pass that finds nothing
+// due counts as idle, less whatever the ISR took out of it either way.  User
+// interface refreshes are timed separately, to catch any that overrun their
+// share of UI_REFRESH_RATE_HZ.
+//
+class Monitor
+{
+private:
+    Clock *clock;
+    StepperDrive *stepperDrive;
+
+    // set by the background loop to request a sample; cleared by the ISR once
+    // the sample has been written
+    volatile bool sampleRequested;
+
+    // written by the ISR, read by the background loop
+    volatile MONITOR_SAMPLE sample;
+
+    // accumulated by the ISR between samples
+    Uint32 busyCycles;
+    Uint32 peakCycles;
+
+    // total ISR time, never reset; wraps
+    volatile Uint32 isrCycles;
+
+    // background loop pass and refresh being timed: cycle count and ISR total
+    // at the start
+    Uint32 passStart;
+    Uint32 passIsrStart;
+    Uint32 refreshStart;
+    Uint32 refreshIsrStart;
+
+    // accumulated by the background loop between updates
+    Uint32 backgroundCycles;
+    Uint32 idleCycles;
+    Uint32 refreshPeakCycles;
+    Uint32 updateTime;
+    Uint32 overruns;
+
+    // previous sample, for rate calculations
+    MONITOR_SAMPLE previous;
+
+    // derived values, calculated in the background loop
+    int32 position;
+    int32 stepRate;
+    int32 backlog;
+    Uint16 load;
+    Uint16 peakLoad;
+    Uint16 backgroundLoad;
+    Uint16 idle;
+    Uint16 refreshPeak;
+
+public:
+    Monitor(Clock *clock, StepperDrive *stepperDrive);
+
+    // collect the latest sample, if ready, and request another; call this
+    // periodically from the background loop
+    void update(void);
+
+    // carriage position, in steps
+    int32 getPosition(void);
+
+    // step frequency, in steps per second
+    int32 getStepRate(void);
+
+    // steps the drive is behind the desired position, and how many it may be
+    int32 getBacklog(void);
+    int32 getBacklogLimit(void);
+
+    // average and peak ISR load, in tenths of a percent
+    Uint16 getLoad(void);
+    Uint16 getPeakLoad(void);
+
+    // background task load and idle time, in tenths of a percent
+    Uint16 getBackgroundLoad(void);
+    Uint16 getIdle(void);
+
+    // longest user interface refresh since the last update, in tenths of a
+    // percent of its budget, not counting time taken by the ISR
+    Uint16 getRefreshPeak(void);
+
+    // refreshes that have overrun their budget, ISR time included, since
+    // startup
+    Uint32 getOverruns(void);
+
+    // time one pass of the background loop; busy is true if any task ran
+    void beginPass(void);
+    void endPass(bool busy);
+
+    // time one user interface refresh
+    void beginRefresh(void);
+    void endRefresh(void);
+
+    // account for one ISR; call at the end of the ISR with the cycle count
+    // from the beginning
+    void ISR(Uint32 startCycles);
+};
+
+
+inline int32 Monitor :: getPosition(void)
+{
+    return this->position;
+}
+
+inline int32 Monitor :: getStepRate(void)
+{
+    return this->stepRate;
+}
+
+inline int32 Monitor :: getBacklog(void)
+{
+    return this->backlog;
+}
+
+inline int32 Monitor :: getBacklogLimit(void)
+{
+    return stepperDrive->getBacklogLimit();
+}
+
+inline Uint16 Monitor :: getLoad(void)
+{
+    return this->load;
+}
+
+inline Uint16 Monitor :: getPeakLoad(void)
+{
+    return this->peakLoad;
+}
+
+inline Uint16 Monitor :: getBackgroundLoad(void)
+{
+    return this->backgroundLoad;
+}
+
+inline Uint16 Monitor :: getIdle(void)
+{
+    return this->idle;
+}
+
+inline Uint16 Monitor :: getRefreshPeak(void)
+{
+    return this->refreshPeak;
+}
+
+inline Uint32 Monitor :: getOverruns(void)
+{
+    return this->overruns;
+}
+
+inline void Monitor :: beginPass(void)
+{
+    this->passIsrStart = this->isrCycles;
+    this->passStart = clock->getCycles();
+}
+
+inline void Monitor :: endPass(bool busy)
+{
+    Uint32 elapsed = clock->getCycles() - this->passStart;
+    Uint32 own = elapsed - (this->isrCycles - this->passIsrStart);
+
+    if( busy ) {
+        this->backgroundCycles += own;
+    }
+    else {
+        this->idleCycles += own;
+    }
+}
+
+inline void Monitor :: beginRefresh(void)
+{
+    this->refreshIsrStart = this->isrCycles;
+    this->refreshStart = clock->getCycles();
+}
+
+inline void Monitor :: endRefresh(void)
+{
+    Uint32 elapsed = clock->getCycles() - this->refreshStart;
+    Uint32 own = elapsed - (this->isrCycles - this->refreshIsrStart);
+
+    if( own > this->refreshPeakCycles ) {
+        this->refreshPeakCycles = own;
+    }
+    if( elapsed > REFRESH_PERIOD_CYCLES ) {
+        this->overruns++;
+    }
+}
+
+inline void Monitor :: ISR(Uint32 startCycles)
+{
+    Uint32 endCycles = clock->getCycles();
+    Uint32 elapsed = endCycles - startCycles;
+
+    this->busyCycles += elapsed;
+    this->isrCycles += elapsed;
+    if( elapsed > this->peakCycles ) {
+        this->peakCycles = elapsed;
+    }
+
+    if( this->sampleRequested ) {
+        this->sample.time = endCycles;
+        this->sample.position = stepperDrive->getCarriagePosition();
+        this->sample.backlog = stepperDrive->getBacklog();
+        this->sample.busyCycles = this->busyCycles;
+        this->sample.peakCycles = this->peakCycles;
+
+        this->busyCycles = 0;
+        this->peakCycles = 0;
+        this->sampleRequested = false;
+    }
+}
+
+
+#endif // __MONITOR_H
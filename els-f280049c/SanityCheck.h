@@ -56,6 +56,10 @@
 #error ENCODER_RESOLUTION must be between 100 and 10000
 #endif
 
+#if FEED_RAMP_COUNTS < 1 || FEED_RAMP_COUNTS > 32767
+#error FEED_RAMP_COUNTS must be between 1 and 32767
+#endif
+
 #if defined(LEADSCREW_TPI) && defined(LEADSCREW_HMM)
 #error LEADSCREW_TPI and LEADSCREW_HMM may not both be defined.  Choose only one.
 #endif
@@ -72,6 +76,76 @@
 #endif
 #endif
 
+#if KEY_SCAN_INTERVAL_MS < 1 || KEY_SCAN_INTERVAL_MS > KEY_DEBOUNCE_MS
+#error KEY_SCAN_INTERVAL_MS must be between 1ms and KEY_DEBOUNCE_MS
+#endif
+
+#if KEY_DEBOUNCE_MS < 2 || KEY_DEBOUNCE_MS > 50
+#error KEY_DEBOUNCE_MS must be between 2ms and 50ms
+#endif
+
+#if KEY_REPEAT_MIN_INTERVAL_MS < 10 || KEY_REPEAT_MIN_INTERVAL_MS > KEY_REPEAT_INTERVAL_MS
+#error KEY_REPEAT_MIN_INTERVAL_MS must be between 10ms and KEY_REPEAT_INTERVAL_MS
+#endif
+
+#if KEY_REPEAT_DELAY_MS < 100 || KEY_REPEAT_DELAY_MS > 5000
+#error KEY_REPEAT_DELAY_MS must be between 100ms and 5000ms
+#endif
+
+#if KEY_LONG_PRESS_MS < 250 || KEY_LONG_PRESS_MS > 5000
+#error KEY_LONG_PRESS_MS must be between 250ms and 5000ms
+#endif
+
+#if defined(DISPLAY_TM1638) && defined(DISPLAY_CHARACTER_LCD)
+#error Define only one of DISPLAY_TM1638 or DISPLAY_CHARACTER_LCD
+#endif
+
+#if !defined(DISPLAY_TM1638) && !defined(DISPLAY_CHARACTER_LCD)
+#error Define one of DISPLAY_TM1638 or DISPLAY_CHARACTER_LCD
+#endif
+
+#if SETTINGS_FLUSH_DELAY_MS < 100 || SETTINGS_FLUSH_DELAY_MS > 60000
+#error SETTINGS_FLUSH_DELAY_MS must be between 100ms and 60000ms
+#endif
+
+#if SETTINGS_MIN_WRITE_INTERVAL_MS < 1000
+#error SETTINGS_MIN_WRITE_INTERVAL_MS must be at least 1000ms
+#endif
+
+#if defined(USE_BROWNOUT_FLUSH) && (BROWNOUT_ADC_CHANNEL < 0 || BROWNOUT_ADC_CHANNEL > 15)
+#error BROWNOUT_ADC_CHANNEL must be between 0 and 15
+#endif
+
+#if defined(USE_BROWNOUT_FLUSH) && (BROWNOUT_THRESHOLD < 1 || BROWNOUT_THRESHOLD > 4095)
+#error BROWNOUT_THRESHOLD must be between 1 and 4095
+#endif
+
+#if (CPU_CLOCK_HZ / 4) / (8L * SERIAL_BAUD) < 2 || (CPU_CLOCK_HZ / 4) / (8L * SERIAL_BAUD) > 65536
+#error SERIAL_BAUD is out of range for the CPU clock
+#endif
+
+#if defined(USE_TELEMETRY) && (TELEMETRY_RATE_HZ < 1 || (1000000L / STEPPER_CYCLE_US) % TELEMETRY_RATE_HZ != 0)
+#error TELEMETRY_RATE_HZ must divide evenly into the ISR rate
+#endif
+
+// 18 byte frames at 10 bits per byte, with some room to spare
+#if defined(USE_TELEMETRY) && TELEMETRY_RATE_HZ * 180L > SERIAL_BAUD * 9L / 10
+#error TELEMETRY_RATE_HZ is too high for SERIAL_BAUD
+#endif
+
+#if defined(USE_TELEMETRY) && defined(USE_ENCODER_CAPTURE)
+#error Define only one of USE_TELEMETRY or USE_ENCODER_CAPTURE
+#endif
+
+// 44 byte frames every 128 ticks at 10 bits per byte, with some room to spare
+#if defined(USE_ENCODER_CAPTURE) && (1000000L / STEPPER_CYCLE_US) * 440 / 128 > SERIAL_BAUD * 9L / 10
+#error SERIAL_BAUD is too low for USE_ENCODER_CAPTURE
+#endif
+
+#if defined(USE_TRACE) && (TRACE_DIVIDER < 1 || TRACE_DIVIDER > 9)
+#error TRACE_DIVIDER must be between 1 and 9
+#endif
+
 #if defined(ENCODER_USE_EQEP1) && defined (ENCODER_USE_EQEP2)
 #error Define only one of ENCODER_USE_EQEP1 or ENCODER_USE_EQEP2
 #endif
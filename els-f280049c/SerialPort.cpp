@@ -0,0 +1,79 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SerialPort.h"
+
+
+SerialPort :: SerialPort(void)
+{
+}
+
+void SerialPort :: initHardware(void)
+{
+    EALLOW;
+
+    CpuSysRegs.PCLKCR7.bit.SCI_A = 1;           // clock the SCI
+
+    GpioCtrlRegs.GPAPUD.bit.GPIO28 = 0;         // Enable pull-up on GPIO28 (SCIRXDA)
+    GpioCtrlRegs.GPAQSEL2.bit.GPIO28 = 3;       // Asynchronous input GPIO28 (SCIRXDA)
+    GpioCtrlRegs.GPAMUX2.bit.GPIO28 = 1;        // Configure GPIO28 as SCIRXDA
+    GpioCtrlRegs.GPAGMUX2.bit.GPIO28 = 0;
+    GpioCtrlRegs.GPAPUD.bit.GPIO29 = 1;         // Disable pull-up on GPIO29 (SCITXDA)
+    GpioCtrlRegs.GPAMUX2.bit.GPIO29 = 1;        // Configure GPIO29 as SCITXDA
+    GpioCtrlRegs.GPAGMUX2.bit.GPIO29 = 0;
+
+    EDIS;
+
+    SciaRegs.SCICTL1.all = 0x0000;              // hold in reset while configuring
+    SciaRegs.SCICCR.all = 0x0007;               // 1 stop bit, no parity, 8 data bits
+    SciaRegs.SCIHBAUD.all = (SERIAL_BRR >> 8) & 0x00ff;
+    SciaRegs.SCILBAUD.all = SERIAL_BRR & 0x00ff;
+    SciaRegs.SCICTL2.all = 0x0000;              // no interrupts
+    SciaRegs.SCIFFTX.all = 0xC040;              // FIFO enabled, transmit FIFO held in reset
+    SciaRegs.SCIFFRX.all = 0x0040;              // receive FIFO held in reset
+    SciaRegs.SCIFFCT.all = 0x0000;              // no delay between bytes
+    SciaRegs.SCIPRI.bit.FREESOFT = 3;           // unaffected by emulation suspend
+    SciaRegs.SCICTL1.all = 0x0023;              // transmit and receive enabled, out of reset
+    SciaRegs.SCIFFTX.bit.TXFIFORESET = 1;
+    SciaRegs.SCIFFRX.bit.RXFIFORESET = 1;
+}
+
+Uint16 SerialPort :: getReadCount(void)
+{
+    // a break, framing error or overrun stops the receiver until it's reset;
+    // whatever was lost is lost, but the port keeps working
+    if( SciaRegs.SCIRXST.bit.RXERROR )
+    {
+        SciaRegs.SCICTL1.bit.SWRESET = 0;
+        SciaRegs.SCICTL1.bit.SWRESET = 1;
+    }
+    if( SciaRegs.SCIFFRX.bit.RXFFOVF )
+    {
+        SciaRegs.SCIFFRX.bit.RXFFOVRCLR = 1;
+    }
+
+    return SciaRegs.SCIFFRX.bit.RXFFST;
+}
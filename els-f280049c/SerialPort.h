@@ -0,0 +1,90 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __SERIAL_PORT_H
+#define __SERIAL_PORT_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+
+
+// LSPCLK, which clocks the SCI, at its reset divider of SYSCLK/4
+#define SERIAL_CLOCK_HZ (CPU_CLOCK_HZ / 4)
+
+// Baud rate register value for SERIAL_BAUD
+#define SERIAL_BRR (SERIAL_CLOCK_HZ / (8L * SERIAL_BAUD) - 1)
+
+// Depth of the SCI transmit FIFO
+#define SERIAL_FIFO_DEPTH 16
+
+
+//
+// Serial port driver
+//
+// Drives SCI-A on GPIO28/GPIO29, which the LaunchPad routes to the virtual COM
+// port on the debug probe.  Nothing here ever waits: the background loop asks
+// how much room the transmit FIFO has and only writes that much, and only
+// reads what the receive FIFO already holds.
+//
+class SerialPort
+{
+public:
+    SerialPort(void);
+
+    // initialize the hardware for operation
+    void initHardware(void);
+
+    // number of bytes that can be written without waiting
+    Uint16 getWriteSpace(void);
+
+    // queue one byte; only call when there is space
+    void writeByte(Uint16 data);
+
+    // number of bytes waiting to be read, after clearing any receive error
+    Uint16 getReadCount(void);
+
+    // take one received byte; only call when there is one
+    Uint16 readByte(void);
+};
+
+
+inline Uint16 SerialPort :: getWriteSpace(void)
+{
+    return SERIAL_FIFO_DEPTH - SciaRegs.SCIFFTX.bit.TXFFST;
+}
+
+inline void SerialPort :: writeByte(Uint16 data)
+{
+    SciaRegs.SCITXBUF.all = data & 0x00ff;
+}
+
+inline Uint16 SerialPort :: readByte(void)
+{
+    return SciaRegs.SCIRXBUF.all & 0x00ff;
+}
+
+
+#endif // __SERIAL_PORT_H
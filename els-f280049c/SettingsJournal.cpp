@@ -0,0 +1,144 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SettingsJournal.h"
+#include "CRC.h"
+
+
+SettingsJournal :: SettingsJournal(EEPROM *eeprom, EEPROMCache *cache)
+{
+    this->eeprom = eeprom;
+    this->cache = cache;
+
+    // start so the first record goes in the first page
+    this->newestPage = SETTINGS_PAGE_COUNT - 1;
+    this->newestSequence = 0;
+    this->found = false;
+}
+
+bool SettingsJournal :: isValid(const Uint16 *record)
+{
+    return record[SETTINGS_WORD_MAGIC] == SETTINGS_MAGIC &&
+            record[SETTINGS_WORD_CRC] == crc16(CRC16_INIT, record, SETTINGS_WORD_CRC);
+}
+
+Uint32 SettingsJournal :: getSequence(const Uint16 *record)
+{
+    return ((Uint32)record[SETTINGS_WORD_SEQUENCE_HIGH] << 16) | record[SETTINGS_WORD_SEQUENCE_LOW];
+}
+
+bool SettingsJournal :: load(SETTINGS *settings)
+{
+    Uint16 record[EEPROM_PAGE_SIZE];
+    Uint16 newest[EEPROM_PAGE_SIZE];
+
+    this->found = false;
+
+    // scan the whole ring in one sequential read
+    eeprom->beginRead(EEPROM_PAGE_ADDRESS(SETTINGS_FIRST_PAGE));
+    for( Uint16 i = 0; i < SETTINGS_PAGE_COUNT; i++ )
+    {
+        eeprom->readNext(EEPROM_PAGE_SIZE, record);
+
+        if( isValid(record) )
+        {
+            Uint32 sequence = getSequence(record);
+
+            // compare so the sequence number can wrap
+            if( ! this->found || (int32)(sequence - this->newestSequence) > 0 )
+            {
+                this->found = true;
+                this->newestPage = i;
+                this->newestSequence = sequence;
+                for( Uint16 j = 0; j < EEPROM_PAGE_SIZE; j++ )
+                {
+                    newest[j] = record[j];
+                }
+            }
+        }
+    }
+    eeprom->endRead();
+
+    if( this->found )
+    {
+        Uint16 flags = newest[SETTINGS_WORD_FLAGS];
+        settings->metric = (flags & SETTINGS_FLAG_METRIC) != 0;
+        settings->thread = (flags & SETTINGS_FLAG_THREAD) != 0;
+        settings->reverse = (flags & SETTINGS_FLAG_REVERSE) != 0;
+        settings->inchThreadRow = newest[SETTINGS_WORD_INCH_ROWS] >> 8;
+        settings->inchFeedRow = newest[SETTINGS_WORD_INCH_ROWS] & 0xFF;
+        settings->metricThreadRow = newest[SETTINGS_WORD_METRIC_ROWS] >> 8;
+        settings->metricFeedRow = newest[SETTINGS_WORD_METRIC_ROWS] & 0xFF;
+    }
+
+    return this->found;
+}
+
+bool SettingsJournal :: save(const SETTINGS *settings)
+{
+    Uint16 record[EEPROM_PAGE_SIZE];
+    Uint16 flags = 0;
+
+    if( settings->metric ) flags |= SETTINGS_FLAG_METRIC;
+    if( settings->thread ) flags |= SETTINGS_FLAG_THREAD;
+    if( settings->reverse ) flags |= SETTINGS_FLAG_REVERSE;
+
+    Uint32 sequence = this->newestSequence + 1;
+    Uint16 page = (this->newestPage + 1) % SETTINGS_PAGE_COUNT;
+
+    // replace the newest record if it hasn't been written yet
+    if( this->found && this->cache->isDirty(EEPROM_PAGE_ADDRESS(SETTINGS_FIRST_PAGE + this->newestPage)) )
+    {
+        sequence = this->newestSequence;
+        page = this->newestPage;
+    }
+
+    record[SETTINGS_WORD_MAGIC] = SETTINGS_MAGIC;
+    record[SETTINGS_WORD_SEQUENCE_HIGH] = sequence >> 16;
+    record[SETTINGS_WORD_SEQUENCE_LOW] = sequence & 0xFFFF;
+    record[SETTINGS_WORD_FLAGS] = flags;
+    record[SETTINGS_WORD_INCH_ROWS] = (settings->inchThreadRow << 8) | (settings->inchFeedRow & 0xFF);
+    record[SETTINGS_WORD_METRIC_ROWS] = (settings->metricThreadRow << 8) | (settings->metricFeedRow & 0xFF);
+    record[SETTINGS_WORD_RESERVED] = 0;
+    record[SETTINGS_WORD_CRC] = crc16(CRC16_INIT, record, SETTINGS_WORD_CRC);
+
+    // a failed write just leaves a bad page behind; the next save moves on
+    if( ! this->cache->write(EEPROM_PAGE_ADDRESS(SETTINGS_FIRST_PAGE + page), EEPROM_PAGE_SIZE, record) )
+    {
+        return false;
+    }
+
+    this->newestPage = page;
+    this->newestSequence = sequence;
+    this->found = true;
+
+    return true;
+}
+
+void SettingsJournal :: flush(void)
+{
+    this->cache->flush();
+}
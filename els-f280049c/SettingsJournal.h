@@ -0,0 +1,118 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __SETTINGS_JOURNAL_H
+#define __SETTINGS_JOURNAL_H
+
+#include "F28x_Project.h"
+#include "EEPROM.h"
+#include "EEPROMCache.h"
+
+
+// Pages of the EEPROM used for the journal ring; the page after it holds the
+// favorites, and the upper half of the chip holds the feed tables
+#define SETTINGS_FIRST_PAGE 0
+#define SETTINGS_PAGE_COUNT (EEPROM_PAGE_COUNT / 2 - 1)
+
+// Identifies a settings record, and its format version
+#define SETTINGS_MAGIC 0x5E71
+
+// Record layout, one page per record
+#define SETTINGS_WORD_MAGIC 0
+#define SETTINGS_WORD_SEQUENCE_HIGH 1
+#define SETTINGS_WORD_SEQUENCE_LOW 2
+#define SETTINGS_WORD_FLAGS 3
+#define SETTINGS_WORD_INCH_ROWS 4       // thread row in the high byte, feed in the low
+#define SETTINGS_WORD_METRIC_ROWS 5     // thread row in the high byte, feed in the low
+#define SETTINGS_WORD_RESERVED 6
+#define SETTINGS_WORD_CRC 7
+
+// Flags
+#define SETTINGS_FLAG_METRIC 1
+#define SETTINGS_FLAG_THREAD (1<<1)
+#define SETTINGS_FLAG_REVERSE (1<<2)
+
+
+typedef struct SETTINGS
+{
+    bool metric;
+    bool thread;
+    bool reverse;
+
+    // selected row in each feed table
+    Uint16 inchThreadRow;
+    Uint16 inchFeedRow;
+    Uint16 metricThreadRow;
+    Uint16 metricFeedRow;
+} SETTINGS;
+
+
+//
+// Settings journal
+//
+// Settings are never rewritten in place.  Each save appends a one-page
+// record with an incrementing sequence number and a CRC to the next page of
+// a ring, so wear is spread evenly across every page in the ring.  On boot,
+// the newest record with a valid CRC is the current settings; a record torn
+// by a power loss during the write simply fails its CRC, and the previous one
+// is used instead.
+//
+// Records are written through the EEPROM cache.  While the newest record is
+// still waiting in the cache, a new save replaces it rather than taking
+// another page, so a burst of changes ends up as one record.
+//
+class SettingsJournal
+{
+private:
+    EEPROM *eeprom;
+    EEPROMCache *cache;
+
+    // page and sequence number of the newest valid record
+    Uint16 newestPage;
+    Uint32 newestSequence;
+    bool found;
+
+    bool isValid(const Uint16 *record);
+    Uint32 getSequence(const Uint16 *record);
+
+public:
+    SettingsJournal(EEPROM *eeprom, EEPROMCache *cache);
+
+    // scan the ring for the newest valid record; returns false if there is none
+    bool load(SETTINGS *settings);
+
+    // put a new record in the cache, to be appended to the ring once the
+    // settings stop changing; returns false if the cache is full and the save
+    // should be retried later
+    bool save(const SETTINGS *settings);
+
+    // write the newest record right away, without waiting for the settings to
+    // settle, as when the power is being turned off
+    void flush(void);
+};
+
+
+#endif // __SETTINGS_JOURNAL_H
@@ -34,11 +34,23 @@ StepperDrive :: StepperDrive(void)
     //
     this->currentPosition = 0;
     this->desiredPosition = 0;
+    this->positionOffset = 0;
 
     //
     // State machine starts at state zero
     //
     this->state = 0;
+
+    this->backlogLimit = MAX_BUFFERED_STEPS;
+
+    //
+    // No soft limits until they're set
+    //
+    this->useMinLimit = false;
+    this->useMaxLimit = false;
+    this->minLimit = 0;
+    this->maxLimit = 0;
+    this->limited = false;
 }
 
 void StepperDrive :: initHardware(void)
@@ -68,8 +80,38 @@ void StepperDrive :: initHardware(void)
     setEnabled(true);
 }
 
+void StepperDrive :: setMinLimit(bool enabled, int32 position)
+{
+    // the ISR only looks at the position once the limit is on
+    this->useMinLimit = false;
+    this->minLimit = position;
+    this->useMinLimit = enabled;
+}
 
+void StepperDrive :: setMaxLimit(bool enabled, int32 position)
+{
+    this->useMaxLimit = false;
+    this->maxLimit = position;
+    this->useMaxLimit = enabled;
+}
 
+bool StepperDrive :: getMinLimit(int32 *position)
+{
+    *position = this->minLimit;
+    return this->useMinLimit;
+}
 
+bool StepperDrive :: getMaxLimit(int32 *position)
+{
+    *position = this->maxLimit;
+    return this->useMaxLimit;
+}
 
-
+bool StepperDrive :: checkLimit(void)
+{
+    if( this->limited ) {
+        this->limited = false;
+        return true;
+    }
+    return false;
+}
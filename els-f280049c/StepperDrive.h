@@ -84,6 +84,13 @@ private:
     //
     int32 desiredPosition;
 
+    //
+    // Accumulated shifts of the current position that did not move the motor
+    // (encoder wrap compensation, resync), so the carriage position can be
+    // recovered from the current position
+    //
+    int32 positionOffset;
+
     //
     // current state-machine state
     // bit 0 - step signal
@@ -96,6 +103,21 @@ private:
     //
     bool enabled;
 
+    //
+    // Largest backlog before the drive trips
+    //
+    int32 backlogLimit;
+
+    //
+    // Soft limits on the carriage position, in steps, and whether the desired
+    // position has been held at one since the last check
+    //
+    volatile bool useMinLimit;
+    volatile bool useMaxLimit;
+    volatile int32 minLimit;
+    volatile int32 maxLimit;
+    volatile bool limited;
+
 public:
     StepperDrive();
     void initHardware(void);
@@ -106,7 +128,25 @@ public:
 
     bool checkStepBacklog();
 
+    int32 getBacklogLimit(void);
+    void setBacklogLimit(int32 limit);
+
+    // soft limits on the carriage position, in steps; the carriage stops at a
+    // limit and picks up in sync again once the spindle brings it back
+    void setMinLimit(bool enabled, int32 position);
+    void setMaxLimit(bool enabled, int32 position);
+    bool getMinLimit(int32 *position);
+    bool getMaxLimit(int32 *position);
+
+    // true if the carriage has been held at a soft limit since the last call
+    bool checkLimit(void);
+    bool isLimited(void);
+
+    int32 getCarriagePosition(void);
+    int32 getBacklog(void);
+
     void setEnabled(bool);
+    bool isEnabled(void);
 
     bool isAlarm();
 
@@ -115,22 +155,45 @@ public:
 
 inline void StepperDrive :: setDesiredPosition(int32 steps)
 {
+    // hold the carriage inside the soft limits without touching the offset,
+    // so it stays in phase with the spindle while it waits
+    if( this->useMinLimit && steps - this->positionOffset < this->minLimit ) {
+        steps = this->minLimit + this->positionOffset;
+        this->limited = true;
+    }
+    if( this->useMaxLimit && steps - this->positionOffset > this->maxLimit ) {
+        steps = this->maxLimit + this->positionOffset;
+        this->limited = true;
+    }
+
     this->desiredPosition = steps;
 }
 
 inline void StepperDrive :: incrementCurrentPosition(int32 increment)
 {
     this->currentPosition += increment;
+    this->positionOffset += increment;
 }
 
 inline void StepperDrive :: setCurrentPosition(int32 position)
 {
+    this->positionOffset += position - this->currentPosition;
     this->currentPosition = position;
 }
 
+inline int32 StepperDrive :: getCarriagePosition(void)
+{
+    return this->currentPosition - this->positionOffset;
+}
+
+inline int32 StepperDrive :: getBacklog(void)
+{
+    return this->desiredPosition - this->currentPosition;
+}
+
 inline bool StepperDrive :: checkStepBacklog()
 {
-    if( abs(this->desiredPosition - this->currentPosition) > MAX_BUFFERED_STEPS ) {
+    if( labs(this->desiredPosition - this->currentPosition) > this->backlogLimit ) {
         setEnabled(false);
         return true;
     }
@@ -149,6 +212,26 @@ inline void StepperDrive :: setEnabled(bool enabled)
     }
 }
 
+inline int32 StepperDrive :: getBacklogLimit(void)
+{
+    return this->backlogLimit;
+}
+
+inline void StepperDrive :: setBacklogLimit(int32 limit)
+{
+    this->backlogLimit = limit;
+}
+
+inline bool StepperDrive :: isLimited(void)
+{
+    return this->limited;
+}
+
+inline bool StepperDrive :: isEnabled(void)
+{
+    return this->enabled;
+}
+
 inline bool StepperDrive :: isAlarm()
 {
 #ifdef USE_ALARM_PIN
@@ -206,6 +289,7 @@ inline void StepperDrive :: ISR(void)
 
     } else {
         // not enabled; just keep current position in sync
+        this->positionOffset += this->desiredPosition - this->currentPosition;
         this->currentPosition = this->desiredPosition;
     }
 }
@@ -0,0 +1,69 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SupplyMonitor.h"
+
+
+SupplyMonitor :: SupplyMonitor(void)
+{
+    this->lowCount = 0;
+}
+
+void SupplyMonitor :: initHardware(void)
+{
+    SetVREF(ADC_ADCB, ADC_INTERNAL, ADC_VREF3P3);
+
+    EALLOW;
+    AdcbRegs.ADCCTL2.bit.PRESCALE = 6;                      // ADCCLK = SYSCLK/4
+    AdcbRegs.ADCCTL1.bit.ADCPWDNZ = 1;                      // power up
+    AdcbRegs.ADCSOC0CTL.bit.CHSEL = BROWNOUT_ADC_CHANNEL;
+    AdcbRegs.ADCSOC0CTL.bit.ACQPS = 30;                     // 31 SYSCLK cycles
+    AdcbRegs.ADCSOC0CTL.bit.TRIGSEL = 0;                    // software only
+    EDIS;
+
+    DELAY_US(1000);                                         // ADC power-up time
+
+    // start the first conversion
+    AdcbRegs.ADCSOCFRC1.bit.SOC0 = 1;
+}
+
+bool SupplyMonitor :: isLow(void)
+{
+    // the conversion started last time finished long ago
+    Uint16 reading = AdcbResultRegs.ADCRESULT0;
+    AdcbRegs.ADCSOCFRC1.bit.SOC0 = 1;
+
+    if( reading < BROWNOUT_THRESHOLD )
+    {
+        if( this->lowCount < BROWNOUT_LOW_SAMPLES ) this->lowCount++;
+    }
+    else
+    {
+        this->lowCount = 0;
+    }
+
+    return this->lowCount >= BROWNOUT_LOW_SAMPLES;
+}
@@ -0,0 +1,63 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __SUPPLY_MONITOR_H
+#define __SUPPLY_MONITOR_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+
+
+// Consecutive low readings needed to declare a brown-out, to ride out noise
+#define BROWNOUT_LOW_SAMPLES 3
+
+
+//
+// Supply voltage monitor
+//
+// Samples the supply voltage through ADC-B from the background loop, so
+// anything that must survive a power loss can be saved while the regulator
+// is still holding the processor up.
+//
+class SupplyMonitor
+{
+private:
+    // consecutive readings below the threshold
+    Uint16 lowCount;
+
+public:
+    SupplyMonitor(void);
+
+    // initialize the hardware for operation
+    void initHardware(void);
+
+    // take a reading; returns true once the supply has dropped below the
+    // threshold
+    bool isLow(void);
+};
+
+
+#endif // __SUPPLY_MONITOR_H
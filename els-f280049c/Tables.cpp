@@ -25,12 +25,13 @@
 
 
 #include "Tables.h"
+#include "CRC.h"
 
 
 //
 // INCH THREAD DEFINITIONS
 //
-// Each row in the table defines a standard imperial thread, with the display data,
+// Each row in the table defines a standard imperial thread, with the display label,
 // LED indicator states and gear ratio fraction to use.
 //
 #if defined(LEADSCREW_TPI)
@@ -41,35 +42,35 @@
 #define TPI_NUMERATOR(tpi) ((Uint64)254*100*STEPPER_RESOLUTION*STEPPER_MICROSTEPS)
 #define TPI_DENOMINATOR(tpi) ((Uint64)tpi*ENCODER_RESOLUTION*LEADSCREW_HMM)
 #endif
-#define TPI_FRACTION(tpi) .numerator = TPI_NUMERATOR(tpi), .denominator = TPI_DENOMINATOR(tpi)
+#define TPI_FRACTION(tpi) REDUCED_FRACTION(TPI_NUMERATOR(tpi), TPI_DENOMINATOR(tpi))
 
 const FEED_THREAD inch_thread_table[] =
 {
- { .display = {BLANK, BLANK, BLANK, EIGHT}, .leds = LED_THREAD | LED_TPI, TPI_FRACTION(80) },
- { .display = {BLANK, BLANK, BLANK, NINE},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(90) },
- { .display = {BLANK, BLANK, ONE,   ZERO},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(100) },
- { .display = {BLANK, BLANK, ONE,   ONE},   .leds = LED_THREAD | LED_TPI, TPI_FRACTION(110) },
- { .display = {BLANK, ONE, ONE|POINT,FIVE}, .leds = LED_THREAD | LED_TPI, TPI_FRACTION(115) },
- { .display = {BLANK, BLANK, ONE,   TWO},   .leds = LED_THREAD | LED_TPI, TPI_FRACTION(120) },
- { .display = {BLANK, BLANK, ONE,   THREE}, .leds = LED_THREAD | LED_TPI, TPI_FRACTION(130) },
- { .display = {BLANK, BLANK, ONE,   FOUR},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(140) },
- { .display = {BLANK, BLANK, ONE,   SIX},   .leds = LED_THREAD | LED_TPI, TPI_FRACTION(160) },
- { .display = {BLANK, BLANK, ONE,   EIGHT}, .leds = LED_THREAD | LED_TPI, TPI_FRACTION(180) },
- { .display = {BLANK, BLANK, ONE,   NINE},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(190) },
- { .display = {BLANK, BLANK, TWO,   ZERO},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(200) },
- { .display = {BLANK, BLANK, TWO,   FOUR},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(240) },
- { .display = {BLANK, BLANK, TWO,   SIX},   .leds = LED_THREAD | LED_TPI, TPI_FRACTION(260) },
- { .display = {BLANK, BLANK, TWO,   SEVEN}, .leds = LED_THREAD | LED_TPI, TPI_FRACTION(270) },
- { .display = {BLANK, BLANK, TWO,   EIGHT}, .leds = LED_THREAD | LED_TPI, TPI_FRACTION(280) },
- { .display = {BLANK, BLANK, THREE, TWO},   .leds = LED_THREAD | LED_TPI, TPI_FRACTION(320) },
- { .display = {BLANK, BLANK, THREE, SIX},   .leds = LED_THREAD | LED_TPI, TPI_FRACTION(360) },
- { .display = {BLANK, BLANK, FOUR,  ZERO},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(400) },
- { .display = {BLANK, BLANK, FOUR,  FOUR},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(440) },
- { .display = {BLANK, BLANK, FOUR,  EIGHT}, .leds = LED_THREAD | LED_TPI, TPI_FRACTION(480) },
- { .display = {BLANK, BLANK, FIVE,  SIX},   .leds = LED_THREAD | LED_TPI, TPI_FRACTION(560) },
- { .display = {BLANK, BLANK, SIX,   FOUR},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(640) },
- { .display = {BLANK, BLANK, SEVEN, TWO},   .leds = LED_THREAD | LED_TPI, TPI_FRACTION(720) },
- { .display = {BLANK, BLANK, EIGHT, ZERO},  .leds = LED_THREAD | LED_TPI, TPI_FRACTION(800) },
+ { .label = "   8",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(80) },
+ { .label = "   9",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(90) },
+ { .label = "  10",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(100) },
+ { .label = "  11",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(110) },
+ { .label = " 11.5",    .leds = LED_THREAD | LED_TPI, TPI_FRACTION(115) },
+ { .label = "  12",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(120) },
+ { .label = "  13",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(130) },
+ { .label = "  14",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(140) },
+ { .label = "  16",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(160) },
+ { .label = "  18",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(180) },
+ { .label = "  19",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(190) },
+ { .label = "  20",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(200) },
+ { .label = "  24",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(240) },
+ { .label = "  26",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(260) },
+ { .label = "  27",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(270) },
+ { .label = "  28",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(280) },
+ { .label = "  32",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(320) },
+ { .label = "  36",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(360) },
+ { .label = "  40",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(400) },
+ { .label = "  44",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(440) },
+ { .label = "  48",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(480) },
+ { .label = "  56",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(560) },
+ { .label = "  64",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(640) },
+ { .label = "  72",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(720) },
+ { .label = "  80",     .leds = LED_THREAD | LED_TPI, TPI_FRACTION(800) },
 };
 
 
@@ -77,7 +78,7 @@ const FEED_THREAD inch_thread_table[] =
 //
 // INCH FEED DEFINITIONS
 //
-// Each row in the table defines a standard imperial feed rate, with the display data,
+// Each row in the table defines a standard imperial feed rate, with the display label,
 // LED indicator states and gear ratio fraction to use.
 //
 
@@ -89,31 +90,31 @@ const FEED_THREAD inch_thread_table[] =
 #define THOU_IN_NUMERATOR(thou) ((Uint64)thou*254*STEPPER_RESOLUTION_FEED*STEPPER_MICROSTEPS_FEED)
 #define THOU_IN_DENOMINATOR(thou) ((Uint64)ENCODER_RESOLUTION*100*LEADSCREW_HMM)
 #endif
-#define THOU_IN_FRACTION(thou) .numerator = THOU_IN_NUMERATOR(thou), .denominator = THOU_IN_DENOMINATOR(thou)
+#define THOU_IN_FRACTION(thou) REDUCED_FRACTION(THOU_IN_NUMERATOR(thou), THOU_IN_DENOMINATOR(thou))
 
 const FEED_THREAD inch_feed_table[] =
 {
- { .display = {POINT, ZERO, ZERO,  ONE},    .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(1) },
- { .display = {POINT, ZERO, ZERO,  TWO},    .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(2) },
- { .display = {POINT, ZERO, ZERO,  THREE},  .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(3) },
- { .display = {POINT, ZERO, ZERO,  FOUR},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(4) },
- { .display = {POINT, ZERO, ZERO,  FIVE},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(5) },
- { .display = {POINT, ZERO, ZERO,  SIX},    .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(6) },
- { .display = {POINT, ZERO, ZERO,  SEVEN},  .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(7) },
- { .display = {POINT, ZERO, ZERO,  EIGHT},  .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(8) },
- { .display = {POINT, ZERO, ZERO,  NINE},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(9) },
- { .display = {POINT, ZERO, ONE,   ZERO},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(10) },
- { .display = {POINT, ZERO, ONE,   ONE},    .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(11) },
- { .display = {POINT, ZERO, ONE,   TWO},    .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(12) },
- { .display = {POINT, ZERO, ONE,   THREE},  .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(13) },
- { .display = {POINT, ZERO, ONE,   FIVE},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(15) },
- { .display = {POINT, ZERO, ONE,   SEVEN},  .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(17) },
- { .display = {POINT, ZERO, TWO,   ZERO},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(20) },
- { .display = {POINT, ZERO, TWO,   THREE},  .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(23) },
- { .display = {POINT, ZERO, TWO,   SIX},    .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(26) },
- { .display = {POINT, ZERO, THREE, ZERO},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(30) },
- { .display = {POINT, ZERO, THREE, FIVE},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(35) },
- { .display = {POINT, ZERO, FOUR,  ZERO},   .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(40) },
+ { .label = ".001",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(1) },
+ { .label = ".002",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(2) },
+ { .label = ".003",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(3) },
+ { .label = ".004",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(4) },
+ { .label = ".005",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(5) },
+ { .label = ".006",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(6) },
+ { .label = ".007",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(7) },
+ { .label = ".008",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(8) },
+ { .label = ".009",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(9) },
+ { .label = ".010",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(10) },
+ { .label = ".011",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(11) },
+ { .label = ".012",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(12) },
+ { .label = ".013",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(13) },
+ { .label = ".015",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(15) },
+ { .label = ".017",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(17) },
+ { .label = ".020",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(20) },
+ { .label = ".023",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(23) },
+ { .label = ".026",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(26) },
+ { .label = ".030",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(30) },
+ { .label = ".035",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(35) },
+ { .label = ".040",     .leds = LED_FEED | LED_INCH, THOU_IN_FRACTION(40) },
 };
 
 
@@ -122,7 +123,7 @@ const FEED_THREAD inch_feed_table[] =
 //
 // METRIC THREAD DEFINITIONS
 //
-// Each row in the table defines a standard metric thread, with the display data,
+// Each row in the table defines a standard metric thread, with the display label,
 // LED indicator states and gear ratio fraction to use.
 //
 #if defined(LEADSCREW_TPI)
@@ -133,34 +134,34 @@ const FEED_THREAD inch_feed_table[] =
 #define HMM_NUMERATOR(hmm) ((Uint64)hmm*STEPPER_RESOLUTION*STEPPER_MICROSTEPS)
 #define HMM_DENOMINATOR(hmm) ((Uint64)ENCODER_RESOLUTION*LEADSCREW_HMM)
 #endif
-#define HMM_FRACTION(hmm) .numerator = HMM_NUMERATOR(hmm), .denominator = HMM_DENOMINATOR(hmm)
+#define HMM_FRACTION(hmm) REDUCED_FRACTION(HMM_NUMERATOR(hmm), HMM_DENOMINATOR(hmm))
 
 const FEED_THREAD metric_thread_table[] =
 {
- { .display = {BLANK, POINT,         TWO,   BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(20) },
- { .display = {BLANK, POINT,         TWO,   FIVE},  .leds = LED_THREAD | LED_MM, HMM_FRACTION(25) },
- { .display = {BLANK, POINT,         THREE, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(30) },
- { .display = {BLANK, POINT,         THREE, FIVE},  .leds = LED_THREAD | LED_MM, HMM_FRACTION(35) },
- { .display = {BLANK, POINT,         FOUR,  BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(40) },
- { .display = {BLANK, POINT,         FOUR,  FIVE},  .leds = LED_THREAD | LED_MM, HMM_FRACTION(45) },
- { .display = {BLANK, POINT,         FIVE,  BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(50) },
- { .display = {BLANK, POINT,         SIX,   BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(60) },
- { .display = {BLANK, POINT,         SEVEN, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(70) },
- { .display = {BLANK, POINT,         SEVEN, FIVE},  .leds = LED_THREAD | LED_MM, HMM_FRACTION(75) },
- { .display = {BLANK, POINT,         EIGHT, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(80) },
- { .display = {BLANK, ONE,           BLANK, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(100) },
- { .display = {BLANK, ONE | POINT,   TWO,   FIVE},  .leds = LED_THREAD | LED_MM, HMM_FRACTION(125) },
- { .display = {BLANK, ONE | POINT,   FIVE,  BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(150) },
- { .display = {BLANK, ONE | POINT,   SEVEN, FIVE},  .leds = LED_THREAD | LED_MM, HMM_FRACTION(175) },
- { .display = {BLANK, TWO,           BLANK, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(200) },
- { .display = {BLANK, TWO | POINT,   FIVE,  BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(250) },
- { .display = {BLANK, THREE,         BLANK, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(300) },
- { .display = {BLANK, THREE | POINT, FIVE,  BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(350) },
- { .display = {BLANK, FOUR,          BLANK, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(400) },
- { .display = {BLANK, FOUR | POINT,  FIVE,  BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(450) },
- { .display = {BLANK, FIVE,          BLANK, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(500) },
- { .display = {BLANK, FIVE | POINT,  FIVE,  BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(550) },
- { .display = {BLANK, SIX,           BLANK, BLANK}, .leds = LED_THREAD | LED_MM, HMM_FRACTION(600) },
+ { .label = " .2 ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(20) },
+ { .label = " .25",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(25) },
+ { .label = " .3 ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(30) },
+ { .label = " .35",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(35) },
+ { .label = " .4 ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(40) },
+ { .label = " .45",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(45) },
+ { .label = " .5 ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(50) },
+ { .label = " .6 ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(60) },
+ { .label = " .7 ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(70) },
+ { .label = " .75",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(75) },
+ { .label = " .8 ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(80) },
+ { .label = " 1  ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(100) },
+ { .label = " 1.25",    .leds = LED_THREAD | LED_MM, HMM_FRACTION(125) },
+ { .label = " 1.5 ",    .leds = LED_THREAD | LED_MM, HMM_FRACTION(150) },
+ { .label = " 1.75",    .leds = LED_THREAD | LED_MM, HMM_FRACTION(175) },
+ { .label = " 2  ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(200) },
+ { .label = " 2.5 ",    .leds = LED_THREAD | LED_MM, HMM_FRACTION(250) },
+ { .label = " 3  ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(300) },
+ { .label = " 3.5 ",    .leds = LED_THREAD | LED_MM, HMM_FRACTION(350) },
+ { .label = " 4  ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(400) },
+ { .label = " 4.5 ",    .leds = LED_THREAD | LED_MM, HMM_FRACTION(450) },
+ { .label = " 5  ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(500) },
+ { .label = " 5.5 ",    .leds = LED_THREAD | LED_MM, HMM_FRACTION(550) },
+ { .label = " 6  ",     .leds = LED_THREAD | LED_MM, HMM_FRACTION(600) },
 };
 
 
@@ -168,7 +169,7 @@ const FEED_THREAD metric_thread_table[] =
 //
 // METRIC FEED DEFINITIONS
 //
-// Each row in the table defines a standard metric feed, with the display data,
+// Each row in the table defines a standard metric feed, with the display label,
 // LED indicator states and gear ratio fraction to use.
 //
 #if defined(LEADSCREW_TPI)
@@ -179,37 +180,194 @@ const FEED_THREAD metric_thread_table[] =
 #define HMM_NUMERATOR_FEED(hmm) ((Uint64)hmm*STEPPER_RESOLUTION_FEED*STEPPER_MICROSTEPS_FEED)
 #define HMM_DENOMINATOR_FEED(hmm) ((Uint64)ENCODER_RESOLUTION*LEADSCREW_HMM)
 #endif
-#define HMM_FRACTION_FEED(hmm) .numerator = HMM_NUMERATOR_FEED(hmm), .denominator = HMM_DENOMINATOR_FEED(hmm)
+#define HMM_FRACTION_FEED(hmm) REDUCED_FRACTION(HMM_NUMERATOR_FEED(hmm), HMM_DENOMINATOR_FEED(hmm))
 
 const FEED_THREAD metric_feed_table[] =
 {
- { .display = {BLANK, POINT,       ZERO,  TWO},   .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(2) },
- { .display = {BLANK, POINT,       ZERO,  FIVE},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(5) },
- { .display = {BLANK, POINT,       ZERO,  SEVEN}, .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(7) },
- { .display = {BLANK, POINT,       ONE,   ZERO},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(10) },
- { .display = {BLANK, POINT,       ONE,   TWO},   .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(12) },
- { .display = {BLANK, POINT,       ONE,   FIVE},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(15) },
- { .display = {BLANK, POINT,       ONE,   SEVEN}, .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(17) },
- { .display = {BLANK, POINT,       TWO,   ZERO},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(20) },
- { .display = {BLANK, POINT,       TWO,   TWO},   .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(22) },
- { .display = {BLANK, POINT,       TWO,   FIVE},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(25) },
- { .display = {BLANK, POINT,       TWO,   SEVEN}, .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(27) },
- { .display = {BLANK, POINT,       THREE, ZERO},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(30) },
- { .display = {BLANK, POINT,       THREE, FIVE},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(35) },
- { .display = {BLANK, POINT,       FOUR,  ZERO},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(40) },
- { .display = {BLANK, POINT,       FOUR,  FIVE},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(45) },
- { .display = {BLANK, POINT,       FIVE,  ZERO},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(50) },
- { .display = {BLANK, POINT,       FIVE,  FIVE},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(55) },
- { .display = {BLANK, POINT,       SIX,   ZERO},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(60) },
- { .display = {BLANK, POINT,       SEVEN, ZERO},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(70) },
- { .display = {BLANK, POINT,       EIGHT, FIVE},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(85) },
- { .display = {BLANK, ONE | POINT, ZERO,  ZERO},  .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(100) },
+ { .label = " .02",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(2) },
+ { .label = " .05",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(5) },
+ { .label = " .07",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(7) },
+ { .label = " .10",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(10) },
+ { .label = " .12",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(12) },
+ { .label = " .15",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(15) },
+ { .label = " .17",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(17) },
+ { .label = " .20",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(20) },
+ { .label = " .22",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(22) },
+ { .label = " .25",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(25) },
+ { .label = " .27",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(27) },
+ { .label = " .30",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(30) },
+ { .label = " .35",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(35) },
+ { .label = " .40",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(40) },
+ { .label = " .45",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(45) },
+ { .label = " .50",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(50) },
+ { .label = " .55",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(55) },
+ { .label = " .60",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(60) },
+ { .label = " .70",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(70) },
+ { .label = " .85",     .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(85) },
+ { .label = " 1.00",    .leds = LED_FEED | LED_MM, HMM_FRACTION_FEED(100) },
 };
 
 
 
 
 
+//
+// USER TABLE DEFINITIONS
+//
+// Rows loaded from the EEPROM image get the same labels, LED indicator states
+// and gear ratio fractions as the built-in rows above.  Labels are laid out on
+// four display cells, with the decimal point sharing a cell with the digit
+// before it.
+//
+#define LABEL_CELLS 4
+#define LABEL_FIXED 0           // keep trailing zeros: " .50"
+#define LABEL_BLANK_ZEROS 1     // blank trailing zeros in place: " .5 "
+#define LABEL_TRIM_ZEROS 2      // drop trailing zeros and right-justify: "  12"
+
+typedef struct TABLE_FORMAT
+{
+    Uint16 decimals;
+    Uint16 style;
+    Uint16 leds;
+} TABLE_FORMAT;
+
+// In image order
+const TABLE_FORMAT table_formats[TABLES_COUNT] =
+{
+ { .decimals = 1, .style = LABEL_TRIM_ZEROS,  .leds = LED_THREAD | LED_TPI },  // TPI x 10
+ { .decimals = 3, .style = LABEL_FIXED,       .leds = LED_FEED | LED_INCH },   // thou
+ { .decimals = 2, .style = LABEL_BLANK_ZEROS, .leds = LED_THREAD | LED_MM },   // hmm
+ { .decimals = 2, .style = LABEL_FIXED,       .leds = LED_FEED | LED_MM },     // hmm
+};
+
+// Rows of the loaded tables; too big for the regular data section
+#pragma DATA_SECTION(user_rows, "ramgs0")
+FEED_THREAD user_rows[TABLES_MAX_ROWS];
+
+static void formatLabel(char *label, Uint16 size, Uint16 value, const TABLE_FORMAT *format)
+{
+    char digits[8];
+    char text[8];
+    Uint16 numDigits = 0;
+    Uint16 decimals = format->decimals;
+    Uint16 length = 0;
+    Uint16 i;
+
+    // digits of the value, least significant first, with at least one digit
+    // before the point; this only runs at startup, so dividing is fine
+    do
+    {
+        digits[numDigits++] = '0' + value % 10;
+        value /= 10;
+    } while( value > 0 );
+    while( numDigits <= decimals )
+    {
+        digits[numDigits++] = '0';
+    }
+
+    // a zero before the point isn't shown: ".001"
+    Uint16 intDigits = numDigits - decimals;
+    if( intDigits == 1 && digits[decimals] == '0' )
+    {
+        intDigits = 0;
+    }
+
+    Uint16 zeros = 0;
+    while( zeros < decimals && digits[zeros] == '0' )
+    {
+        zeros++;
+    }
+
+    Uint16 fracDigits = (format->style == LABEL_FIXED) ? decimals : decimals - zeros;
+    Uint16 blanks = (format->style == LABEL_BLANK_ZEROS) ? zeros : 0;
+
+    for( i = 0; i < intDigits; i++ )
+    {
+        text[length++] = digits[numDigits - 1 - i];
+    }
+    if( fracDigits > 0 )
+    {
+        text[length++] = '.';
+    }
+    for( i = 0; i < fracDigits; i++ )
+    {
+        text[length++] = digits[decimals - 1 - i];
+    }
+    for( i = 0; i < blanks; i++ )
+    {
+        text[length++] = ' ';
+    }
+
+    // a point with no digit before it takes a cell of its own
+    Uint16 cells = intDigits + fracDigits + blanks;
+    if( intDigits == 0 && fracDigits > 0 )
+    {
+        cells++;
+    }
+
+    if( cells > LABEL_CELLS || LABEL_CELLS - cells + length >= size )
+    {
+        // too long to show
+        for( i = 0; i < LABEL_CELLS; i++ )
+        {
+            *label++ = '-';
+        }
+    }
+    else
+    {
+        for( i = cells; i < LABEL_CELLS; i++ )
+        {
+            *label++ = ' ';
+        }
+        for( i = 0; i < length; i++ )
+        {
+            *label++ = text[i];
+        }
+    }
+    *label = 0;
+}
+
+static bool buildRow(FEED_THREAD *row, Uint16 table, Uint16 value)
+{
+    FEED_THREAD built;
+
+    if( value == 0 )
+    {
+        return false;
+    }
+
+    formatLabel(built.label, sizeof(built.label), value, &table_formats[table]);
+    built.leds.all = table_formats[table].leds;
+
+    // user rows can't be checked at compile time; any that don't fit 32-bit
+    // math take the slower 64-bit path in the core
+    switch( table )
+    {
+    case 0:
+        setRatio(&built, TPI_NUMERATOR(value), TPI_DENOMINATOR(value));
+        break;
+    case 1:
+        setRatio(&built, THOU_IN_NUMERATOR(value), THOU_IN_DENOMINATOR(value));
+        break;
+    case 2:
+        setRatio(&built, HMM_NUMERATOR(value), HMM_DENOMINATOR(value));
+        break;
+    case 3:
+        setRatio(&built, HMM_NUMERATOR_FEED(value), HMM_DENOMINATOR_FEED(value));
+        break;
+    }
+
+    // leave the row as it was if the new one can't be used
+    if( ! ratioInRange(built.numerator, built.denominator) )
+    {
+        return false;
+    }
+    *row = built;
+    return true;
+}
+
+
+
 FeedTable::FeedTable(const FEED_THREAD *table, Uint16 numRows, Uint16 defaultSelection)
 {
     this->table = table;
@@ -240,12 +398,125 @@ const FEED_THREAD *FeedTable :: previous(void)
     return this->current();
 }
 
-FeedTableFactory::FeedTableFactory(void):
+Uint16 FeedTable :: getSelectedRow(void)
+{
+    return this->selectedRow;
+}
+
+bool FeedTable :: setSelectedRow(Uint16 row)
+{
+    if( row >= this->numRows )
+    {
+        return false;
+    }
+    this->selectedRow = row;
+    return true;
+}
+
+void FeedTable :: setTable(const FEED_THREAD *table, Uint16 numRows, Uint16 defaultSelection)
+{
+    this->table = table;
+    this->numRows = numRows;
+    this->selectedRow = defaultSelection;
+}
+
+FeedTableFactory::FeedTableFactory(EEPROM *eeprom):
         inchThreads(inch_thread_table, sizeof(inch_thread_table)/sizeof(inch_thread_table[0]), 12),
         inchFeeds(inch_feed_table, sizeof(inch_feed_table)/sizeof(inch_feed_table[0]), 4),
         metricThreads(metric_thread_table, sizeof(metric_thread_table)/sizeof(metric_thread_table[0]), 6),
         metricFeeds(metric_feed_table, sizeof(metric_feed_table)/sizeof(metric_feed_table[0]), 4)
 {
+    this->eeprom = eeprom;
+    this->loaded = false;
+}
+
+FeedTable *FeedTableFactory::getFeedTable(Uint16 index)
+{
+    switch( index )
+    {
+    case 0: return &this->inchThreads;
+    case 1: return &this->inchFeeds;
+    case 2: return &this->metricThreads;
+    default: return &this->metricFeeds;
+    }
+}
+
+bool FeedTableFactory::loadTables(void)
+{
+    Uint16 header[TABLES_HEADER_WORDS];
+    Uint16 tableHeaders[TABLES_COUNT];
+    Uint16 crc = CRC16_INIT;
+    Uint16 numRows = 0;
+    Uint16 word;
+    bool valid;
+
+    // the rows are built as they are read, and only used if the whole image
+    // turns out to be valid
+    eeprom->beginRead(EEPROM_PAGE_ADDRESS(TABLES_FIRST_PAGE));
+    eeprom->readNext(TABLES_HEADER_WORDS, header);
+    crc = crc16(crc, header, TABLES_HEADER_WORDS);
+
+    valid = header[0] == TABLES_MAGIC &&
+            header[1] >= TABLES_OVERHEAD &&
+            header[1] <= TABLES_MAX_ROWS + TABLES_OVERHEAD;
+
+    for( Uint16 table = 0; valid && table < TABLES_COUNT; table++ )
+    {
+        eeprom->readNext(1, &tableHeaders[table]);
+        crc = crc16(crc, &tableHeaders[table], 1);
+
+        Uint16 rows = tableHeaders[table] >> 8;
+        Uint16 defaultRow = tableHeaders[table] & 0xFF;
+
+        if( numRows + rows + TABLES_OVERHEAD > header[1] || (rows > 0 && defaultRow >= rows) )
+        {
+            valid = false;
+            break;
+        }
+
+        for( Uint16 i = 0; i < rows; i++ )
+        {
+            eeprom->readNext(1, &word);
+            crc = crc16(crc, &word, 1);
+
+            if( ! buildRow(&user_rows[numRows++], table, word) )
+            {
+                valid = false;
+                break;
+            }
+        }
+    }
+
+    if( valid && numRows + TABLES_OVERHEAD == header[1] )
+    {
+        eeprom->readNext(1, &word);
+        valid = (word == crc);
+    }
+    else
+    {
+        valid = false;
+    }
+    eeprom->endRead();
+
+    if( valid )
+    {
+        Uint16 first = 0;
+
+        for( Uint16 table = 0; table < TABLES_COUNT; table++ )
+        {
+            Uint16 rows = tableHeaders[table] >> 8;
+
+            // an empty table keeps the built-in one
+            if( rows > 0 )
+            {
+                getFeedTable(table)->setTable(&user_rows[first], rows, tableHeaders[table] & 0xFF);
+                first += rows;
+            }
+        }
+    }
+
+    this->loaded = valid;
+    return valid;
 }
 
 FeedTable *FeedTableFactory::getFeedTable(bool metric, bool thread)
@@ -274,3 +545,47 @@ FeedTable *FeedTableFactory::getFeedTable(bool metric, bool thread)
     }
 
 }
+
+Uint16 FeedTableFactory::tableIndex(bool metric, bool thread)
+{
+    // image order
+    return (metric ? 2 : 0) + (thread ? 0 : 1);
+}
+
+Uint16 FeedTableFactory::getDecimals(bool metric, bool thread)
+{
+    return table_formats[tableIndex(metric, thread)].decimals;
+}
+
+Uint16 FeedTableFactory::getValue(bool metric, bool thread, const FEED_THREAD *row)
+{
+    Uint16 decimals = getDecimals(metric, thread);
+    Uint16 value = 0;
+    Uint16 fraction = 0;
+    bool point = false;
+
+    // digits before the point, then as many after it as there are
+    for( const char *p = row->label; *p != 0; p++ )
+    {
+        if( *p == '.' )
+        {
+            point = true;
+        }
+        else if( *p >= '0' && *p <= '9' && (! point || fraction < decimals) )
+        {
+            value = value * 10 + (*p - '0');
+            if( point ) fraction++;
+        }
+    }
+    for( ; fraction < decimals; fraction++ )
+    {
+        value *= 10;
+    }
+
+    return value;
+}
+
+bool FeedTableFactory::buildFeed(bool metric, bool thread, Uint16 value, FEED_THREAD *row)
+{
+    return buildRow(row, tableIndex(metric, thread), value);
+}
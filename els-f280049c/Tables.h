@@ -29,20 +29,129 @@
 
 #include "F28x_Project.h"
 #include "Configuration.h"
-#include "ControlPanel.h"
+#include "Display.h"
+#include "EEPROM.h"
+#include "Encoder.h"
+
+
+// Pages of the EEPROM holding the user table image
+#define TABLES_FIRST_PAGE (EEPROM_PAGE_COUNT / 2)
+#define TABLES_PAGE_COUNT (EEPROM_PAGE_COUNT - TABLES_FIRST_PAGE)
+
+// Identifies a table image, and its format version
+#define TABLES_MAGIC 0x7AB1
+
+// Image layout, in words:
+//
+//   magic
+//   length of the whole image, including the CRC
+//   for each table (inch threads, inch feeds, metric threads, metric feeds):
+//       number of rows in the high byte, default row in the low byte
+//       one word per row: TPI x 10, thousandths of an inch, or hundredths of
+//       a millimeter
+//   CRC of everything before it
+//
+// A table with no rows keeps the built-in table.
+#define TABLES_HEADER_WORDS 2
+#define TABLES_COUNT 4
+#define TABLES_OVERHEAD (TABLES_HEADER_WORDS + TABLES_COUNT + 1)
+#define TABLES_MAX_ROWS (TABLES_PAGE_COUNT * EEPROM_PAGE_SIZE - TABLES_OVERHEAD)
 
 
 
 typedef struct FEED_THREAD
 {
-    Uint16 display[4];
+    char label[6];
     union LED_REG leds;
     Uint64 numerator;
     Uint64 denominator;
+    bool fits32;            // ratio can be applied with 32-bit math
 } FEED_THREAD;
 
 
 
+//
+// GEAR RATIO FRACTIONS
+//
+// Ratios are reduced to lowest terms so most of them can be applied with the
+// 32-bit split calculation in the core:
+//
+//     steps = (count / d) * n + (count % d) * n / d
+//
+// That needs (d - 1) * n to fit in 32 bits, and the result at the full encoder
+// range to fit in a signed 32-bit step count.
+//
+
+// Greatest common divisor of a compile-time ratio
+template<Uint64 A, Uint64 B>
+struct RatioGcd
+{
+    enum { value = RatioGcd<B, A % B>::value };
+};
+
+template<Uint64 A>
+struct RatioGcd<A, 0>
+{
+    enum { value = A };
+};
+
+// Reduced fraction for a compile-time table row; a row that doesn't fit the
+// 32-bit calculation fails to compile with a negative array size
+template<Uint64 N, Uint64 D>
+struct ReducedRatio
+{
+    enum
+    {
+        numerator = N / RatioGcd<N, D>::value,
+        denominator = D / RatioGcd<N, D>::value
+    };
+
+    typedef char ratio_too_large_for_32_bit_math[
+        ((Uint64)denominator - 1) * (Uint64)numerator <= 0xFFFFFFFF &&
+        (Uint64)_ENCODER_MAX_COUNT * (Uint64)numerator / (Uint64)denominator <= 0x7FFFFFFF ? 1 : -1];
+};
+
+#define REDUCED_FRACTION(n, d) \
+    ReducedRatio<(n), (d)>::numerator, \
+    ReducedRatio<(n), (d)>::denominator, \
+    true
+
+// The same, for a ratio calculated at runtime
+inline Uint64 ratioGcd(Uint64 a, Uint64 b)
+{
+    while( b != 0 )
+    {
+        Uint64 remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+inline bool ratioInRange(Uint64 numerator, Uint64 denominator)
+{
+    return denominator != 0 &&
+            (Uint64)_ENCODER_MAX_COUNT * numerator / denominator <= 0x7FFFFFFF;
+}
+
+inline bool ratioFits32(Uint64 numerator, Uint64 denominator)
+{
+    return ratioInRange(numerator, denominator) &&
+            (denominator - 1) * numerator <= 0xFFFFFFFF;
+}
+
+// Reduce a ratio calculated at runtime, and see whether it fits 32-bit math
+inline void setRatio(FEED_THREAD *row, Uint64 numerator, Uint64 denominator)
+{
+    Uint64 divisor = ratioGcd(numerator, denominator);
+
+    row->numerator = numerator / divisor;
+    row->denominator = denominator / divisor;
+    row->fits32 = ratioFits32(row->numerator, row->denominator);
+}
+
+
+
 class FeedTable
 {
 private:
@@ -56,22 +165,71 @@ public:
     const FEED_THREAD *current(void);
     const FEED_THREAD *next(void);
     const FEED_THREAD *previous(void);
+
+    Uint16 getSelectedRow(void);
+
+    // select a row; returns false, leaving the selection alone, if the table
+    // doesn't have that many rows
+    bool setSelectedRow(Uint16 row);
+
+    // switch to a different set of rows
+    void setTable(const FEED_THREAD *table, Uint16 numRows, Uint16 defaultSelection);
 };
 
 
+//
+// Feed table factory
+//
+// Starts out with the built-in tables.  loadTables() replaces them with a
+// user table image from the EEPROM, if there is a valid one, so threads can be
+// added without rebuilding the firmware.  The image is generated on a PC with
+// tools/make_tables.py.
+//
 class FeedTableFactory
 {
 private:
+    EEPROM *eeprom;
+
     FeedTable inchThreads;
     FeedTable inchFeeds;
     FeedTable metricThreads;
     FeedTable metricFeeds;
 
+    bool loaded;
+
+    FeedTable *getFeedTable(Uint16 index);
+    Uint16 tableIndex(bool metric, bool thread);
+
 public:
-    FeedTableFactory(void);
+    FeedTableFactory(EEPROM *eeprom);
+
+    // load the user tables from the EEPROM; returns false, keeping the
+    // built-in tables, if there is no valid image
+    bool loadTables(void);
+
+    // are the user tables in use?
+    bool isLoaded(void);
 
     FeedTable *getFeedTable(bool metric, bool thread);
+
+    // number of decimal places in the values of a table: TPI to 0.1, inches
+    // to 0.001 and millimeters to 0.01
+    Uint16 getDecimals(bool metric, bool thread);
+
+    // value of a row, in the units above, read back from its label
+    Uint16 getValue(bool metric, bool thread, const FEED_THREAD *row);
+
+    // build a row for any value, as a table row would be; returns false, and
+    // leaves the row alone, if the value is zero or the ratio would overflow at
+    // the full encoder range
+    bool buildFeed(bool metric, bool thread, Uint16 value, FEED_THREAD *row);
 };
 
 
+inline bool FeedTableFactory :: isLoaded(void)
+{
+    return this->loaded;
+}
+
+
 #endif // __TABLES_H
@@ -0,0 +1,111 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Telemetry.h"
+
+
+// Ring storage lives in global RAM; it's far too big for the default data section
+#pragma DATA_SECTION(telemetry_ring, "ramgs1")
+TELEMETRY_SAMPLE telemetry_ring[TELEMETRY_RING_SIZE];
+
+
+Telemetry :: Telemetry(Encoder *encoder, StepperDrive *stepperDrive, SerialPort *serialPort)
+{
+    this->encoder = encoder;
+    this->stepperDrive = stepperDrive;
+    this->serialPort = serialPort;
+
+    this->ring = telemetry_ring;
+    this->head = 0;
+    this->tail = 0;
+
+    this->enabled = true;
+    this->countdown = TELEMETRY_DIVIDER;
+    this->sequence = 0;
+    this->dropped = 0;
+
+    this->framePosition = TELEMETRY_FRAME_BYTES;
+    this->paused = false;
+}
+
+static Uint16 putWord(Uint16 *bytes, Uint16 word)
+{
+    bytes[0] = word & 0x00ff;
+    bytes[1] = word >> 8;
+    return 2;
+}
+
+static Uint16 putLong(Uint16 *bytes, Uint32 value)
+{
+    putWord(bytes, value & 0xffff);
+    putWord(bytes + 2, value >> 16);
+    return 4;
+}
+
+void Telemetry :: buildFrame(const TELEMETRY_SAMPLE *sample)
+{
+    Uint16 *bytes = this->frame;
+
+    bytes[0] = TELEMETRY_SYNC1;
+    bytes[1] = TELEMETRY_SYNC2;
+    Uint16 length = 2;
+    length += putWord(bytes + length, sample->sequence);
+    length += putLong(bytes + length, sample->spindlePosition);
+    length += putLong(bytes + length, sample->position);
+    length += putWord(bytes + length, sample->backlog);
+    length += putWord(bytes + length, sample->rpm);
+
+    // Fletcher-16 over everything after the sync bytes
+    Uint16 sum1 = 0, sum2 = 0;
+    for( Uint16 i = 2; i < length; i++ ) {
+        sum1 = (sum1 + bytes[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    bytes[length++] = sum1;
+    bytes[length++] = sum2;
+
+    this->framePosition = 0;
+}
+
+void Telemetry :: service(void)
+{
+    Uint16 space = serialPort->getWriteSpace();
+
+    while( space > 0 ) {
+        if( this->framePosition >= TELEMETRY_FRAME_BYTES ) {
+            // start on the next sample, if there is one
+            Uint16 tail = this->tail;
+            if( this->paused || tail == this->head ) {
+                return;
+            }
+            buildFrame(&this->ring[tail]);
+            this->tail = (tail + 1) & TELEMETRY_RING_MASK;
+        }
+
+        serialPort->writeByte(this->frame[this->framePosition++]);
+        space--;
+    }
+}
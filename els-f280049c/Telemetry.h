@@ -0,0 +1,184 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __TELEMETRY_H
+#define __TELEMETRY_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+#include "Encoder.h"
+#include "StepperDrive.h"
+#include "SerialPort.h"
+
+
+// Samples held between the ISR and the serial port; must be a power of two
+#define TELEMETRY_RING_SIZE 256
+#define TELEMETRY_RING_MASK (TELEMETRY_RING_SIZE - 1)
+
+// ISR ticks per sample
+#define TELEMETRY_DIVIDER (1000000 / STEPPER_CYCLE_US / TELEMETRY_RATE_HZ)
+
+// Frame layout, all fields little-endian:
+//   0  sync, 0xA5 0x5A
+//   2  sequence number, counting every sample including any dropped
+//   4  spindle encoder count
+//   8  carriage position, in steps
+//   12 backlog (desired - current), in steps
+//   14 spindle RPM
+//   16 Fletcher-16 checksum of bytes 2-15
+#define TELEMETRY_SYNC1 0xA5
+#define TELEMETRY_SYNC2 0x5A
+#define TELEMETRY_FRAME_BYTES 18
+
+
+typedef struct TELEMETRY_SAMPLE
+{
+    Uint16 sequence;
+    Uint32 spindlePosition;
+    int32 position;
+    int16 backlog;
+    Uint16 rpm;
+} TELEMETRY_SAMPLE;
+
+
+//
+// Telemetry stream
+//
+// The ISR samples the engine every TELEMETRY_DIVIDER ticks into a ring that
+// only it writes the head of, and the background loop drains it from the
+// tail into the serial port, one framed sample at a time.  Neither side ever
+// waits on the other: if the serial port falls behind the ring fills up and
+// the ISR drops samples, which shows up as a gap in the sequence numbers.
+//
+class Telemetry
+{
+private:
+    Encoder *encoder;
+    StepperDrive *stepperDrive;
+    SerialPort *serialPort;
+
+    // ring storage, with the head advanced only by the ISR and the tail only
+    // by the background loop
+    TELEMETRY_SAMPLE *ring;
+    volatile Uint16 head;
+    volatile Uint16 tail;
+
+    // ISR state
+    volatile bool enabled;
+    Uint16 countdown;
+    Uint16 sequence;
+    Uint32 dropped;
+
+    // frame being sent
+    Uint16 frame[TELEMETRY_FRAME_BYTES];
+    Uint16 framePosition;
+
+    // finish the current frame, but don't start another
+    bool paused;
+
+    void buildFrame(const TELEMETRY_SAMPLE *sample);
+
+public:
+    Telemetry(Encoder *encoder, StepperDrive *stepperDrive, SerialPort *serialPort);
+
+    // send as much as the serial port will take; call from the background loop
+    void service(void);
+
+    // stop sending at the end of the current frame, so something else can use
+    // the serial port, or carry on; samples are dropped while paused
+    void setPaused(bool paused);
+
+    // true when no frame is partly sent
+    bool isIdle(void);
+
+    // start or stop sampling
+    void setEnabled(bool enabled);
+    bool isEnabled(void);
+
+    // samples lost because the ring was full
+    Uint32 getDropped(void);
+
+    // take a sample when one is due; call from the ISR
+    void ISR(void);
+};
+
+
+inline void Telemetry :: setPaused(bool paused)
+{
+    this->paused = paused;
+}
+
+inline bool Telemetry :: isIdle(void)
+{
+    return this->framePosition >= TELEMETRY_FRAME_BYTES;
+}
+
+inline void Telemetry :: setEnabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+inline bool Telemetry :: isEnabled(void)
+{
+    return this->enabled;
+}
+
+inline Uint32 Telemetry :: getDropped(void)
+{
+    return this->dropped;
+}
+
+inline void Telemetry :: ISR(void)
+{
+    if( ! this->enabled || --this->countdown != 0 ) {
+        return;
+    }
+    this->countdown = TELEMETRY_DIVIDER;
+
+    Uint16 sequence = this->sequence++;
+    Uint16 next = (this->head + 1) & TELEMETRY_RING_MASK;
+    if( next == this->tail ) {
+        this->dropped++;
+        return;
+    }
+
+    int32 backlog = stepperDrive->getBacklog();
+    if( backlog > 32767 ) backlog = 32767;
+    if( backlog < -32767 ) backlog = -32767;
+
+    TELEMETRY_SAMPLE *sample = &this->ring[this->head];
+    sample->sequence = sequence;
+    sample->spindlePosition = encoder->getPosition();
+    sample->position = stepperDrive->getCarriagePosition();
+    sample->backlog = (int16)backlog;
+    sample->rpm = encoder->getLatestRPM();
+
+    // publish the sample only once it's complete
+    this->head = next;
+}
+
+
+#endif // __TELEMETRY_H
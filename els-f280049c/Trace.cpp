@@ -0,0 +1,231 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Trace.h"
+#include "Display.h"
+
+#ifdef USE_TRACE
+
+
+// Sample storage lives in global RAM; it's far too big for the default data section
+#pragma DATA_SECTION(trace_samples, "ramgs2")
+TRACE_SAMPLE trace_samples[TRACE_LENGTH];
+
+// Time between samples, in microseconds
+#define TRACE_SAMPLE_US ((int32)TRACE_DIVIDER * STEPPER_CYCLE_US)
+
+static const char *TRACE_REASONS[] =
+{
+    "running",
+    "step backlog",
+    "servo alarm",
+    "soft limit",
+    "requested"
+};
+
+
+Trace :: Trace(Encoder *encoder, StepperDrive *stepperDrive, Core *core, SerialPort *serialPort)
+{
+    this->encoder = encoder;
+    this->stepperDrive = stepperDrive;
+    this->core = core;
+    this->serialPort = serialPort;
+
+    this->samples = trace_samples;
+    this->next = 0;
+    this->count = 0;
+    this->countdown = TRACE_DIVIDER;
+
+    this->reason = TRACE_RUNNING;
+    this->armRequested = false;
+
+    this->reported = false;
+    this->dumping = false;
+    this->dumpLine = 0;
+    this->linePosition = 0;
+    this->lineLength = 0;
+}
+
+void Trace :: freeze(Uint16 reason)
+{
+    if( this->reason == TRACE_RUNNING ) {
+        this->reason = reason;
+    }
+}
+
+void Trace :: arm(void)
+{
+    this->armRequested = true;
+}
+
+void Trace :: restart(void)
+{
+    // the ISR leaves a frozen trace alone, so everything can be reset before
+    // handing it back
+    this->next = 0;
+    this->count = 0;
+    this->countdown = TRACE_DIVIDER;
+    this->reported = false;
+    this->dumping = false;
+    this->armRequested = false;
+    this->reason = TRACE_RUNNING;
+}
+
+void Trace :: update(void)
+{
+    if( ! isFrozen() ) {
+        // nothing to wait for
+        this->armRequested = false;
+        return;
+    }
+
+    // keep the samples until they have been sent
+    if( ! this->reported || this->dumping ) {
+        return;
+    }
+
+    // reaching a soft limit is a routine stop, and mustn't use up the trace
+    // for a fault that comes later
+    if( this->armRequested || (this->reason == TRACE_LIMIT && ! stepperDrive->isLimited()) ) {
+        restart();
+    }
+}
+
+bool Trace :: getSample(Uint16 age, TRACE_SAMPLE *sample)
+{
+    if( age >= this->count ) {
+        return false;
+    }
+
+    *sample = this->samples[(this->next - 1 - age) & TRACE_MASK];
+    return true;
+}
+
+void Trace :: dump(void)
+{
+    this->dumping = true;
+    this->dumpLine = 0;
+    this->linePosition = 0;
+    this->lineLength = 0;
+}
+
+static char *appendText(char *p, const char *text)
+{
+    while( *text ) {
+        *p++ = *text++;
+    }
+    return p;
+}
+
+static char *appendNumber(char *p, int32 value)
+{
+    char digits[DISPLAY_MAX_DIGITS + 2];
+    Display::formatNumber(digits, DISPLAY_MAX_DIGITS, value, 0);
+
+    // drop the padding the display wants
+    char *d = digits;
+    while( *d == ' ' ) {
+        d++;
+    }
+    return appendText(p, d);
+}
+
+bool Trace :: buildLine(void)
+{
+    char *p = this->line;
+
+    if( this->dumpLine == 0 ) {
+        // what happened, and how the samples are spaced
+        p = appendText(p, "# trace ");
+        p = appendText(p, TRACE_REASONS[this->reason]);
+        p = appendText(p, ", ");
+        p = appendNumber(p, this->count);
+        p = appendText(p, " samples every ");
+        p = appendNumber(p, TRACE_SAMPLE_US);
+        p = appendText(p, "us");
+    }
+    else if( this->dumpLine == 1 ) {
+        p = appendText(p, "time_us,spindle_travel,step_travel,backlog,feed");
+    }
+    else {
+        // oldest first
+        if( this->dumpLine - 2 >= this->count ) {
+            return false;
+        }
+        Uint16 age = this->count - 1 - (this->dumpLine - 2);
+
+        TRACE_SAMPLE sample, older;
+        getSample(age, &sample);
+        if( ! getSample(age + 1, &older) ) {
+            older = sample;
+        }
+
+        // the newest sample was taken at time zero; counts are differenced in
+        // 16 bits, so the wrap of the low halves takes care of itself
+        p = appendNumber(p, -(int32)age * TRACE_SAMPLE_US);
+        *p++ = ',';
+        p = appendNumber(p, (int16)(sample.spindle - older.spindle));
+        *p++ = ',';
+        p = appendNumber(p, (int16)(sample.position - older.position));
+        *p++ = ',';
+        p = appendNumber(p, sample.backlog);
+        *p++ = ',';
+        p = appendNumber(p, sample.feed);
+    }
+
+    *p++ = '\r';
+    *p++ = '\n';
+    this->lineLength = p - this->line;
+    this->linePosition = 0;
+    this->dumpLine++;
+    return true;
+}
+
+void Trace :: service(void)
+{
+    // send the trace out once, as soon as it freezes
+    if( isFrozen() && ! this->reported ) {
+        this->reported = true;
+        dump();
+    }
+
+    if( ! this->dumping ) {
+        return;
+    }
+
+    Uint16 space = serialPort->getWriteSpace();
+    while( space > 0 ) {
+        if( this->linePosition >= this->lineLength && ! buildLine() ) {
+            this->dumping = false;
+            return;
+        }
+
+        serialPort->writeByte(this->line[this->linePosition++]);
+        space--;
+    }
+}
+
+#endif // USE_TRACE
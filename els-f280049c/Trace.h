@@ -0,0 +1,217 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include "F28x_Project.h"
+#include "Configuration.h"
+#include "Encoder.h"
+#include "StepperDrive.h"
+#include "Core.h"
+#include "SerialPort.h"
+
+
+// Samples kept; must be a power of two
+#define TRACE_LENGTH 2048
+#define TRACE_MASK (TRACE_LENGTH - 1)
+
+// Why the trace froze
+#define TRACE_RUNNING 0
+#define TRACE_BACKLOG 1             // step backlog over the limit
+#define TRACE_ALARM 2               // servo alarm while the drive was enabled
+#define TRACE_LIMIT 3               // carriage held at a soft limit
+#define TRACE_REQUESTED 4           // frozen by freeze()
+
+// Longest line of the dump, including the terminator
+#define TRACE_LINE_LENGTH 64
+
+
+// One trace sample.  Only the low 16 bits of the counts are kept, which is
+// plenty to tell how far things moved from one sample to the next.
+typedef struct TRACE_SAMPLE
+{
+    Uint16 spindle;                 // spindle encoder count
+    Uint16 position;                // carriage position, in steps
+    int16 backlog;                  // desired - current, in steps
+    Uint16 feed;                    // generation of the feed parameters
+} TRACE_SAMPLE;
+
+
+//
+// Post-mortem trace
+//
+// Records the engine every TRACE_DIVIDER ISR cycles into a circular buffer,
+// and stops recording the moment the step backlog trips, the servo alarm
+// asserts or the carriage reaches a soft limit, so the buffer ends with
+// whatever led up to it: a jump in the spindle count, a change of feed, or a
+// backlog that built up steadily.
+//
+// Once frozen, the trace is sent out of the serial port once as CSV, and can
+// be read back one sample at a time for the display.  It starts recording
+// again when asked to by arm(), or by itself once the soft limit that froze it
+// has cleared, but never before the dump has gone out.
+//
+class Trace
+{
+private:
+    Encoder *encoder;
+    StepperDrive *stepperDrive;
+    Core *core;
+    SerialPort *serialPort;
+
+    // sample storage, the slot for the next sample, and how many are valid
+    TRACE_SAMPLE *samples;
+    Uint16 next;
+    Uint16 count;
+    Uint16 countdown;
+
+    // set once, by the ISR or freeze(), and cleared when the trace restarts
+    volatile Uint16 reason;
+    bool armRequested;
+
+    // dump to the serial port
+    bool reported;
+    bool dumping;
+    Uint16 dumpLine;
+    char line[TRACE_LINE_LENGTH];
+    Uint16 linePosition;
+    Uint16 lineLength;
+
+    void record(void);
+    bool buildLine(void);
+    void restart(void);
+
+public:
+    Trace(Encoder *encoder, StepperDrive *stepperDrive, Core *core, SerialPort *serialPort);
+
+    // stop recording, if the trace isn't already frozen
+    void freeze(Uint16 reason);
+
+    // start recording again once a frozen trace has been sent
+    void arm(void);
+
+    bool isFrozen(void);
+    Uint16 getReason(void);
+
+    // number of samples held
+    Uint16 getCount(void);
+
+    // a sample, counting back from the newest (age 0); false if there isn't
+    // one that old
+    bool getSample(Uint16 age, TRACE_SAMPLE *sample);
+
+    // send the trace out of the serial port, from the oldest sample
+    void dump(void);
+
+    // true while the trace needs the serial port to itself
+    bool isUsingSerialPort(void);
+
+    // continue any dump as far as the serial port will take; call from the
+    // background loop
+    void service(void);
+
+    // restart a frozen trace once it has been sent, if it was armed or the
+    // soft limit has cleared; call from the background loop
+    void update(void);
+
+    // record a sample when one is due; call from the ISR after the core
+    void ISR(void);
+};
+
+
+inline bool Trace :: isFrozen(void)
+{
+    return this->reason != TRACE_RUNNING;
+}
+
+inline Uint16 Trace :: getReason(void)
+{
+    return this->reason;
+}
+
+inline Uint16 Trace :: getCount(void)
+{
+    return this->count;
+}
+
+inline bool Trace :: isUsingSerialPort(void)
+{
+    return isFrozen() && (!this->reported || this->dumping);
+}
+
+inline void Trace :: record(void)
+{
+    TRACE_SAMPLE *sample = &this->samples[this->next];
+    int32 backlog = stepperDrive->getBacklog();
+    if( backlog > 32767 ) backlog = 32767;
+    if( backlog < -32767 ) backlog = -32767;
+
+    sample->spindle = encoder->getPosition();
+    sample->position = stepperDrive->getCarriagePosition();
+    sample->backlog = (int16)backlog;
+    sample->feed = core->getGeneration();
+
+    this->next = (this->next + 1) & TRACE_MASK;
+    if( this->count < TRACE_LENGTH ) {
+        this->count++;
+    }
+}
+
+inline void Trace :: ISR(void)
+{
+    if( this->reason != TRACE_RUNNING ) {
+        return;
+    }
+
+    // freeze on the same conditions the background loop acts on, but without
+    // waiting for it, keeping the sample that tripped
+    int32 backlog = stepperDrive->getBacklog();
+    int32 limit = stepperDrive->getBacklogLimit();
+    if( backlog > limit || backlog < -limit ) {
+        record();
+        this->reason = TRACE_BACKLOG;
+        return;
+    }
+    if( stepperDrive->isEnabled() && stepperDrive->isAlarm() ) {
+        record();
+        this->reason = TRACE_ALARM;
+        return;
+    }
+    if( stepperDrive->isLimited() ) {
+        record();
+        this->reason = TRACE_LIMIT;
+        return;
+    }
+
+    if( --this->countdown == 0 ) {
+        this->countdown = TRACE_DIVIDER;
+        record();
+    }
+}
+
+
+#endif // __TRACE_H
@@ -28,53 +28,101 @@
 
 const MESSAGE STARTUP_MESSAGE_2 =
 {
-  .message = { LETTER_E, LETTER_L, LETTER_S, DASH, ONE | POINT, FOUR | POINT, ZERO, ZERO },
+  .message = "ELS-1.4.00",
   .displayTime = UI_REFRESH_RATE_HZ * 1.5
 };
 
 const MESSAGE STARTUP_MESSAGE_1 =
 {
- .message = { LETTER_C, LETTER_L, LETTER_O, LETTER_U, LETTER_G, LETTER_H, FOUR, TWO },
+ .message = "CLOUGH42",
  .displayTime = UI_REFRESH_RATE_HZ * 1.5,
  .next = &STARTUP_MESSAGE_2
 };
 
-const MESSAGE SETTINGS_MESSAGE_2 =
-{
- .message = { LETTER_S, LETTER_E, LETTER_T, LETTER_T, LETTER_I, LETTER_N, LETTER_G, LETTER_S },
- .displayTime = UI_REFRESH_RATE_HZ * .5
-};
-
-const MESSAGE SETTINGS_MESSAGE_1 =
-{
- .message = { BLANK, BLANK, BLANK, LETTER_N, LETTER_O, BLANK, BLANK, BLANK },
- .displayTime = UI_REFRESH_RATE_HZ * .5,
- .next = &SETTINGS_MESSAGE_2
-};
-
 extern const MESSAGE BACKLOG_PANIC_MESSAGE_2;
 const MESSAGE BACKLOG_PANIC_MESSAGE_1 =
 {
- .message = { LETTER_T, LETTER_O, LETTER_O, BLANK, LETTER_F, LETTER_A, LETTER_S, LETTER_T },
+ .message = "TOO FAST",
  .displayTime = UI_REFRESH_RATE_HZ * .5,
  .next = &BACKLOG_PANIC_MESSAGE_2
 };
 const MESSAGE BACKLOG_PANIC_MESSAGE_2 =
 {
- .message = { BLANK, LETTER_R, LETTER_E, LETTER_S, LETTER_E, LETTER_T, BLANK, BLANK },
+ .message = " RESET  ",
  .displayTime = UI_REFRESH_RATE_HZ * .5,
  .next = &BACKLOG_PANIC_MESSAGE_1
 };
 
+const MESSAGE LIMIT_MESSAGE =
+{
+ .message = " LIMIT  ",
+ .displayTime = UI_REFRESH_RATE_HZ * .5
+};
 
+const MESSAGE ENTRY_INVALID_MESSAGE =
+{
+ .message = " INVALID",
+ .displayTime = UI_REFRESH_RATE_HZ * 1.0
+};
 
-const Uint16 VALUE_BLANK[4] = { BLANK, BLANK, BLANK, BLANK };
+const MESSAGE ENTRY_BUSY_MESSAGE =
+{
+ .message = "  BUSY  ",
+ .displayTime = UI_REFRESH_RATE_HZ * 1.0
+};
 
-UserInterface :: UserInterface(ControlPanel *controlPanel, Core *core, FeedTableFactory *feedTableFactory)
+const MESSAGE FAVORITE_SAVED_MESSAGE =
 {
-    this->controlPanel = controlPanel;
+ .message = " SAVED  ",
+ .displayTime = UI_REFRESH_RATE_HZ * 1.0
+};
+
+const MESSAGE FAVORITE_FAILED_MESSAGE =
+{
+ .message = " FAILED ",
+ .displayTime = UI_REFRESH_RATE_HZ * 1.0
+};
+
+const MESSAGE FAVORITE_EMPTY_MESSAGE =
+{
+ .message = " EMPTY  ",
+ .displayTime = UI_REFRESH_RATE_HZ * 1.0
+};
+
+
+
+
+// Carriage position conversion from steps to ten-thousandths of an inch and
+// thousandths of a millimeter, for the DRO page
+#if defined(LEADSCREW_TPI)
+#define DRO_INCH_NUMERATOR ((int64)10000)
+#define DRO_INCH_DENOMINATOR ((int64)LEADSCREW_TPI*STEPPER_RESOLUTION*STEPPER_MICROSTEPS)
+#define DRO_MM_NUMERATOR ((int64)25400)
+#define DRO_MM_DENOMINATOR ((int64)LEADSCREW_TPI*STEPPER_RESOLUTION*STEPPER_MICROSTEPS)
+#endif
+#if defined(LEADSCREW_HMM)
+#define DRO_INCH_NUMERATOR ((int64)LEADSCREW_HMM*1000)
+#define DRO_INCH_DENOMINATOR ((int64)254*STEPPER_RESOLUTION*STEPPER_MICROSTEPS)
+#define DRO_MM_NUMERATOR ((int64)LEADSCREW_HMM*10)
+#define DRO_MM_DENOMINATOR ((int64)STEPPER_RESOLUTION*STEPPER_MICROSTEPS)
+#endif
+
+// Blink rate of the digit being edited, in UI loops per half cycle
+#define ENTRY_BLINK_LOOPS (UI_REFRESH_RATE_HZ / 4)
+
+// Powers of ten for the entry digits, most significant first
+static const Uint16 ENTRY_WEIGHTS[ENTRY_DIGITS] = { 1000, 100, 10, 1 };
+
+UserInterface :: UserInterface(Display *display, Keypad *keypad, Core *core, Monitor *monitor, FeedTableFactory *feedTableFactory, SettingsJournal *settingsJournal, Favorites *favorites, Trace *trace)
+{
+    this->display = display;
+    this->keypad = keypad;
     this->core = core;
+    this->monitor = monitor;
     this->feedTableFactory = feedTableFactory;
+    this->settingsJournal = settingsJournal;
+    this->favorites = favorites;
+    this->trace = trace;
 
     this->metric = false; // start out with imperial
     this->thread = false; // start out with feeds
@@ -82,25 +130,109 @@ UserInterface :: UserInterface(ControlPanel *controlPanel, Core *core, FeedTable
 
     this->feedTable = NULL;
 
-    this->keys.all = 0xff;
+    this->page = DISPLAY_PAGE_NORMAL;
+
+    this->editing = false;
+    this->editValue = 0;
+    this->editCursor = 0;
+    this->editBlink = 0;
+    this->editText[0] = 0;
+    this->ignoreRelease = false;
+    this->savingFavorite = false;
+    this->customFeed = NULL;
+    this->traceAge = 0;
 
     // initialize the core so we start up correctly
     core->setReverse(this->reverse);
     core->setFeed(loadFeedTable());
+    core->publish();
+
+    // the defaults don't need saving
+    getSettings(&this->savedSettings);
 
     setMessage(&STARTUP_MESSAGE_1);
 }
 
+void UserInterface :: loadSettings( void )
+{
+    SETTINGS settings;
+
+    if( this->settingsJournal->load(&settings) )
+    {
+        this->metric = settings.metric;
+        this->thread = settings.thread;
+        this->reverse = settings.reverse;
+
+        feedTableFactory->getFeedTable(false, true)->setSelectedRow(settings.inchThreadRow);
+        feedTableFactory->getFeedTable(false, false)->setSelectedRow(settings.inchFeedRow);
+        feedTableFactory->getFeedTable(true, true)->setSelectedRow(settings.metricThreadRow);
+        feedTableFactory->getFeedTable(true, false)->setSelectedRow(settings.metricFeedRow);
+    }
+
+    // the tables may have been replaced since the constructor ran
+    core->setReverse(this->reverse);
+    core->setFeed(loadFeedTable());
+    core->publish();
+
+    // a row that no longer exists won't have been restored
+    getSettings(&this->savedSettings);
+}
+
+void UserInterface :: getSettings( SETTINGS *settings )
+{
+    settings->metric = this->metric;
+    settings->thread = this->thread;
+    settings->reverse = this->reverse;
+    settings->inchThreadRow = feedTableFactory->getFeedTable(false, true)->getSelectedRow();
+    settings->inchFeedRow = feedTableFactory->getFeedTable(false, false)->getSelectedRow();
+    settings->metricThreadRow = feedTableFactory->getFeedTable(true, true)->getSelectedRow();
+    settings->metricFeedRow = feedTableFactory->getFeedTable(true, false)->getSelectedRow();
+}
+
+bool UserInterface :: isSaved( const SETTINGS *settings )
+{
+    return settings->metric == savedSettings.metric &&
+            settings->thread == savedSettings.thread &&
+            settings->reverse == savedSettings.reverse &&
+            settings->inchThreadRow == savedSettings.inchThreadRow &&
+            settings->inchFeedRow == savedSettings.inchFeedRow &&
+            settings->metricThreadRow == savedSettings.metricThreadRow &&
+            settings->metricFeedRow == savedSettings.metricFeedRow;
+}
+
+void UserInterface :: saveSettings( void )
+{
+    SETTINGS settings;
+
+    getSettings(&settings);
+    if( ! isSaved(&settings) && settingsJournal->save(&settings) )
+    {
+        this->savedSettings = settings;
+    }
+}
+
 const FEED_THREAD *UserInterface::loadFeedTable()
 {
+    // switching tables drops any entered feed
+    this->customFeed = NULL;
+
     this->feedTable = this->feedTableFactory->getFeedTable(this->metric, this->thread);
     return this->feedTable->current();
 }
 
+const FEED_THREAD *UserInterface::currentFeed()
+{
+    if( this->customFeed != NULL )
+    {
+        return this->customFeed;
+    }
+    return this->feedTable->current();
+}
+
 LED_REG UserInterface::calculateLEDs()
 {
     // get the LEDs for this feed
-    LED_REG leds = feedTable->current()->leds;
+    LED_REG leds = currentFeed()->leds;
 
     if( this->core->isPowerOn() )
     {
@@ -130,12 +262,12 @@ void UserInterface :: overrideMessage( void )
     {
         if( this->messageTime > 0 ) {
             this->messageTime--;
-            controlPanel->setMessage(this->message->message);
+            display->setMessage(this->message->message);
         }
         else {
             this->message = this->message->next;
             if( this->message == NULL )
-                controlPanel->setMessage(NULL);
+                display->setMessage(NULL);
             else
                 this->messageTime = this->message->displayTime;
         }
@@ -146,7 +278,7 @@ void UserInterface :: clearMessage( void )
 {
     this->message = NULL;
     this->messageTime = 0;
-    controlPanel->setMessage(NULL);
+    display->setMessage(NULL);
 }
 
 void UserInterface :: panicStepBacklog( void )
@@ -154,24 +286,331 @@ void UserInterface :: panicStepBacklog( void )
     setMessage(&BACKLOG_PANIC_MESSAGE_1);
 }
 
-void UserInterface :: loop( void )
+void UserInterface :: showLimit( void )
 {
-    // read the RPM up front so we can use it to make decisions
-    Uint16 currentRpm = core->getRPM();
+    // don't hide a panic, which needs a reset
+    if( this->message != &BACKLOG_PANIC_MESSAGE_1 && this->message != &BACKLOG_PANIC_MESSAGE_2 )
+    {
+        setMessage(&LIMIT_MESSAGE);
+    }
+}
 
-    // display an override message, if there is one
-    overrideMessage();
+void UserInterface :: updateReadout( void )
+{
+    int64 position = this->monitor->getPosition();
+    char *p = this->readout;
+
+    switch( this->page )
+    {
+    case DISPLAY_PAGE_DRO:
+        // carriage position in the current units
+        *p++ = 'd';
+        if( this->metric )
+        {
+            Display::formatNumber(p, 7, position * DRO_MM_NUMERATOR / DRO_MM_DENOMINATOR, 3);
+        }
+        else
+        {
+            Display::formatNumber(p, 7, position * DRO_INCH_NUMERATOR / DRO_INCH_DENOMINATOR, 4);
+        }
+        break;
+
+    case DISPLAY_PAGE_STEP_RATE:
+        // step frequency, in steps per second
+        *p++ = 'F';
+        Display::formatNumber(p, 7, this->monitor->getStepRate(), 0);
+        break;
+
+    case DISPLAY_PAGE_BACKLOG:
+        // step backlog against the limit
+        *p++ = 'b';
+        p = Display::formatNumber(p, 3, this->monitor->getBacklog(), 0);
+        Display::formatNumber(p, 4, this->monitor->getBacklogLimit(), 0);
+        break;
+
+    case DISPLAY_PAGE_LOAD:
+        // average and peak ISR load, in percent
+        *p++ = 'L';
+        p = Display::formatNumber(p, 3, this->monitor->getLoad(), 1);
+        Display::formatNumber(p, 4, this->monitor->getPeakLoad(), 1);
+        break;
+
+    case DISPLAY_PAGE_BACKGROUND:
+        // background load, and the longest refresh against its budget, in percent
+        *p++ = 'U';
+        p = Display::formatNumber(p, 3, this->monitor->getBackgroundLoad(), 1);
+        Display::formatNumber(p, 4, this->monitor->getRefreshPeak(), 1);
+        break;
+
+#ifdef USE_TRACE
+    case DISPLAY_PAGE_TRACE:
+        updateTraceReadout(p);
+        break;
+#endif
+    }
+}
+
+#ifdef USE_TRACE
+void UserInterface :: updateTraceReadout( char *p )
+{
+    TRACE_SAMPLE sample, older;
+
+    if( ! trace->isFrozen() || ! trace->getSample(this->traceAge, &sample) )
+    {
+        const char *running = "t    run";
+        while( (*p++ = *running++) != 0 );
+        return;
+    }
+
+    // mark the sample where the feed changed
+    *p++ = (trace->getSample(this->traceAge + 1, &older) && older.feed != sample.feed) ? 'F' : 't';
+
+    // time before the trace froze, in milliseconds, and the backlog then
+    p = Display::formatNumber(p, 3, (int32)this->traceAge * TRACE_DIVIDER * STEPPER_CYCLE_US / 100, 1);
+    *p++ = 'b';
+    Display::formatNumber(p, 3, sample.backlog, 0);
+}
+#endif
+
+void UserInterface :: beginEntry( void )
+{
+    Uint16 value = feedTableFactory->getValue(this->metric, this->thread, currentFeed());
+
+    // start from the current feed, as far as it fits the digits
+    this->editValue = (value < ENTRY_WEIGHTS[0] * 10) ? value : 0;
+    this->editCursor = 0;
+    this->editBlink = 0;
+    this->editing = true;
+
+    // the readouts would hide the value
+    this->page = DISPLAY_PAGE_NORMAL;
+}
 
-    // read keypresses from the control panel
-    keys = controlPanel->getKeys();
+void UserInterface :: finishEntry( void )
+{
+    // build the new feed in a buffer the core isn't using, so the ISR never
+    // sees a half-written ratio, then hand it over in one step
+    FEED_THREAD *feed = NULL;
+    for( Uint16 i = 0; i < 2; i++ )
+    {
+        if( ! core->isFeedInUse(&this->customFeeds[i]) )
+        {
+            feed = &this->customFeeds[i];
+            break;
+        }
+    }
+
+    if( feed == NULL )
+    {
+        // both are busy; SET can simply be pressed again
+        setMessage(&ENTRY_BUSY_MESSAGE);
+        return;
+    }
+
+    if( ! feedTableFactory->buildFeed(this->metric, this->thread, this->editValue, feed) )
+    {
+        // stay in entry mode so the value can be fixed
+        setMessage(&ENTRY_INVALID_MESSAGE);
+        return;
+    }
+
+    this->customFeed = feed;
+    core->setFeed(feed);
+    this->editing = false;
+}
+
+void UserInterface :: handleEntryKey( const KEY_EVENT *event )
+{
+    KEY_REG keys = event->keys;
+    Uint16 weight = ENTRY_WEIGHTS[this->editCursor];
+    Uint16 digit = (this->editValue / weight) % 10;
+
+    if( event->type == KEY_PRESS || event->type == KEY_REPEAT )
+    {
+        // change the digit under the cursor, wrapping around
+        if( keys.bit.UP )
+        {
+            this->editValue = (digit == 9) ? this->editValue - 9 * weight : this->editValue + weight;
+        }
+        if( keys.bit.DOWN )
+        {
+            this->editValue = (digit == 0) ? this->editValue + 9 * weight : this->editValue - weight;
+        }
+    }
+
+    if( event->type == KEY_PRESS )
+    {
+        // move the cursor to the next digit
+        if( keys.bit.FWD_REV )
+        {
+            this->editCursor = (this->editCursor + 1) % ENTRY_DIGITS;
+        }
+        if( keys.bit.SET )
+        {
+            finishEntry();
+        }
+        if( keys.bit.POWER )
+        {
+            this->editing = false;
+        }
+
+        // don't let the end of this press act on the normal screen
+        this->ignoreRelease = ! this->editing;
+    }
+
+    // show the digit steadily right after a change
+    this->editBlink = 0;
+}
+
+int16 UserInterface :: favoriteSlot( KEY_REG keys )
+{
+    if( keys.bit.SET )
+    {
+        if( keys.bit.UP ) return 0;
+        if( keys.bit.DOWN ) return 1;
+        if( keys.bit.IN_MM ) return 2;
+        if( keys.bit.FEED_THREAD ) return 3;
+    }
+    return -1;
+}
+
+void UserInterface :: saveFavorite( Uint16 slot )
+{
+    FAVORITE favorite;
+
+    // only table rows can be remembered
+    if( this->customFeed != NULL )
+    {
+        setMessage(&ENTRY_INVALID_MESSAGE);
+        return;
+    }
+
+    favorite.metric = this->metric;
+    favorite.thread = this->thread;
+    favorite.reverse = this->reverse;
+    favorite.row = this->feedTable->getSelectedRow();
+
+    if( favorites->set(slot, &favorite) )
+    {
+        this->savingFavorite = true;
+    }
+    else
+    {
+        setMessage(&FAVORITE_FAILED_MESSAGE);
+    }
+}
+
+void UserInterface :: checkFavoriteSave( void )
+{
+    if( ! this->savingFavorite )
+    {
+        return;
+    }
+
+    Uint16 status = favorites->getSaveStatus();
+    if( status != EEPROM_STATUS_PENDING )
+    {
+        setMessage(status == EEPROM_STATUS_DONE ? &FAVORITE_SAVED_MESSAGE : &FAVORITE_FAILED_MESSAGE);
+        this->savingFavorite = false;
+    }
+}
+
+void UserInterface :: recallFavorite( Uint16 slot )
+{
+    FAVORITE favorite;
+
+    if( ! favorites->get(slot, &favorite) )
+    {
+        setMessage(&FAVORITE_EMPTY_MESSAGE);
+        return;
+    }
+
+    // the row may be gone if a different user table has been loaded since
+    if( ! feedTableFactory->getFeedTable(favorite.metric, favorite.thread)->setSelectedRow(favorite.row) )
+    {
+        setMessage(&ENTRY_INVALID_MESSAGE);
+        return;
+    }
+
+    this->metric = favorite.metric;
+    this->thread = favorite.thread;
+    this->reverse = favorite.reverse;
+
+    core->setReverse(this->reverse);
+    core->setFeed(loadFeedTable());
+    clearMessage();
+}
+
+void UserInterface :: handleKeyEvent( const KEY_EVENT *event, Uint16 currentRpm )
+{
+    KEY_REG keys = event->keys;
+
+    if( this->editing )
+    {
+        handleEntryKey(event);
+        return;
+    }
+
+    if( event->type == KEY_RELEASE && this->ignoreRelease )
+    {
+        this->ignoreRelease = false;
+        return;
+    }
+
+    // SET chords recall a favorite when tapped, and save one when held
+    int16 slot = favoriteSlot(keys);
+    if( slot >= 0 )
+    {
+        if( event->type == KEY_LONG_PRESS && this->core->isPowerOn() )
+        {
+            saveFavorite(slot);
+            this->ignoreRelease = true;
+        }
+
+        // recalling changes the mode, so only when stopped
+        if( event->type == KEY_RELEASE && this->core->isPowerOn() && currentRpm == 0 )
+        {
+            recallFavorite(slot);
+        }
+        return;
+    }
+
+#ifdef USE_TRACE
+    // UP and DOWN step through a frozen trace while it's on show
+    if( this->page == DISPLAY_PAGE_TRACE && trace->isFrozen() && (keys.bit.UP || keys.bit.DOWN) )
+    {
+        if( event->type == KEY_PRESS || event->type == KEY_REPEAT )
+        {
+            if( keys.bit.UP && this->traceAge + 1 < trace->getCount() ) this->traceAge++;
+            if( keys.bit.DOWN && this->traceAge > 0 ) this->traceAge--;
+        }
+        return;
+    }
+#endif
 
     // respond to keypresses
-    if( currentRpm == 0 )
+    if( event->type == KEY_PRESS && currentRpm == 0 )
     {
         // these keys should only be sensitive when the machine is stopped
         if( keys.bit.POWER ) {
             this->core->setPowerOn(!this->core->isPowerOn());
             clearMessage();
+
+            // don't leave changes waiting in the cache when the machine may be
+            // about to be switched off
+            if( ! this->core->isPowerOn() )
+            {
+                saveSettings();
+                settingsJournal->flush();
+            }
+
+#ifdef USE_TRACE
+            // a fresh start gets a fresh trace, once any frozen one is out
+            if( this->core->isPowerOn() )
+            {
+                trace->arm();
+            }
+#endif
         }
 
         // these should only work when the power is on
@@ -191,44 +630,127 @@ void UserInterface :: loop( void )
                 this->reverse = ! this->reverse;
                 core->setReverse(this->reverse);
             }
-            if( keys.bit.SET )
-            {
-                setMessage(&SETTINGS_MESSAGE_1);
-            }
         }
     }
 
+    // the display pages can be flipped through at any time; SET acts when it
+    // is released, since holding it starts numeric entry instead
+    if( event->type == KEY_RELEASE && keys.bit.SET && event->held < KEY_LONG_PRESS_MS )
+    {
+        this->page = (this->page + 1) % DISPLAY_PAGE_COUNT;
+    }
+
 #ifdef IGNORE_ALL_KEYS_WHEN_RUNNING
     if( currentRpm == 0 )
         {
 #endif // IGNORE_ALL_KEYS_WHEN_RUNNING
 
-        // these should only work when the power is on
-        if( this->core->isPowerOn() ) {
+        // these should only work when the power is on, and they auto-repeat
+        if( this->core->isPowerOn() && (event->type == KEY_PRESS || event->type == KEY_REPEAT) ) {
             // these keys can be operated when the machine is running
+            // stepping from an entered feed goes back to the table
             if( keys.bit.UP )
             {
+                this->customFeed = NULL;
                 core->setFeed(feedTable->next());
             }
             if( keys.bit.DOWN )
             {
+                this->customFeed = NULL;
                 core->setFeed(feedTable->previous());
             }
         }
 
+        // hold SET to type in any feed or pitch
+        if( this->core->isPowerOn() && event->type == KEY_LONG_PRESS && keys.bit.SET )
+        {
+            beginEntry();
+        }
+
 #ifdef IGNORE_ALL_KEYS_WHEN_RUNNING
     }
 #endif // IGNORE_ALL_KEYS_WHEN_RUNNING
+}
+
+void UserInterface :: updateEntryText( void )
+{
+    Uint16 decimals = feedTableFactory->getDecimals(this->metric, this->thread);
+    bool blinkOff = (this->editBlink++ / ENTRY_BLINK_LOOPS) % 2 != 0;
+    char *p = this->editText;
+
+    // every digit is shown, so the cursor always has somewhere to be; a blank
+    // that still takes the point is needed to blink the digit before it
+    for( Uint16 i = 0; i < ENTRY_DIGITS; i++ )
+    {
+        if( blinkOff && i == this->editCursor )
+        {
+            *p++ = '_';
+        }
+        else
+        {
+            *p++ = '0' + (this->editValue / ENTRY_WEIGHTS[i]) % 10;
+        }
+        if( decimals > 0 && i == ENTRY_DIGITS - 1 - decimals )
+        {
+            *p++ = '.';
+        }
+    }
+    *p = 0;
+}
+
+void UserInterface :: loop( void )
+{
+    KEY_EVENT event;
+
+    // read the RPM up front so we can use it to make decisions
+    Uint16 currentRpm = core->getRPM();
+
+    // display an override message, if there is one
+    overrideMessage();
+
+    // respond to every key event queued since the last loop
+    while( keypad->getEvent(&event) )
+    {
+        handleKeyEvent(&event, currentRpm);
+    }
+
+    // hand the new feed and direction to the ISR together
+    core->publish();
+
+    // save any settings that changed; the cache holds them until they settle
+    saveSettings();
+    checkFavoriteSave();
 
     // update the control panel
-    controlPanel->setLEDs(calculateLEDs());
-    controlPanel->setValue(feedTable->current()->display);
-    controlPanel->setRPM(currentRpm);
+    display->setLEDs(calculateLEDs());
+    display->setNumber(DISPLAY_FIELD_RPM, currentRpm, 0);
 
-    if( ! core->isPowerOn() )
+    if( this->editing )
+    {
+        updateEntryText();
+        display->setText(DISPLAY_FIELD_VALUE, this->editText);
+    }
+    else if( core->isPowerOn() )
+    {
+        display->setText(DISPLAY_FIELD_VALUE, currentFeed()->label);
+    }
+    else
+    {
+        display->setText(DISPLAY_FIELD_VALUE, NULL);
+    }
+
+    // collect the latest values from the real-time engine
+    monitor->update();
+
+    if( this->page != DISPLAY_PAGE_NORMAL )
+    {
+        updateReadout();
+        display->setText(DISPLAY_FIELD_READOUT, this->readout);
+    }
+    else
     {
-        controlPanel->setValue(VALUE_BLANK);
+        display->setText(DISPLAY_FIELD_READOUT, NULL);
     }
 
-    controlPanel->refresh();
+    display->refresh();
 }
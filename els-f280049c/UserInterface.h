@@ -27,13 +27,35 @@
 #ifndef __USERINTERFACE_H
 #define __USERINTERFACE_H
 
-#include "ControlPanel.h"
+#include "Display.h"
+#include "Keypad.h"
 #include "Core.h"
+#include "Monitor.h"
 #include "Tables.h"
+#include "SettingsJournal.h"
+#include "Favorites.h"
+#include "Trace.h"
+
+// Display pages, selected with the SET key
+#define DISPLAY_PAGE_NORMAL 0       // RPM and feed/thread
+#define DISPLAY_PAGE_DRO 1          // carriage position
+#define DISPLAY_PAGE_STEP_RATE 2    // step frequency
+#define DISPLAY_PAGE_BACKLOG 3      // step backlog and limit
+#define DISPLAY_PAGE_LOAD 4         // ISR load and peak
+#define DISPLAY_PAGE_BACKGROUND 5   // background load and peak refresh time
+#ifdef USE_TRACE
+#define DISPLAY_PAGE_TRACE 6        // post-mortem trace, once frozen
+#define DISPLAY_PAGE_COUNT 7
+#else
+#define DISPLAY_PAGE_COUNT 6
+#endif
+
+// Number of digits in a value being entered
+#define ENTRY_DIGITS 4
 
 typedef struct MESSAGE
 {
-    Uint16 message[8];
+    const char *message;
     Uint16 displayTime;
     const MESSAGE *next;
 } MESSAGE;
@@ -41,9 +63,14 @@ typedef struct MESSAGE
 class UserInterface
 {
 private:
-    ControlPanel *controlPanel;
+    Display *display;
+    Keypad *keypad;
     Core *core;
+    Monitor *monitor;
     FeedTableFactory *feedTableFactory;
+    SettingsJournal *settingsJournal;
+    Favorites *favorites;
+    Trace *trace;                   // NULL without USE_TRACE
 
     bool metric;
     bool thread;
@@ -51,23 +78,73 @@ private:
 
     FeedTable *feedTable;
 
-    KEY_REG keys;
-
     const MESSAGE *message;
     Uint16 messageTime;
 
+    Uint16 page;
+    char readout[12];
+
+    // settings as last saved to the journal
+    SETTINGS savedSettings;
+
+    // numeric entry: the value being edited, which digit the cursor is on,
+    // and a counter to blink it
+    bool editing;
+    Uint16 editValue;
+    Uint16 editCursor;
+    Uint16 editBlink;
+    char editText[DISPLAY_FIELD_LENGTH];
+
+    // the release at the end of a key press that ended numeric entry
+    bool ignoreRelease;
+
+    // a favorite save is queued; its result is shown once it is written
+    bool savingFavorite;
+
+    // entered feed, when one is in use instead of a table row; written to the
+    // buffer the core isn't using, then handed over
+    FEED_THREAD customFeeds[2];
+    const FEED_THREAD *customFeed;
+
+    // trace sample on the trace page, counting back from the newest
+    Uint16 traceAge;
+
     const FEED_THREAD *loadFeedTable();
+    const FEED_THREAD *currentFeed();
     LED_REG calculateLEDs();
     void setMessage(const MESSAGE *message);
     void overrideMessage( void );
     void clearMessage( void );
+    void handleKeyEvent( const KEY_EVENT *event, Uint16 currentRpm );
+    void beginEntry( void );
+    void handleEntryKey( const KEY_EVENT *event );
+    void finishEntry( void );
+    void updateEntryText( void );
+    void updateReadout( void );
+#ifdef USE_TRACE
+    void updateTraceReadout( char *p );
+#endif
+    void getSettings( SETTINGS *settings );
+    bool isSaved( const SETTINGS *settings );
+    void saveSettings( void );
+    int16 favoriteSlot( KEY_REG keys );
+    void saveFavorite( Uint16 slot );
+    void checkFavoriteSave( void );
+    void recallFavorite( Uint16 slot );
 
 public:
-    UserInterface(ControlPanel *controlPanel, Core *core, FeedTableFactory *feedTableFactory);
+    UserInterface(Display *display, Keypad *keypad, Core *core, Monitor *monitor, FeedTableFactory *feedTableFactory, SettingsJournal *settingsJournal, Favorites *favorites, Trace *trace);
+
+    // restore the last saved settings; call once the hardware is initialized
+    // and the feed tables are loaded
+    void loadSettings( void );
 
     void loop( void );
 
     void panicStepBacklog( void );
+
+    // the carriage is being held at a soft limit
+    void showLimit( void );
 };
 
 #endif // __USERINTERFACE_H
@@ -27,10 +27,24 @@
 #include "F28x_Project.h"
 #include "Configuration.h"
 #include "SanityCheck.h"
+#include "Clock.h"
 #include "ControlPanel.h"
+#include "CharacterLCD.h"
+#include "Keypad.h"
 #include "EEPROM.h"
+#include "EEPROMCache.h"
+#include "SettingsJournal.h"
+#include "Favorites.h"
+#include "SupplyMonitor.h"
 #include "StepperDrive.h"
 #include "Encoder.h"
+#include "Monitor.h"
+#include "SerialPort.h"
+#include "Telemetry.h"
+#include "EncoderCapture.h"
+#include "Trace.h"
+#include "Console.h"
+#include "IsrBenchmark.h"
 
 #include "Core.h"
 #include "UserInterface.h"
@@ -38,6 +52,7 @@
 
 
 __interrupt void cpu_timer0_isr(void);
+bool isDue(Uint32 now, Uint32 *next, Uint32 period);
 
 
 //
@@ -49,8 +64,8 @@ __interrupt void cpu_timer0_isr(void);
 // Debug harness
 Debug debug;
 
-// Feed table factory
-FeedTableFactory feedTableFactory;
+// System timebase
+Clock systemClock;
 
 // Common SPI Bus driver
 SPIBus spiBus;
@@ -58,9 +73,37 @@ SPIBus spiBus;
 // Control Panel driver
 ControlPanel controlPanel(&spiBus);
 
+// Display driver
+#ifdef DISPLAY_CHARACTER_LCD
+CharacterLCD characterLCD(&spiBus);
+Display &display = characterLCD;
+#else
+Display &display = controlPanel;
+#endif
+
+// Key event queue
+Keypad keypad(&controlPanel, &systemClock);
+
 // EEPROM driver
 EEPROM eeprom(&spiBus);
 
+// EEPROM write-back cache
+EEPROMCache eepromCache(&eeprom, &systemClock);
+
+// Feed table factory
+FeedTableFactory feedTableFactory(&eeprom);
+
+// Settings store
+SettingsJournal settingsJournal(&eeprom, &eepromCache);
+
+// Favorite setups
+Favorites favorites(&eeprom);
+
+#ifdef USE_BROWNOUT_FLUSH
+// Supply voltage monitor
+SupplyMonitor supplyMonitor;
+#endif
+
 // Encoder driver
 Encoder encoder;
 
@@ -70,8 +113,43 @@ StepperDrive stepperDrive;
 // Core engine
 Core core(&encoder, &stepperDrive);
 
+// Real-time engine monitor
+Monitor monitor(&systemClock, &stepperDrive);
+
+// Serial port
+SerialPort serialPort;
+
+#ifdef USE_TELEMETRY
+// Telemetry stream
+Telemetry telemetry(&encoder, &stepperDrive, &serialPort);
+#define TELEMETRY_INSTANCE (&telemetry)
+#else
+#define TELEMETRY_INSTANCE NULL
+#endif
+
+#ifdef USE_ENCODER_CAPTURE
+// Encoder capture stream
+EncoderCapture encoderCapture(&encoder, &serialPort);
+#endif
+
+#ifdef USE_TRACE
+// Post-mortem trace
+Trace trace(&encoder, &stepperDrive, &core, &serialPort);
+#define TRACE_INSTANCE (&trace)
+#else
+#define TRACE_INSTANCE NULL
+#endif
+
+// Serial command console
+Console console(&serialPort, &core, &stepperDrive, &monitor, TRACE_INSTANCE, &display, &eeprom, &eepromCache, &feedTableFactory, TELEMETRY_INSTANCE);
+
+#ifdef ENABLE_ISR_BENCHMARK
+// ISR benchmark
+IsrBenchmark isrBenchmark(&systemClock, &feedTableFactory, &serialPort);
+#endif
+
 // User interface
-UserInterface userInterface(&controlPanel, &core, &feedTableFactory);
+UserInterface userInterface(&display, &keypad, &core, &monitor, &feedTableFactory, &settingsJournal, &favorites, TRACE_INSTANCE);
 
 void main(void)
 {
@@ -118,11 +196,32 @@ void main(void)
 
     // Initialize peripherals and pins
     debug.initHardware();
+    systemClock.initHardware();
     spiBus.initHardware();
     controlPanel.initHardware();
+#ifdef DISPLAY_CHARACTER_LCD
+    characterLCD.initHardware();
+#endif
     eeprom.initHardware();
+#ifdef USE_BROWNOUT_FLUSH
+    supplyMonitor.initHardware();
+#endif
     stepperDrive.initHardware();
     encoder.initHardware();
+    serialPort.initHardware();
+
+    // switch to the user tables, if there are any
+    feedTableFactory.loadTables();
+
+    // restore the settings and favorites from the last run
+    favorites.load();
+    userInterface.loadSettings();
+
+#ifdef ENABLE_ISR_BENCHMARK
+    // time the ISR with interrupts still off, send the report, and stop
+    while( isrBenchmark.service() );
+    for(;;);
+#endif
 
     // Enable CPU INT1 which is connected to CPU-Timer 0
     IER |= M_INT1;
@@ -134,28 +233,132 @@ void main(void)
     EINT;
     ERTM;
 
-    // User interface loop
+    // Background loop
+    //
+    // Tasks are scheduled from the system clock: the keys are scanned on their
+    // own fast schedule so they can be debounced by time, and the user interface
+    // is serviced at its normal refresh rate.  A pass that runs no scheduled
+    // task is counted as idle time by the monitor.
+    Uint32 nextKeyScan = systemClock.getMillis();
+    Uint32 nextRefresh = nextKeyScan;
+    Uint32 nextEepromService = nextKeyScan;
+
     for(;;) {
-        // mark beginning of loop for debugging
-        debug.begin2();
+        monitor.beginPass();
+        bool busy = false;
+
+        Uint32 now = systemClock.getMillis();
 
         // check for step backlog and panic the system if it occurs
         if( stepperDrive.checkStepBacklog() ) {
             userInterface.panicStepBacklog();
         }
 
+        // let the operator know the carriage is waiting at a soft limit
+        if( stepperDrive.checkLimit() ) {
+            userInterface.showLimit();
+        }
+
+        // scan the keys and queue up any events
+        if( isDue(now, &nextKeyScan, KEY_SCAN_INTERVAL_MS) ) {
+            busy = true;
+            keypad.scan();
+        }
+
+        // write back settled changes and advance any EEPROM writes in progress
+        if( isDue(now, &nextEepromService, EEPROM_SERVICE_INTERVAL_MS) ) {
+            busy = true;
+#ifdef USE_BROWNOUT_FLUSH
+            // the power is going; get everything into the chip while we can
+            if( supplyMonitor.isLow() ) {
+                eepromCache.sync();
+            }
+#endif
+            eepromCache.service();
+            eeprom.service(now);
+        }
+
+        // take console input and run at most one command
+        if( console.service() ) {
+            busy = true;
+        }
+
+        // keep the serial port fed; a frozen trace or a console reply takes
+        // it over from the telemetry or capture stream at the end of a frame
+        // until it has been sent, and the trace goes before the console
+#ifdef USE_TELEMETRY
+#ifdef USE_TRACE
+        telemetry.setPaused(trace.isUsingSerialPort() || console.hasOutput());
+#else
+        telemetry.setPaused(console.hasOutput());
+#endif
+        telemetry.service();
+        if( telemetry.isIdle() )
+#endif
+#ifdef USE_ENCODER_CAPTURE
+#ifdef USE_TRACE
+        encoderCapture.setPaused(trace.isUsingSerialPort() || console.hasOutput());
+#else
+        encoderCapture.setPaused(console.hasOutput());
+#endif
+        encoderCapture.service();
+        if( encoderCapture.isIdle() )
+#endif
+        {
+#ifdef USE_TRACE
+            if( trace.isUsingSerialPort() ) {
+                trace.service();
+            }
+            else
+#endif
+            {
+                console.send();
+            }
+        }
+
+#ifdef USE_TRACE
+        // start the trace again once it's out, if it should be
+        trace.update();
+#endif
+
         // service the user interface
-        userInterface.loop();
+        if( isDue(now, &nextRefresh, 1000 / UI_REFRESH_RATE_HZ) ) {
+            busy = true;
+
+            // mark beginning of loop for debugging
+            debug.begin2();
+            monitor.beginRefresh();
+
+            userInterface.loop();
 
-        // mark end of loop for debugging
-        debug.end2();
+            // mark end of loop for debugging
+            monitor.endRefresh();
+            debug.end2();
+        }
 
-        // delay
-        DELAY_US(1000000 / UI_REFRESH_RATE_HZ);
+        monitor.endPass(busy);
     }
 }
 
 
+// Returns true if a periodic task is due, and schedules its next run
+bool isDue(Uint32 now, Uint32 *next, Uint32 period)
+{
+    if( (int32)(now - *next) < 0 ) {
+        return false;
+    }
+
+    *next += period;
+
+    // if we've fallen more than a period behind, don't try to catch up
+    if( (int32)(now - *next) >= 0 ) {
+        *next = now + period;
+    }
+
+    return true;
+}
+
+
 // CPU Timer 0 ISR
 __interrupt void
 cpu_timer0_isr(void)
@@ -164,10 +367,29 @@ cpu_timer0_isr(void)
 
     // flag entrance to ISR for timing
     debug.begin1();
+    Uint32 startCycles = systemClock.getCycles();
 
     // service the Core engine ISR, which in turn services the StepperDrive ISR
     core.ISR();
 
+#ifdef USE_TELEMETRY
+    // sample the engine for the telemetry stream
+    telemetry.ISR();
+#endif
+
+#ifdef USE_ENCODER_CAPTURE
+    // record the raw encoder count for replay
+    encoderCapture.ISR();
+#endif
+
+#ifdef USE_TRACE
+    // record the engine, and freeze the record if it has failed
+    trace.ISR();
+#endif
+
+    // account for the time spent, and sample the engine if requested
+    monitor.ISR(startCycles);
+
     // flag exit from ISR for timing
     debug.end1();
 
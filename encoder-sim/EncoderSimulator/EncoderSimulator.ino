@@ -3,6 +3,17 @@
 
   Generates a stream of quadrature count signals to simulate an encoder
   for testing and other purposes.
+
+  The speed is set with the pot, or a spindle recorded with the ELS encoder
+  capture can be played back over USB with tools/capture.py play.  The
+  stream is one byte per count at 1000000 baud:
+
+    0x00        no count for 128 ticks
+    otherwise   bits 0-6: ticks since the last count; bit 7: backward
+
+  with ticks of 5us, as in the ELS ISR.  The sketch sends '+' for every 32
+  bytes it has used, so the sender never overruns the receive buffer, and
+  goes back to the pot when the stream stops.
 */
 
 #include "DelayTable.h"
@@ -12,6 +23,13 @@
 
 #define POT_PIN A0
 
+#define REPLAY_BAUD 1000000
+#define REPLAY_TICK_US 5
+#define REPLAY_WAIT 0x00
+#define REPLAY_BACKWARD 0x80
+#define REPLAY_CREDIT 32
+#define REPLAY_TIMEOUT_MS 500
+
 volatile uint8_t *ENC_A_PORT;
 uint8_t ENC_A_PIN_MASK;
 volatile uint8_t *ENC_B_PORT;
@@ -22,6 +40,9 @@ volatile int analogVal;
 
 uint16_t calculatedDelay = 0;
 
+// position in the quadrature cycle: A and B are 00, 10, 11, 01 going forward
+uint8_t quadratureState = 0;
+
 // the setup function runs once when you press reset or power the board
 void setup() {
   initADC();
@@ -40,21 +61,73 @@ void setup() {
 
   digitalWrite(ENC_A_PIN, 0);
   digitalWrite(ENC_B_PIN, 0);
+
+  Serial.begin(REPLAY_BAUD);
 }
 
 // the loop function runs over and over again forever
 void loop() {
   readPot();
-  
-  *ENC_A_PORT |= ENC_A_PIN_MASK;
-  wait();
-  *ENC_B_PORT |= ENC_B_PIN_MASK;
-  wait();
-  *ENC_A_PORT &= ~ENC_A_PIN_MASK;
-  wait();
-  *ENC_B_PORT &= ~ENC_B_PIN_MASK;
-  wait();
 
+  if( Serial.available() ) {
+    replay();
+  }
+
+  for( uint8_t i = 0; i < 4; i++ ) {
+    step(true);
+    wait();
+  }
+}
+
+void step(bool forward) {
+  quadratureState = (quadratureState + (forward ? 1 : 3)) & 3;
+
+  if( quadratureState == 1 || quadratureState == 2 ) {
+    *ENC_A_PORT |= ENC_A_PIN_MASK;
+  } else {
+    *ENC_A_PORT &= ~ENC_A_PIN_MASK;
+  }
+  if( quadratureState >= 2 ) {
+    *ENC_B_PORT |= ENC_B_PIN_MASK;
+  } else {
+    *ENC_B_PORT &= ~ENC_B_PIN_MASK;
+  }
+}
+
+void replay() {
+  digitalWrite(LED_BUILTIN, HIGH);
+
+  uint8_t used = 0;
+  unsigned long lastData = millis();
+  unsigned long deadline = micros();
+
+  for(;;) {
+    if( Serial.available() == 0 ) {
+      if( millis() - lastData > REPLAY_TIMEOUT_MS ) {
+        break;
+      }
+      // the sender fell behind; carry on from whenever it catches up
+      deadline = micros();
+      continue;
+    }
+    lastData = millis();
+
+    uint8_t record = Serial.read();
+    if( ++used == REPLAY_CREDIT ) {
+      Serial.write('+');
+      used = 0;
+    }
+
+    if( record == REPLAY_WAIT ) {
+      deadline += 128 * REPLAY_TICK_US;
+      continue;
+    }
+    deadline += (record & ~REPLAY_BACKWARD) * REPLAY_TICK_US;
+    while( (long)(micros() - deadline) < 0 );
+    step(!(record & REPLAY_BACKWARD));
+  }
+
+  digitalWrite(LED_BUILTIN, LOW);
 }
 
 void wait() {
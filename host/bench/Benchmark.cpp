@@ -0,0 +1,56 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+//
+// ISR benchmark, host build
+//
+// Prints the same report the ENABLE_ISR_BENCHMARK firmware sends, timed in
+// host timestamp counter cycles.  The numbers only compare with other runs on
+// the same machine, so the baselines in tools/isr_baselines that
+// tools/isr_bench.py checks them against hold for the machine that saved them.
+//
+
+#include <stdio.h>
+
+#include "Registers.h"
+#include "IsrBenchmark.h"
+
+
+int main(void)
+{
+    Clock clock;
+    clock.initHardware();
+
+    EEPROM eeprom(NULL);
+    FeedTableFactory feedTableFactory(&eeprom);
+    IsrBenchmark isrBenchmark(&clock, &feedTableFactory, NULL);
+
+    while( isrBenchmark.buildLine() ) {
+        fwrite(isrBenchmark.getLine(), 1, isrBenchmark.getLineLength(), stdout);
+    }
+
+    return 0;
+}
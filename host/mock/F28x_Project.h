@@ -0,0 +1,78 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef F28X_PROJECT_H
+#define F28X_PROJECT_H
+
+//
+// Host stand-in for the TI device support header
+//
+// Firmware sources built for the PC include this instead of the real
+// F28x_Project.h.  It keeps the C28x integer widths, turns the compiler
+// extensions and interrupt instructions into nothing, and then pulls in TI's
+// own register definitions, so the firmware reads and writes the same register
+// fields it does on the chip.  The registers themselves are plain memory,
+// defined in Registers.cpp, except for the cycle counter, which runs; see
+// Registers.h for the hardware behavior the models have to supply.
+//
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// C28x data types, at their C28x widths
+#define DSP28_DATA_TYPES
+#define F28_DATA_TYPES
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef uint16_t Uint16;
+typedef uint32_t Uint32;
+typedef uint64_t Uint64;
+typedef unsigned char Uint8;
+typedef float float32;
+typedef double float64;
+
+// compiler extensions
+#define __interrupt
+#define interrupt
+#define __asm(x)
+#define asm(x)
+#define __attribute__(x)
+
+// protected register access has no meaning here
+static inline void __eallow(void) {}
+static inline void __edis(void) {}
+
+#include "f28004x_device.h"
+#include "f28004x_examples.h"
+
+// CPU Timer 1 is the firmware's cycle counter; on the host it counts down
+// with the processor's timestamp counter, refreshed on every access
+volatile struct CPUTIMER_REGS &hostCpuTimer1(void);
+#define CpuTimer1Regs hostCpuTimer1()
+
+#endif // F28X_PROJECT_H
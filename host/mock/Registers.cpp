@@ -0,0 +1,78 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "Registers.h"
+
+
+// Peripheral register blocks used by the firmware modules built for the host
+volatile struct EQEP_REGS EQep1Regs;
+volatile struct EQEP_REGS EQep2Regs;
+volatile struct GPIO_CTRL_REGS GpioCtrlRegs;
+volatile struct GPIO_DATA_REGS GpioDataRegs;
+volatile struct SPI_REGS SpibRegs;
+volatile struct SCI_REGS SciaRegs;
+volatile struct CLK_CFG_REGS ClkCfgRegs;
+volatile struct CPU_SYS_REGS CpuSysRegs;
+
+
+// CPU Timer 1 counts down from its maximum period, as Clock expects
+static volatile struct CPUTIMER_REGS cpuTimer1;
+
+volatile struct CPUTIMER_REGS &hostCpuTimer1(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    Uint32 cycles = (Uint32)__rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    Uint32 cycles = (Uint32)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+#endif
+    cpuTimer1.TIM.all = 0xFFFFFFFF - cycles;
+    return cpuTimer1;
+}
+
+
+// Busy-wait delays take no simulated time
+void F28x_usDelay(long)
+{
+}
+
+
+void latchGpio(void)
+{
+    GpioDataRegs.GPADAT.all = (GpioDataRegs.GPADAT.all | GpioDataRegs.GPASET.all) & ~GpioDataRegs.GPACLEAR.all;
+    GpioDataRegs.GPASET.all = 0;
+    GpioDataRegs.GPACLEAR.all = 0;
+
+    GpioDataRegs.GPBDAT.all = (GpioDataRegs.GPBDAT.all | GpioDataRegs.GPBSET.all) & ~GpioDataRegs.GPBCLEAR.all;
+    GpioDataRegs.GPBSET.all = 0;
+    GpioDataRegs.GPBCLEAR.all = 0;
+}
@@ -0,0 +1,55 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __REGISTERS_H
+#define __REGISTERS_H
+
+#include "F28x_Project.h"
+
+
+//
+// Mock peripheral registers
+//
+// The register blocks are ordinary structures, so anything the hardware does
+// on its own has to be done by the models between ISR calls:
+//
+//   - the encoder model writes the eQEP position counter, wrapped at
+//     QPOSMAX as the counter would be
+//   - latchGpio() applies the writes the firmware made to the GPIO set and
+//     clear registers to the data register, and clears them, as the
+//     write-one-to-set/clear hardware would
+//   - inputs, like the servo alarm, are written straight into the data
+//     register
+//
+// CPU Timer 1 is the exception: it runs from the host's timestamp counter, so
+// Clock::getCycles() times host code in host cycles.
+//
+
+// apply GPxSET/GPxCLEAR writes to GPxDAT; call after every ISR
+void latchGpio(void);
+
+
+#endif // __REGISTERS_H
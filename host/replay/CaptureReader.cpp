@@ -0,0 +1,171 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <stdio.h>
+
+#include "CaptureReader.h"
+#include "Encoder.h"
+#include "EncoderCapture.h"
+
+
+typedef struct BLOCK
+{
+    Uint16 sequence;
+    Uint32 start;
+    Uint16 codes[CAPTURE_BLOCK_TICKS];
+} BLOCK;
+
+
+// signed difference between two encoder counts, the short way round
+static int32 countDifference(Uint32 to, Uint32 from)
+{
+    int32 difference = (int32)((to - from) & _ENCODER_MAX_COUNT);
+    if( difference > (int32)(_ENCODER_MAX_COUNT / 2) ) {
+        difference -= (int32)_ENCODER_MAX_COUNT + 1;
+    }
+    return difference;
+}
+
+static Uint32 getWord(const std::vector<unsigned char> &bytes, size_t at)
+{
+    return bytes[at] | (bytes[at + 1] << 8);
+}
+
+CaptureReader :: CaptureReader(void)
+{
+    this->frames = 0;
+    this->badFrames = 0;
+    this->missingBlocks = 0;
+    this->escapes = 0;
+    this->unresolved = 0;
+}
+
+bool CaptureReader :: load(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if( file == NULL ) {
+        return false;
+    }
+    std::vector<unsigned char> bytes;
+    unsigned char buffer[65536];
+    size_t length;
+    while( (length = fread(buffer, 1, sizeof(buffer), file)) > 0 ) {
+        bytes.insert(bytes.end(), buffer, buffer + length);
+    }
+    fclose(file);
+
+    // pick out the frames
+    std::vector<BLOCK> blocks;
+    size_t at = 0;
+    while( at + CAPTURE_FRAME_BYTES <= bytes.size() ) {
+        if( bytes[at] != CAPTURE_SYNC1 || bytes[at + 1] != CAPTURE_SYNC2 ) {
+            at++;
+            continue;
+        }
+
+        Uint16 sum1 = 0, sum2 = 0;
+        for( size_t i = at + 2; i < at + CAPTURE_FRAME_BYTES - 2; i++ ) {
+            sum1 = (sum1 + bytes[i]) % 255;
+            sum2 = (sum2 + sum1) % 255;
+        }
+        if( sum1 != bytes[at + CAPTURE_FRAME_BYTES - 2] || sum2 != bytes[at + CAPTURE_FRAME_BYTES - 1] ) {
+            // not a real frame; look for the next sync after this one
+            this->badFrames++;
+            at++;
+            continue;
+        }
+
+        BLOCK block;
+        block.sequence = getWord(bytes, at + 2);
+        block.start = getWord(bytes, at + 4) | (getWord(bytes, at + 6) << 16);
+        for( Uint16 tick = 0; tick < CAPTURE_BLOCK_TICKS; tick++ ) {
+            Uint16 byte = bytes[at + 10 + tick / 4];
+            block.codes[tick] = (byte >> ((tick % 4) * 2)) & 3;
+        }
+        blocks.push_back(block);
+
+        this->frames++;
+        at += CAPTURE_FRAME_BYTES;
+    }
+
+    // rebuild the count, tick by tick
+    this->counts.clear();
+    for( size_t b = 0; b < blocks.size(); b++ ) {
+        const BLOCK *block = &blocks[b];
+        Uint32 count = block->start;
+
+        if( b > 0 ) {
+            Uint32 missing = (Uint16)(block->sequence - blocks[b - 1].sequence - 1);
+            Uint32 ticks = missing * CAPTURE_BLOCK_TICKS;
+            this->missingBlocks += missing;
+
+            // run from the end of the last block to this one's start
+            Uint32 from = this->counts.back();
+            int32 travel = countDifference(block->start, from);
+            for( Uint32 tick = 1; tick <= ticks; tick++ ) {
+                int32 move = (int32)((int64)travel * tick / (ticks + 1));
+                this->counts.push_back((from + move) & _ENCODER_MAX_COUNT);
+            }
+        }
+
+        // where the block ends, from the codes alone
+        int32 known = 0;
+        Uint16 blockEscapes = 0;
+        for( Uint16 tick = 0; tick < CAPTURE_BLOCK_TICKS; tick++ ) {
+            switch( block->codes[tick] ) {
+            case CAPTURE_CODE_FORWARD: known++; break;
+            case CAPTURE_CODE_BACKWARD: known--; break;
+            case CAPTURE_CODE_ESCAPE: blockEscapes++; break;
+            }
+        }
+        this->escapes += blockEscapes;
+
+        // settle the escapes from the next block, if it follows straight on
+        int32 share = 0, extra = 0;
+        if( blockEscapes > 0 ) {
+            if( b + 1 < blocks.size() && (Uint16)(blocks[b + 1].sequence - block->sequence) == 1 ) {
+                int32 rest = countDifference(blocks[b + 1].start, block->start) - known;
+                share = rest / blockEscapes;
+                extra = rest - share * blockEscapes;
+            }
+            else {
+                this->unresolved += blockEscapes;
+            }
+        }
+
+        for( Uint16 tick = 0; tick < CAPTURE_BLOCK_TICKS; tick++ ) {
+            switch( block->codes[tick] ) {
+            case CAPTURE_CODE_FORWARD: count++; break;
+            case CAPTURE_CODE_BACKWARD: count--; break;
+            case CAPTURE_CODE_ESCAPE: count += share + extra; extra = 0; break;
+            }
+            count &= _ENCODER_MAX_COUNT;
+            this->counts.push_back(count);
+        }
+    }
+
+    return true;
+}
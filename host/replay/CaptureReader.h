@@ -0,0 +1,109 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __CAPTUREREADER_H
+#define __CAPTUREREADER_H
+
+#include <vector>
+
+#include "F28x_Project.h"
+
+
+//
+// Capture reader
+//
+// Decodes the stream EncoderCapture sends (see EncoderCapture.h in
+// els-f280049c) back into the encoder count on every ISR tick.  The stream is
+// read from a file of raw serial bytes, as tools/capture.py records it.
+//
+//   - frames with a bad checksum are skipped, and the reader resynchronizes
+//     on the next sync bytes
+//   - a tick marked as an escape (a move of more than one count) gets the
+//     difference between the block's end and the next block's start, shared
+//     between the block's escapes
+//   - blocks missing from the sequence are filled by moving the count
+//     steadily from where the last block ended to where the next one starts
+//
+class CaptureReader
+{
+private:
+    std::vector<Uint32> counts;
+
+    Uint32 frames;
+    Uint32 badFrames;
+    Uint32 missingBlocks;
+    Uint32 escapes;
+    Uint32 unresolved;          // escapes with no following block to settle them
+
+public:
+    CaptureReader(void);
+
+    // read and decode a capture; false if the file can't be read
+    bool load(const char *path);
+
+    // encoder count at each tick
+    const std::vector<Uint32> &getCounts(void);
+
+    Uint32 getFrames(void);
+    Uint32 getBadFrames(void);
+    Uint32 getMissingBlocks(void);
+    Uint32 getEscapes(void);
+    Uint32 getUnresolved(void);
+};
+
+
+inline const std::vector<Uint32> &CaptureReader :: getCounts(void)
+{
+    return this->counts;
+}
+
+inline Uint32 CaptureReader :: getFrames(void)
+{
+    return this->frames;
+}
+
+inline Uint32 CaptureReader :: getBadFrames(void)
+{
+    return this->badFrames;
+}
+
+inline Uint32 CaptureReader :: getMissingBlocks(void)
+{
+    return this->missingBlocks;
+}
+
+inline Uint32 CaptureReader :: getEscapes(void)
+{
+    return this->escapes;
+}
+
+inline Uint32 CaptureReader :: getUnresolved(void)
+{
+    return this->unresolved;
+}
+
+
+#endif // __CAPTUREREADER_H
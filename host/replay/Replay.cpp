@@ -0,0 +1,333 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+//
+// Capture replay
+//
+// Plays an encoder capture recorded with USE_ENCODER_CAPTURE through the real
+// Core, Encoder and StepperDrive, one ISR tick per captured count and as fast
+// as the PC will go, and reports how well the carriage kept to the captured
+// spindle for each feed table row, in the same terms as the virtual lathe.
+// Keep captures of awkward spindles next to the fixes they prompted and
+// replay them after every change to the engine.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Registers.h"
+#include "Core.h"
+#include "CarriageModel.h"
+#include "SyncMeter.h"
+#include "CaptureReader.h"
+
+
+#define TICK_SECONDS (STEPPER_CYCLE_US / 1e6)
+
+// the background loop checks the backlog about this often
+#define BACKGROUND_SECONDS 0.001
+
+// carriage travel per step, in microns
+#if defined(LEADSCREW_TPI)
+#define THREAD_STEP_UM (25400.0 / LEADSCREW_TPI / STEPPER_RESOLUTION / STEPPER_MICROSTEPS)
+#define FEED_STEP_UM (25400.0 / LEADSCREW_TPI / STEPPER_RESOLUTION_FEED / STEPPER_MICROSTEPS_FEED)
+#endif
+#if defined(LEADSCREW_HMM)
+#define THREAD_STEP_UM (LEADSCREW_HMM * 10.0 / STEPPER_RESOLUTION / STEPPER_MICROSTEPS)
+#define FEED_STEP_UM (LEADSCREW_HMM * 10.0 / STEPPER_RESOLUTION_FEED / STEPPER_MICROSTEPS_FEED)
+#endif
+
+
+typedef struct OPTIONS
+{
+    const char *capture;
+    double maxStepRate;
+    bool reverse;
+    int table;                  // -1 for all
+    int row;                    // -1 for all
+    const char *csv;
+} OPTIONS;
+
+typedef struct RESULT
+{
+    double pitchError;          // ppm
+    double maxPhase;            // microns
+    double rmsPhase;            // microns
+    int32 maxBacklog;           // steps
+    Uint32 lostSteps;
+    double tripTime;            // seconds, or negative if it never tripped
+} RESULT;
+
+static const char *TABLE_NAMES[] = { "inch-thread", "inch-feed", "metric-thread", "metric-feed" };
+
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: replayer [options] CAPTURE\n"
+            "  --table NAME         inch-thread, inch-feed, metric-thread, metric-feed (default all)\n"
+            "  --row N              one row of the table (default all)\n"
+            "  --reverse            run the leadscrew reversed\n"
+            "  --max-step-rate HZ   fastest the stepper follows, 0 for no limit (default 0)\n"
+            "  --csv FILE           write the run to FILE every millisecond (one row only)\n");
+    exit(2);
+}
+
+static void parseOptions(int argc, char **argv, OPTIONS *options)
+{
+    options->capture = NULL;
+    options->maxStepRate = 0;
+    options->reverse = false;
+    options->table = -1;
+    options->row = -1;
+    options->csv = NULL;
+
+    for( int i = 1; i < argc; i++ ) {
+        const char *name = argv[i];
+        if( strcmp(name, "--reverse") == 0 ) {
+            options->reverse = true;
+            continue;
+        }
+        if( strncmp(name, "--", 2) != 0 ) {
+            if( options->capture != NULL ) usage();
+            options->capture = name;
+            continue;
+        }
+        if( i + 1 >= argc ) usage();
+        const char *value = argv[++i];
+
+        if( strcmp(name, "--table") == 0 ) {
+            options->table = -1;
+            for( int t = 0; t < 4; t++ ) {
+                if( strcmp(value, TABLE_NAMES[t]) == 0 ) options->table = t;
+            }
+            if( options->table < 0 && strcmp(value, "all") != 0 ) usage();
+        }
+        else if( strcmp(name, "--row") == 0 ) options->row = atoi(value);
+        else if( strcmp(name, "--max-step-rate") == 0 ) options->maxStepRate = atof(value);
+        else if( strcmp(name, "--csv") == 0 ) options->csv = value;
+        else usage();
+    }
+
+    if( options->capture == NULL ) usage();
+}
+
+// Run one row through the whole capture
+static void run(const OPTIONS *options, const std::vector<Uint32> &counts, const FEED_THREAD *row,
+                double stepLength, RESULT *result)
+{
+    // fresh firmware objects and registers for every run
+    memset((void *)&GpioDataRegs, 0, sizeof(GpioDataRegs));
+    memset((void *)&ENCODER_REGS, 0, sizeof(ENCODER_REGS));
+
+    Encoder encoder;
+    StepperDrive stepperDrive;
+    Core core(&encoder, &stepperDrive);
+
+    double ratio = (double)row->numerator / row->denominator;
+    CarriageModel carriage(options->maxStepRate);
+    SyncMeter meter(options->reverse ? -ratio : ratio);
+
+    FILE *csv = NULL;
+    if( options->csv != NULL ) {
+        csv = fopen(options->csv, "w");
+        if( csv == NULL ) {
+            perror(options->csv);
+            exit(1);
+        }
+        fprintf(csv, "time,spindle_counts,carriage_steps,ideal_steps,backlog\n");
+    }
+
+    encoder.initHardware();
+    stepperDrive.initHardware();
+
+    // the servo drive is healthy
+#ifdef INVERT_ALARM_PIN
+    GpioDataRegs.GPADAT.bit.ALARM_PIN = 1;
+#else
+    GpioDataRegs.GPADAT.bit.ALARM_PIN = 0;
+#endif
+
+    core.setFeed(row);
+    core.setReverse(options->reverse);
+    core.publish();
+    core.setPowerOn(true);
+    latchGpio();
+
+    Uint32 backgroundTicks = (Uint32)(BACKGROUND_SECONDS / TICK_SECONDS);
+    result->tripTime = -1;
+
+    // the captured count, unwrapped, stands in for the true spindle angle
+    int64 spindle = 0;
+
+    for( Uint32 tick = 0; tick < counts.size(); tick++ ) {
+        double time = tick * TICK_SECONDS;
+
+        if( tick > 0 ) {
+            int32 move = (int32)((counts[tick] - counts[tick - 1]) & _ENCODER_MAX_COUNT);
+            if( move > (int32)(_ENCODER_MAX_COUNT / 2) ) move -= (int32)_ENCODER_MAX_COUNT + 1;
+            spindle += move;
+        }
+
+        ENCODER_REGS.QPOSCNT = counts[tick];
+        core.ISR();
+        latchGpio();
+        carriage.update(time);
+
+        if( tick == 0 ) {
+            // the engine syncs the carriage to the spindle on its first tick
+            meter.start(spindle);
+        }
+        meter.add(spindle, carriage.getPosition(), stepperDrive.getBacklog());
+
+        if( tick % backgroundTicks == 0 ) {
+            if( stepperDrive.checkStepBacklog() && result->tripTime < 0 ) {
+                result->tripTime = time;
+            }
+            if( csv != NULL ) {
+                fprintf(csv, "%.3f,%lld,%ld,%.2f,%ld\n", time, (long long)spindle,
+                        (long)carriage.getPosition(), meter.getIdeal(spindle), (long)stepperDrive.getBacklog());
+            }
+        }
+    }
+
+    if( csv != NULL ) {
+        fclose(csv);
+    }
+
+    result->pitchError = meter.getPitchError();
+    result->maxPhase = meter.getMaxPhaseError() * stepLength;
+    result->rmsPhase = meter.getRmsPhaseError() * stepLength;
+    result->maxBacklog = meter.getMaxBacklog();
+    result->lostSteps = carriage.getLostSteps();
+}
+
+// Summarize the spindle in the capture: travel and top speed over 10ms
+static void describe(const OPTIONS *options, CaptureReader *reader)
+{
+    const std::vector<Uint32> &counts = reader->getCounts();
+    Uint32 window = (Uint32)(0.01 / TICK_SECONDS);
+    int64 travel = 0, windowTravel = 0;
+    double topRPM = 0;
+
+    for( Uint32 tick = 1; tick < counts.size(); tick++ ) {
+        int32 move = (int32)((counts[tick] - counts[tick - 1]) & _ENCODER_MAX_COUNT);
+        if( move > (int32)(_ENCODER_MAX_COUNT / 2) ) move -= (int32)_ENCODER_MAX_COUNT + 1;
+        travel += move;
+        windowTravel += move;
+        if( tick % window == 0 ) {
+            double rpm = (double)windowTravel / ENCODER_RESOLUTION / (window * TICK_SECONDS) * 60;
+            if( rpm > topRPM ) topRPM = rpm;
+            if( -rpm > topRPM ) topRPM = -rpm;
+            windowTravel = 0;
+        }
+    }
+
+    printf("%s: %.3fs, %.1f revolutions net, top speed %.0f RPM\n", options->capture,
+           counts.size() * TICK_SECONDS, (double)travel / ENCODER_RESOLUTION, topRPM);
+    printf("%lu frames, %lu bad, %lu blocks missing, %lu escapes, %lu unresolved\n\n",
+           (unsigned long)reader->getFrames(), (unsigned long)reader->getBadFrames(),
+           (unsigned long)reader->getMissingBlocks(), (unsigned long)reader->getEscapes(),
+           (unsigned long)reader->getUnresolved());
+}
+
+int main(int argc, char **argv)
+{
+    OPTIONS options;
+    parseOptions(argc, argv, &options);
+
+    CaptureReader reader;
+    if( ! reader.load(options.capture) ) {
+        perror(options.capture);
+        return 2;
+    }
+    if( reader.getCounts().empty() ) {
+        fprintf(stderr, "%s: no capture frames\n", options.capture);
+        return 2;
+    }
+    describe(&options, &reader);
+
+    EEPROM eeprom(NULL);
+    FeedTableFactory feedTableFactory(&eeprom);
+    int failures = 0;
+    int runs = 0;
+
+    printf("%-13s %-6s %12s %10s %10s %10s %8s %6s  %s\n", "table", "row", "steps/rev", "pitch ppm",
+           "phase um", "rms um", "backlog", "lost", "result");
+
+    for( int t = 0; t < 4; t++ ) {
+        if( options.table >= 0 && options.table != t ) continue;
+
+        bool metric = t >= 2;
+        bool thread = (t % 2) == 0;
+        double stepLength = thread ? THREAD_STEP_UM : FEED_STEP_UM;
+        FeedTable *table = feedTableFactory.getFeedTable(metric, thread);
+
+        // walk the rows until the table stops advancing
+        table->setSelectedRow(0);
+        for( int r = 0; ; r++ ) {
+            const FEED_THREAD *row = table->current();
+
+            if( options.row < 0 || options.row == r ) {
+                RESULT result;
+                run(&options, reader.getCounts(), row, stepLength, &result);
+                runs++;
+
+                char verdict[32];
+                if( result.tripTime >= 0 ) {
+                    snprintf(verdict, sizeof(verdict), "TRIP at %.3fs", result.tripTime);
+                }
+                else if( result.lostSteps > 0 ) {
+                    snprintf(verdict, sizeof(verdict), "LOST STEPS");
+                }
+                else {
+                    snprintf(verdict, sizeof(verdict), "ok");
+                }
+                if( result.tripTime >= 0 || result.lostSteps > 0 ) failures++;
+
+                printf("%-13s %-6s %12.3f %10.1f %10.2f %10.2f %8ld %6lu  %s\n", TABLE_NAMES[t], row->label,
+                       (double)row->numerator / row->denominator * ENCODER_RESOLUTION, result.pitchError,
+                       result.maxPhase, result.rmsPhase, (long)result.maxBacklog, (unsigned long)result.lostSteps,
+                       verdict);
+            }
+
+            Uint16 selected = table->getSelectedRow();
+            table->next();
+            if( table->getSelectedRow() == selected ) break;
+        }
+    }
+
+    if( runs == 0 ) {
+        fprintf(stderr, "no such row\n");
+        return 2;
+    }
+    if( options.csv != NULL && runs > 1 ) {
+        fprintf(stderr, "note: --csv holds only the last run\n");
+    }
+
+    return failures ? 1 : 0;
+}
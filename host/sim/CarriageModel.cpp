@@ -0,0 +1,77 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "CarriageModel.h"
+#include "StepperDrive.h"
+
+
+// logical levels of the drive outputs, through the polarity StepperDrive uses
+#ifdef INVERT_STEP_PIN
+#define STEP_ACTIVE (GPIO_GET(STEP_PIN) == 0)
+#else
+#define STEP_ACTIVE (GPIO_GET(STEP_PIN) != 0)
+#endif
+
+#ifdef INVERT_DIRECTION_PIN
+#define DIRECTION_FORWARD (GPIO_GET(DIRECTION_PIN) == 0)
+#else
+#define DIRECTION_FORWARD (GPIO_GET(DIRECTION_PIN) != 0)
+#endif
+
+#ifdef INVERT_ENABLE_PIN
+#define DRIVE_ENABLED (GPIO_GET(ENABLE_PIN) == 0)
+#else
+#define DRIVE_ENABLED (GPIO_GET(ENABLE_PIN) != 0)
+#endif
+
+
+CarriageModel :: CarriageModel(double maxStepRate)
+{
+    this->minimumInterval = (maxStepRate > 0) ? 1 / maxStepRate : 0;
+
+    this->step = false;
+    this->lastStep = -1;
+
+    this->position = 0;
+    this->lostSteps = 0;
+}
+
+void CarriageModel :: update(double time)
+{
+    bool step = STEP_ACTIVE;
+
+    if( step && ! this->step && DRIVE_ENABLED ) {
+        if( time - this->lastStep < this->minimumInterval ) {
+            this->lostSteps++;
+        }
+        else {
+            this->position += DIRECTION_FORWARD ? 1 : -1;
+            this->lastStep = time;
+        }
+    }
+
+    this->step = step;
+}
@@ -0,0 +1,76 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __CARRIAGEMODEL_H
+#define __CARRIAGEMODEL_H
+
+#include "F28x_Project.h"
+
+
+//
+// Carriage model
+//
+// Watches the step, direction and enable outputs StepperDrive drives, and
+// moves the carriage one step on each leading edge of the step signal.  A
+// stepper can only follow pulses so fast: a step that comes sooner than the
+// maximum step rate allows after the last one is lost, and counted, instead of
+// moving the carriage.  Steps while the drive is disabled are ignored.
+//
+class CarriageModel
+{
+private:
+    double minimumInterval;     // seconds between steps the motor can follow
+
+    bool step;                  // step signal at the last update
+    double lastStep;            // time of the last step taken
+
+    int32 position;             // steps
+    Uint32 lostSteps;
+
+public:
+    // a maximum step rate of zero means no limit
+    CarriageModel(double maxStepRate);
+
+    // look at the drive outputs; call after every ISR
+    void update(double time);
+
+    int32 getPosition(void);
+    Uint32 getLostSteps(void);
+};
+
+
+inline int32 CarriageModel :: getPosition(void)
+{
+    return this->position;
+}
+
+inline Uint32 CarriageModel :: getLostSteps(void)
+{
+    return this->lostSteps;
+}
+
+
+#endif // __CARRIAGEMODEL_H
@@ -0,0 +1,73 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <math.h>
+
+#include "EncoderModel.h"
+#include "Encoder.h"
+
+
+EncoderModel :: EncoderModel(Uint32 resolution, Uint32 startCount, double jitter, double dropoutRate, Uint32 seed) :
+        random(seed), noise(0, 1), uniform(0, 1)
+{
+    this->resolution = resolution;
+    this->startCount = startCount;
+    this->jitter = jitter;
+    this->dropoutRate = dropoutRate;
+
+    this->edges = 0;
+    this->dropped = 0;
+}
+
+void EncoderModel :: update(double revolutions, double rpm)
+{
+    // a late or early edge shows up as the count of a slightly different angle
+    double count = getTrueCount(revolutions);
+    if( this->jitter > 0 ) {
+        count += noise(random) * this->jitter * rpm / 60 * this->resolution;
+    }
+
+    int64 edges = (int64)floor(count);
+
+    // every edge crossed is a chance to miss one
+    if( this->dropoutRate > 0 ) {
+        for( int64 i = this->edges; i < edges; i++ ) {
+            if( uniform(random) < this->dropoutRate ) this->dropped++;
+        }
+        for( int64 i = edges; i < this->edges; i++ ) {
+            if( uniform(random) < this->dropoutRate ) this->dropped--;
+        }
+    }
+    this->edges = edges;
+
+    // the counter runs from zero to QPOSMAX and wraps
+    int64 range = (int64)_ENCODER_MAX_COUNT + 1;
+    int64 position = (this->startCount + edges - this->dropped) % range;
+    if( position < 0 ) {
+        position += range;
+    }
+    ENCODER_REGS.QPOSCNT = (Uint32)position;
+}
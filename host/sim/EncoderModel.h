@@ -0,0 +1,86 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __ENCODERMODEL_H
+#define __ENCODERMODEL_H
+
+#include <random>
+
+#include "F28x_Project.h"
+
+
+//
+// Encoder model
+//
+// Turns the spindle angle into the count the eQEP would hold, and writes it to
+// the counter register the firmware reads.  The count is quantized to whole
+// edges and wraps at the counter's maximum.  Edge timing jitter is applied as
+// a random shift of the angle the count is taken at, so the count can land on
+// either side of an edge near a transition, and each edge can be dropped
+// outright with a fixed probability, which leaves the count permanently
+// short, as a missed edge would on the real counter.
+//
+class EncoderModel
+{
+private:
+    Uint32 resolution;          // counts per revolution
+    Uint32 startCount;          // counter value at zero revolutions
+    double jitter;              // edge timing jitter, seconds RMS
+    double dropoutRate;         // probability an edge is missed
+
+    std::mt19937 random;
+    std::normal_distribution<double> noise;
+    std::uniform_real_distribution<double> uniform;
+
+    int64 edges;                // edges seen by the model so far
+    int64 dropped;              // net edges the counter missed
+
+public:
+    EncoderModel(Uint32 resolution, Uint32 startCount, double jitter, double dropoutRate, Uint32 seed);
+
+    // take the count for the spindle angle and speed, and update the counter
+    void update(double revolutions, double rpm);
+
+    // the angle in counts, without quantization, jitter or dropouts
+    double getTrueCount(double revolutions);
+
+    // edges missed so far, net of direction
+    int64 getDropped(void);
+};
+
+
+inline double EncoderModel :: getTrueCount(double revolutions)
+{
+    return revolutions * this->resolution;
+}
+
+inline int64 EncoderModel :: getDropped(void)
+{
+    return this->dropped;
+}
+
+
+#endif // __ENCODERMODEL_H
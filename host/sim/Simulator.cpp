@@ -0,0 +1,373 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+//
+// Virtual lathe
+//
+// Runs the real Core, Encoder and StepperDrive against models of the spindle,
+// encoder and carriage, one ISR tick at a time, and reports how well the
+// carriage kept to the thread for each feed table row.  The spindle starts,
+// comes up to speed, takes a load dip, optionally reverses, and stops; see
+// usage() for the knobs.
+//
+// It can also record the simulated encoder with the firmware's encoder
+// capture, to try the replay tools without a lathe.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Registers.h"
+#include "Core.h"
+#include "EncoderCapture.h"
+#include "SpindleModel.h"
+#include "EncoderModel.h"
+#include "CarriageModel.h"
+#include "SyncMeter.h"
+
+
+#define TICK_SECONDS (STEPPER_CYCLE_US / 1e6)
+
+// the background loop checks the backlog about this often
+#define BACKGROUND_SECONDS 0.001
+
+// carriage travel per step, in microns
+#if defined(LEADSCREW_TPI)
+#define THREAD_STEP_UM (25400.0 / LEADSCREW_TPI / STEPPER_RESOLUTION / STEPPER_MICROSTEPS)
+#define FEED_STEP_UM (25400.0 / LEADSCREW_TPI / STEPPER_RESOLUTION_FEED / STEPPER_MICROSTEPS_FEED)
+#endif
+#if defined(LEADSCREW_HMM)
+#define THREAD_STEP_UM (LEADSCREW_HMM * 10.0 / STEPPER_RESOLUTION / STEPPER_MICROSTEPS)
+#define FEED_STEP_UM (LEADSCREW_HMM * 10.0 / STEPPER_RESOLUTION_FEED / STEPPER_MICROSTEPS_FEED)
+#endif
+
+
+typedef struct OPTIONS
+{
+    double rpm;
+    double seconds;
+    double timeConstant;
+    double acceleration;
+    double dip;
+    bool reverse;
+    double jitter;
+    double dropout;
+    double maxStepRate;
+    Uint32 startCount;
+    Uint32 seed;
+    int table;                  // -1 for all
+    int row;                    // -1 for all
+    const char *csv;
+    const char *capture;
+} OPTIONS;
+
+typedef struct RESULT
+{
+    double pitchError;          // ppm
+    double maxPhase;            // microns
+    double rmsPhase;            // microns
+    int32 maxBacklog;           // steps
+    Uint32 lostSteps;
+    int64 droppedCounts;
+    double tripTime;            // seconds, or negative if it never tripped
+} RESULT;
+
+static const char *TABLE_NAMES[] = { "inch-thread", "inch-feed", "metric-thread", "metric-feed" };
+
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: simulator [options]\n"
+            "  --table NAME         inch-thread, inch-feed, metric-thread, metric-feed (default all)\n"
+            "  --row N              one row of the table (default all)\n"
+            "  --rpm R              spindle speed (default 500)\n"
+            "  --seconds S          length of each run (default 2)\n"
+            "  --time-constant S    spindle response to a speed change (default 0.1)\n"
+            "  --acceleration A     spindle acceleration limit, RPM/s (default 2000)\n"
+            "  --dip PCT            speed lost to the load dip at 40%% of the run (default 20)\n"
+            "  --reverse            reverse the spindle at 50%% of the run\n"
+            "  --jitter NS          encoder edge jitter, ns RMS (default 0)\n"
+            "  --dropout P          probability each encoder edge is missed (default 0)\n"
+            "  --max-step-rate HZ   fastest the stepper follows, 0 for no limit (default 0)\n"
+            "  --start-count N      encoder count at the start, to exercise the wrap\n"
+            "  --seed N             random seed (default 1)\n"
+            "  --csv FILE           write the run to FILE every millisecond (one row only)\n"
+            "  --capture FILE       record the encoder to FILE as USE_ENCODER_CAPTURE would (one row only)\n");
+    exit(2);
+}
+
+static void parseOptions(int argc, char **argv, OPTIONS *options)
+{
+    options->rpm = 500;
+    options->seconds = 2;
+    options->timeConstant = 0.1;
+    options->acceleration = 2000;
+    options->dip = 20;
+    options->reverse = false;
+    options->jitter = 0;
+    options->dropout = 0;
+    options->maxStepRate = 0;
+    options->startCount = 0;
+    options->seed = 1;
+    options->table = -1;
+    options->row = -1;
+    options->csv = NULL;
+    options->capture = NULL;
+
+    for( int i = 1; i < argc; i++ ) {
+        const char *name = argv[i];
+        if( strcmp(name, "--reverse") == 0 ) {
+            options->reverse = true;
+            continue;
+        }
+        if( i + 1 >= argc ) usage();
+        const char *value = argv[++i];
+
+        if( strcmp(name, "--table") == 0 ) {
+            options->table = -1;
+            for( int t = 0; t < 4; t++ ) {
+                if( strcmp(value, TABLE_NAMES[t]) == 0 ) options->table = t;
+            }
+            if( options->table < 0 && strcmp(value, "all") != 0 ) usage();
+        }
+        else if( strcmp(name, "--row") == 0 ) options->row = atoi(value);
+        else if( strcmp(name, "--rpm") == 0 ) options->rpm = atof(value);
+        else if( strcmp(name, "--seconds") == 0 ) options->seconds = atof(value);
+        else if( strcmp(name, "--time-constant") == 0 ) options->timeConstant = atof(value);
+        else if( strcmp(name, "--acceleration") == 0 ) options->acceleration = atof(value);
+        else if( strcmp(name, "--dip") == 0 ) options->dip = atof(value);
+        else if( strcmp(name, "--jitter") == 0 ) options->jitter = atof(value) * 1e-9;
+        else if( strcmp(name, "--dropout") == 0 ) options->dropout = atof(value);
+        else if( strcmp(name, "--max-step-rate") == 0 ) options->maxStepRate = atof(value);
+        else if( strcmp(name, "--start-count") == 0 ) options->startCount = strtoul(value, NULL, 0);
+        else if( strcmp(name, "--seed") == 0 ) options->seed = strtoul(value, NULL, 0);
+        else if( strcmp(name, "--csv") == 0 ) options->csv = value;
+        else if( strcmp(name, "--capture") == 0 ) options->capture = value;
+        else usage();
+    }
+
+    if( options->seconds <= 0 || options->timeConstant <= 0 || options->acceleration <= 0 ) usage();
+}
+
+// Take what the capture has ready, through an SCI that holds one byte at a time
+static void drainCapture(EncoderCapture *capture, FILE *file)
+{
+    SciaRegs.SCIFFTX.bit.TXFFST = SERIAL_FIFO_DEPTH - 1;
+    for( ;; ) {
+        SciaRegs.SCITXBUF.all = 0xffff;
+        capture->service();
+        if( SciaRegs.SCITXBUF.all == 0xffff ) {
+            break;
+        }
+        fputc(SciaRegs.SCITXBUF.all, file);
+    }
+}
+
+// Run one row through the whole spindle profile
+static void run(const OPTIONS *options, const FEED_THREAD *row, double stepLength, RESULT *result)
+{
+    // fresh firmware objects and registers for every run
+    memset((void *)&GpioDataRegs, 0, sizeof(GpioDataRegs));
+    memset((void *)&ENCODER_REGS, 0, sizeof(ENCODER_REGS));
+
+    Encoder encoder;
+    StepperDrive stepperDrive;
+    Core core(&encoder, &stepperDrive);
+
+    SpindleModel spindle(options->timeConstant, options->acceleration);
+    EncoderModel encoderModel(ENCODER_RESOLUTION, options->startCount, options->jitter, options->dropout, options->seed);
+    CarriageModel carriage(options->maxStepRate);
+    SyncMeter meter((double)row->numerator / row->denominator);
+
+    FILE *csv = NULL;
+    if( options->csv != NULL ) {
+        csv = fopen(options->csv, "w");
+        if( csv == NULL ) {
+            perror(options->csv);
+            exit(1);
+        }
+        fprintf(csv, "time,rpm,spindle_counts,carriage_steps,ideal_steps,backlog\n");
+    }
+
+    SerialPort serialPort;
+    EncoderCapture capture(&encoder, &serialPort);
+    FILE *captureFile = NULL;
+    if( options->capture != NULL ) {
+        captureFile = fopen(options->capture, "wb");
+        if( captureFile == NULL ) {
+            perror(options->capture);
+            exit(1);
+        }
+    }
+
+    encoder.initHardware();
+    stepperDrive.initHardware();
+
+    // the servo drive is healthy
+#ifdef INVERT_ALARM_PIN
+    GpioDataRegs.GPADAT.bit.ALARM_PIN = 1;
+#else
+    GpioDataRegs.GPADAT.bit.ALARM_PIN = 0;
+#endif
+
+    core.setFeed(row);
+    core.setReverse(false);
+    core.publish();
+    core.setPowerOn(true);
+    latchGpio();
+
+    Uint32 ticks = (Uint32)(options->seconds / TICK_SECONDS);
+    Uint32 backgroundTicks = (Uint32)(BACKGROUND_SECONDS / TICK_SECONDS);
+    result->tripTime = -1;
+
+    spindle.setTarget(options->rpm);
+
+    for( Uint32 tick = 0; tick < ticks; tick++ ) {
+        double time = tick * TICK_SECONDS;
+        double fraction = (double)tick / ticks;
+
+        // start, load dip, reversal and stop
+        spindle.setLoad(fraction >= 0.4 && fraction < 0.5 ? options->dip / 100 : 0);
+        if( options->reverse && fraction >= 0.5 ) spindle.setTarget(-options->rpm);
+        if( fraction >= 0.8 ) spindle.setTarget(0);
+
+        spindle.step(TICK_SECONDS);
+        encoderModel.update(spindle.getRevolutions(), spindle.getRPM());
+
+        core.ISR();
+        if( captureFile != NULL ) {
+            capture.ISR();
+        }
+        latchGpio();
+        carriage.update(time);
+
+        double trueCount = encoderModel.getTrueCount(spindle.getRevolutions());
+        if( tick == 0 ) {
+            // the engine syncs the carriage to the spindle on its first tick
+            meter.start(trueCount);
+        }
+        meter.add(trueCount, carriage.getPosition(), stepperDrive.getBacklog());
+
+        if( tick % backgroundTicks == 0 ) {
+            if( stepperDrive.checkStepBacklog() && result->tripTime < 0 ) {
+                result->tripTime = time;
+            }
+            if( csv != NULL ) {
+                fprintf(csv, "%.3f,%.1f,%.1f,%ld,%.2f,%ld\n", time, spindle.getRPM(), trueCount,
+                        (long)carriage.getPosition(), meter.getIdeal(trueCount), (long)stepperDrive.getBacklog());
+            }
+            if( captureFile != NULL ) {
+                drainCapture(&capture, captureFile);
+            }
+        }
+    }
+
+    if( csv != NULL ) {
+        fclose(csv);
+    }
+    if( captureFile != NULL ) {
+        drainCapture(&capture, captureFile);
+        fclose(captureFile);
+    }
+
+    result->pitchError = meter.getPitchError();
+    result->maxPhase = meter.getMaxPhaseError() * stepLength;
+    result->rmsPhase = meter.getRmsPhaseError() * stepLength;
+    result->maxBacklog = meter.getMaxBacklog();
+    result->lostSteps = carriage.getLostSteps();
+    result->droppedCounts = encoderModel.getDropped();
+}
+
+int main(int argc, char **argv)
+{
+    OPTIONS options;
+    parseOptions(argc, argv, &options);
+
+    EEPROM eeprom(NULL);
+    FeedTableFactory feedTableFactory(&eeprom);
+    int failures = 0;
+    int runs = 0;
+
+    printf("%-13s %-6s %12s %10s %10s %10s %8s %6s %7s  %s\n", "table", "row", "steps/rev", "pitch ppm",
+           "phase um", "rms um", "backlog", "lost", "dropped", "result");
+
+    for( int t = 0; t < 4; t++ ) {
+        if( options.table >= 0 && options.table != t ) continue;
+
+        bool metric = t >= 2;
+        bool thread = (t % 2) == 0;
+        double stepLength = thread ? THREAD_STEP_UM : FEED_STEP_UM;
+        FeedTable *table = feedTableFactory.getFeedTable(metric, thread);
+
+        // walk the rows until the table stops advancing
+        table->setSelectedRow(0);
+        for( int r = 0; ; r++ ) {
+            const FEED_THREAD *row = table->current();
+
+            if( options.row < 0 || options.row == r ) {
+                RESULT result;
+                run(&options, row, stepLength, &result);
+                runs++;
+
+                char verdict[32];
+                if( result.tripTime >= 0 ) {
+                    snprintf(verdict, sizeof(verdict), "TRIP at %.3fs", result.tripTime);
+                }
+                else if( result.lostSteps > 0 ) {
+                    snprintf(verdict, sizeof(verdict), "LOST STEPS");
+                }
+                else {
+                    snprintf(verdict, sizeof(verdict), "ok");
+                }
+                if( result.tripTime >= 0 || result.lostSteps > 0 ) failures++;
+
+                printf("%-13s %-6s %12.3f %10.1f %10.2f %10.2f %8ld %6lu %7lld  %s\n", TABLE_NAMES[t], row->label,
+                       (double)row->numerator / row->denominator * ENCODER_RESOLUTION, result.pitchError,
+                       result.maxPhase, result.rmsPhase, (long)result.maxBacklog, (unsigned long)result.lostSteps,
+                       (long long)result.droppedCounts, verdict);
+            }
+
+            Uint16 selected = table->getSelectedRow();
+            table->next();
+            if( table->getSelectedRow() == selected ) break;
+        }
+    }
+
+    if( runs == 0 ) {
+        fprintf(stderr, "no such row\n");
+        return 2;
+    }
+    if( options.csv != NULL && runs > 1 ) {
+        fprintf(stderr, "note: --csv holds only the last run\n");
+    }
+    if( options.capture != NULL && runs > 1 ) {
+        fprintf(stderr, "note: --capture holds only the last run\n");
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "SpindleModel.h"
+
+
+SpindleModel :: SpindleModel(double timeConstant, double maxAcceleration)
+{
+    this->timeConstant = timeConstant;
+    this->maxAcceleration = maxAcceleration;
+
+    this->target = 0;
+    this->load = 0;
+
+    this->rpm = 0;
+    this->revolutions = 0;
+}
+
+void SpindleModel :: setTarget(double rpm)
+{
+    this->target = rpm;
+}
+
+void SpindleModel :: setLoad(double fraction)
+{
+    this->load = fraction;
+}
+
+void SpindleModel :: step(double seconds)
+{
+    double held = this->target * (1 - this->load);
+
+    double acceleration = (held - this->rpm) / this->timeConstant;
+    if( acceleration > this->maxAcceleration ) acceleration = this->maxAcceleration;
+    if( acceleration < -this->maxAcceleration ) acceleration = -this->maxAcceleration;
+
+    double next = this->rpm + acceleration * seconds;
+
+    // don't overshoot the target on a large step
+    if( (next - held) * (this->rpm - held) < 0 ) {
+        next = held;
+    }
+
+    this->revolutions += (this->rpm + next) / 2 * seconds / 60;
+    this->rpm = next;
+}
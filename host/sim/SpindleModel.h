@@ -0,0 +1,78 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __SPINDLEMODEL_H
+#define __SPINDLEMODEL_H
+
+
+//
+// Spindle model
+//
+// The spindle chases its target speed like a motor driving a flywheel: the
+// speed closes on the target with the given time constant, but never changes
+// faster than the drive's acceleration limit.  A load takes a fraction off the
+// speed the drive can hold, so applying and removing one gives the dip and
+// recovery of a cut starting and finishing.  Negative speeds turn the spindle
+// backward, and a change of direction goes through zero at the same rates.
+//
+class SpindleModel
+{
+private:
+    double timeConstant;        // seconds
+    double maxAcceleration;     // RPM per second
+
+    double target;              // RPM
+    double load;                // fraction of the target lost to the load
+
+    double rpm;
+    double revolutions;
+
+public:
+    SpindleModel(double timeConstant, double maxAcceleration);
+
+    void setTarget(double rpm);
+    void setLoad(double fraction);
+
+    // advance the model
+    void step(double seconds);
+
+    double getRPM(void);
+    double getRevolutions(void);
+};
+
+
+inline double SpindleModel :: getRPM(void)
+{
+    return this->rpm;
+}
+
+inline double SpindleModel :: getRevolutions(void)
+{
+    return this->revolutions;
+}
+
+
+#endif // __SPINDLEMODEL_H
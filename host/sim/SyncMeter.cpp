@@ -0,0 +1,88 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <math.h>
+
+#include "SyncMeter.h"
+
+
+SyncMeter :: SyncMeter(double ratio)
+{
+    this->ratio = ratio;
+    start(0);
+}
+
+void SyncMeter :: start(double trueCount)
+{
+    this->origin = trueCount;
+
+    this->samples = 0;
+    this->maxPhase = 0;
+    this->sumSquares = 0;
+
+    this->meanX = 0;
+    this->meanY = 0;
+    this->comomentXY = 0;
+    this->comomentXX = 0;
+
+    this->maxBacklog = 0;
+}
+
+void SyncMeter :: add(double trueCount, int32 carriage, int32 backlog)
+{
+    double phase = carriage - getIdeal(trueCount);
+
+    this->samples++;
+    if( fabs(phase) > fabs(this->maxPhase) ) {
+        this->maxPhase = phase;
+    }
+    this->sumSquares += phase * phase;
+
+    // Welford's update, so millions of samples don't lose precision
+    double x = trueCount - this->origin;
+    double dx = x - this->meanX;
+    this->meanX += dx / this->samples;
+    this->meanY += (carriage - this->meanY) / this->samples;
+    this->comomentXY += dx * (carriage - this->meanY);
+    this->comomentXX += dx * (x - this->meanX);
+
+    if( labs(backlog) > labs(this->maxBacklog) ) {
+        this->maxBacklog = backlog;
+    }
+}
+
+double SyncMeter :: getPitchError(void)
+{
+    if( this->comomentXX == 0 || this->ratio == 0 ) {
+        return 0;
+    }
+    return (this->comomentXY / this->comomentXX / this->ratio - 1) * 1e6;
+}
+
+double SyncMeter :: getRmsPhaseError(void)
+{
+    return this->samples ? sqrt(this->sumSquares / this->samples) : 0;
+}
@@ -0,0 +1,98 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __SYNCMETER_H
+#define __SYNCMETER_H
+
+#include "F28x_Project.h"
+
+
+//
+// Sync meter
+//
+// Compares where the carriage is with where the gear ratio says it should be
+// for the true spindle angle, from the point the engine synchronized.
+//
+//   - phase error: carriage position less the ideal position, in steps; what
+//     a thread cut in several passes would see as a shifted flank
+//   - pitch error: the least-squares slope of carriage position over spindle
+//     angle, against the ratio, in parts per million; what a long thread
+//     would see as a wrong lead
+//   - backlog: steps the engine asked for that the drive hasn't made yet
+//
+class SyncMeter
+{
+private:
+    double ratio;               // steps per encoder count, signed
+    double origin;              // spindle angle at sync, in counts
+
+    Uint64 samples;
+    double maxPhase;
+    double sumSquares;
+
+    // running means and co-moments for the slope
+    double meanX;
+    double meanY;
+    double comomentXY;
+    double comomentXX;
+
+    int32 maxBacklog;
+
+public:
+    SyncMeter(double ratio);
+
+    // the carriage is at zero with the spindle at this angle
+    void start(double trueCount);
+
+    void add(double trueCount, int32 carriage, int32 backlog);
+
+    // ideal carriage position for a spindle angle, in steps
+    double getIdeal(double trueCount);
+
+    double getPitchError(void);
+    double getMaxPhaseError(void);
+    double getRmsPhaseError(void);
+    int32 getMaxBacklog(void);
+};
+
+
+inline double SyncMeter :: getIdeal(double trueCount)
+{
+    return (trueCount - this->origin) * this->ratio;
+}
+
+inline double SyncMeter :: getMaxPhaseError(void)
+{
+    return this->maxPhase;
+}
+
+inline int32 SyncMeter :: getMaxBacklog(void)
+{
+    return this->maxBacklog;
+}
+
+
+#endif // __SYNCMETER_H
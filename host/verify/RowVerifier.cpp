@@ -0,0 +1,156 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <math.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+#include "Registers.h"
+#include "Configuration.h"
+
+// pick the math for this copy of Core; nothing else depends on it
+#if VERIFY_FLOATING_POINT
+#ifndef USE_FLOATING_POINT
+#define USE_FLOATING_POINT
+#endif
+#define VERIFY_NAMESPACE FloatMath
+#else
+#undef USE_FLOATING_POINT
+#define VERIFY_NAMESPACE IntegerMath
+#endif
+
+#include "StepperDrive.h"
+#include "Encoder.h"
+#include "Tables.h"
+#include "RowVerifier.h"
+
+namespace VERIFY_NAMESPACE
+{
+
+#include "Core.h"
+#include "Core.cpp"
+
+
+// engine's position less the exact one for a spindle travel, in steps.  The
+// carriage position is 32 bits in the firmware and rolls over on a long run,
+// so the difference is taken the same way.
+static double stepError(const FEED_THREAD *row, int64 travel, int32 carriage)
+{
+    __int128 product = (__int128)travel * row->numerator;
+    __int128 whole = product / row->denominator;
+    __int128 fraction = product - whole * row->denominator;
+
+    int32 difference = (int32)(Uint32)((Uint32)carriage - (Uint32)whole);
+    return (double)difference - (double)fraction / row->denominator;
+}
+
+void verifyRow(const FEED_THREAD *row, const VERIFY_OPTIONS *options, VERIFY_RESULT *result)
+{
+    memset((void *)&GpioDataRegs, 0, sizeof(GpioDataRegs));
+    memset((void *)&ENCODER_REGS, 0, sizeof(ENCODER_REGS));
+
+    Encoder encoder;
+    StepperDrive stepperDrive;
+    Core core(&encoder, &stepperDrive);
+
+    std::mt19937 random(options->seed);
+    const Uint32 range = _ENCODER_MAX_COUNT + 1;
+
+    // strides average out to the requested travel, and stay well inside the
+    // half count the ISR uses to tell a wrap from a move
+    double counts = options->revolutions * ENCODER_RESOLUTION;
+    Uint32 mean = (Uint32)(counts / options->ticks);
+    if( mean < 1 ) mean = 1;
+    if( mean > range / 8 ) mean = range / 8;
+    std::uniform_int_distribution<Uint32> stride(1, 2 * mean - 1);
+
+    // start anywhere in the count
+    Uint32 position = random() % range;
+    int64 travel = 0;
+
+    core.setFeed(row);
+    core.setReverse(false);
+    core.publish();
+    core.setPowerOn(true);
+    ENCODER_REGS.QPOSCNT = position;
+    core.ISR();
+
+    result->worstError = 0;
+    result->wraps = 0;
+
+    // least-squares trend of the error against spindle travel on the way out;
+    // a correct engine's error is bounded, so the trend across the run is
+    // only noise, where a lost fraction per wrap shows up as a steady slope
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+
+    std::vector<Uint32> strides(options->ticks);
+    for( Uint32 i = 0; i < options->ticks; i++ ) {
+        strides[i] = stride(random);
+    }
+
+    // out, then all the way back over the same strides in reverse
+    for( Uint16 leg = 0; leg < 2; leg++ ) {
+        for( Uint32 i = 0; i < options->ticks; i++ ) {
+            int32 move = (leg == 0) ? (int32)strides[i] : -(int32)strides[options->ticks - 1 - i];
+
+            Uint32 next = (Uint32)(((int64)position + move) % range + range) % range;
+            if( (move > 0 && next < position) || (move < 0 && next > position) ) {
+                if( leg == 0 ) result->wraps++;
+            }
+            position = next;
+            travel += move;
+
+            ENCODER_REGS.QPOSCNT = position;
+            core.ISR();
+
+            // where the engine wants the carriage, whether or not the drive
+            // has got there yet; both wrap the same way on a long run
+            int32 carriage = stepperDrive.getCarriagePosition() + stepperDrive.getBacklog();
+            double error = stepError(row, travel, carriage);
+
+            if( fabs(error) > fabs(result->worstError) ) {
+                result->worstError = error;
+            }
+            if( leg == 0 ) {
+                double x = (double)travel;
+                sumX += x;
+                sumY += error;
+                sumXX += x * x;
+                sumXY += x * error;
+            }
+            if( leg == 1 && i == options->ticks - 1 ) {
+                result->returnError = error;
+            }
+        }
+    }
+
+    double n = options->ticks;
+    double slope = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+    result->drift = slope * options->revolutions * ENCODER_RESOLUTION;
+}
+
+}
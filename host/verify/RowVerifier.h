@@ -0,0 +1,73 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __ROWVERIFIER_H
+#define __ROWVERIFIER_H
+
+#include "F28x_Project.h"
+#include "Tables.h"
+
+
+typedef struct VERIFY_OPTIONS
+{
+    double revolutions;         // spindle travel out, and back again
+    Uint32 ticks;               // ISR calls each way
+    Uint32 seed;
+} VERIFY_OPTIONS;
+
+typedef struct VERIFY_RESULT
+{
+    double worstError;          // steps, largest on either leg
+    double drift;               // steps, trend of the error across the run
+    double returnError;         // steps, error back at the start
+    Uint32 wraps;               // encoder count wraps each way
+} VERIFY_RESULT;
+
+
+//
+// Row verifier
+//
+// Runs one table row through the real Core::ISR(), built with floating-point
+// or with integer math, moving the encoder count in random strides large
+// enough to cover millions of revolutions in a few hundred thousand calls.
+// After every call it compares the carriage position the engine is asking
+// for with the exact table fraction times the spindle travel.
+//
+// The same source is compiled once for each math setting, with Core in its
+// own namespace each time.
+//
+namespace FloatMath
+{
+    void verifyRow(const FEED_THREAD *row, const VERIFY_OPTIONS *options, VERIFY_RESULT *result);
+}
+
+namespace IntegerMath
+{
+    void verifyRow(const FEED_THREAD *row, const VERIFY_OPTIONS *options, VERIFY_RESULT *result);
+}
+
+
+#endif // __ROWVERIFIER_H
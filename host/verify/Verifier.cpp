@@ -0,0 +1,164 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+//
+// Pitch accuracy verifier
+//
+// Runs every row of the built-in feed and thread tables through Core with
+// both floating-point and integer math, over millions of spindle revolutions
+// and thousands of encoder count wraps, and reports per row:
+//
+//   worst    largest difference between the carriage position the engine
+//            asks for and the exact table fraction, in steps
+//   drift    trend of the error from one end of the run to the other; a
+//            fraction lost at each wrap shows up here, and means long
+//            threads come out the wrong pitch
+//   return   error back at the starting spindle position
+//
+// The engine truncates both the position within an encoder wrap and the
+// fraction of a step carried across wraps, so its error should stay within
+// two steps.  With floating-point math the position within a wrap is also
+// rounded to float's 24 bits, which on coarse pitches is worth a step or two
+// more, so each row gets that much extra allowance on the float side.
+//
+// Exits non-zero if any row goes past the limits, so a table or engine change
+// can be checked before it reaches a machine.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Registers.h"
+#include "Encoder.h"
+#include "RowVerifier.h"
+
+
+static const char *TABLE_NAMES[] = { "inch-thread", "inch-feed", "metric-thread", "metric-feed" };
+
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: verifier [options]\n"
+            "  --revolutions N      spindle revolutions each way (default 2000000)\n"
+            "  --ticks N            ISR calls each way (default 100000)\n"
+            "  --max-error S        worst error allowed, steps (default 2.1, more with\n"
+            "                       floating-point math on coarse pitches)\n"
+            "  --max-drift S        drift allowed, steps (default 0.5)\n"
+            "  --seed N             random seed (default 1)\n");
+    exit(2);
+}
+
+// float rounding of the ratio and of the largest position within a wrap
+static double floatAllowance(const FEED_THREAD *row)
+{
+    double largest = ((double)_ENCODER_MAX_COUNT + 1) * row->numerator / row->denominator;
+    return ldexp(largest, -23);
+}
+
+static bool check(const VERIFY_RESULT *result, double maxError, double maxDrift)
+{
+    return fabs(result->worstError) <= maxError && fabs(result->drift) <= maxDrift &&
+            fabs(result->returnError) <= maxError;
+}
+
+int main(int argc, char **argv)
+{
+    VERIFY_OPTIONS options;
+    options.revolutions = 2000000;
+    options.ticks = 100000;
+    options.seed = 1;
+    double maxError = 2.1;
+    double maxDrift = 0.5;
+
+    for( int i = 1; i < argc; i++ ) {
+        if( i + 1 >= argc ) usage();
+        const char *name = argv[i];
+        const char *value = argv[++i];
+
+        if( strcmp(name, "--revolutions") == 0 ) options.revolutions = atof(value);
+        else if( strcmp(name, "--ticks") == 0 ) options.ticks = strtoul(value, NULL, 0);
+        else if( strcmp(name, "--max-error") == 0 ) maxError = atof(value);
+        else if( strcmp(name, "--max-drift") == 0 ) maxDrift = atof(value);
+        else if( strcmp(name, "--seed") == 0 ) options.seed = strtoul(value, NULL, 0);
+        else usage();
+    }
+    if( options.revolutions <= 0 || options.ticks < 2 ) usage();
+
+    EEPROM eeprom(NULL);
+    FeedTableFactory feedTableFactory(&eeprom);
+    int failures = 0;
+    int rows = 0;
+    double worstFloat = 0, worstInteger = 0, driftFloat = 0, driftInteger = 0;
+
+    printf("%-13s %-6s %6s | %8s %8s %8s | %8s %8s %8s\n", "", "", "",
+           "float", "", "", "integer", "", "");
+    printf("%-13s %-6s %6s | %8s %8s %8s | %8s %8s %8s\n", "table", "row", "wraps",
+           "worst", "drift", "return", "worst", "drift", "return");
+
+    for( int t = 0; t < 4; t++ ) {
+        FeedTable *table = feedTableFactory.getFeedTable(t >= 2, (t % 2) == 0);
+
+        table->setSelectedRow(0);
+        for( ;; ) {
+            const FEED_THREAD *row = table->current();
+            VERIFY_RESULT floatResult, integerResult;
+
+            FloatMath::verifyRow(row, &options, &floatResult);
+            IntegerMath::verifyRow(row, &options, &integerResult);
+            rows++;
+
+            bool pass = check(&floatResult, maxError + floatAllowance(row), maxDrift) &&
+                    check(&integerResult, maxError, maxDrift);
+            if( ! pass ) failures++;
+
+            printf("%-13s %-6s %6lu | %8.3f %8.3f %8.3f | %8.3f %8.3f %8.3f%s\n", TABLE_NAMES[t], row->label,
+                   (unsigned long)floatResult.wraps,
+                   floatResult.worstError, floatResult.drift, floatResult.returnError,
+                   integerResult.worstError, integerResult.drift, integerResult.returnError,
+                   pass ? "" : "  FAIL");
+
+            if( fabs(floatResult.worstError) > fabs(worstFloat) ) worstFloat = floatResult.worstError;
+            if( fabs(integerResult.worstError) > fabs(worstInteger) ) worstInteger = integerResult.worstError;
+            if( fabs(floatResult.drift) > fabs(driftFloat) ) driftFloat = floatResult.drift;
+            if( fabs(integerResult.drift) > fabs(driftInteger) ) driftInteger = integerResult.drift;
+
+            Uint16 selected = table->getSelectedRow();
+            table->next();
+            if( table->getSelectedRow() == selected ) break;
+        }
+    }
+
+    printf("\n%d rows, %.0f revolutions each way: worst %.3f/%.3f steps, drift %.3f/%.3f steps (float/integer)\n",
+           rows, options.revolutions, worstFloat, worstInteger, driftFloat, driftInteger);
+    if( failures ) {
+        printf("%d rows out of limits\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -81,6 +81,12 @@
 //================================================================================
 #define ENCODER_RESOLUTION 4096
 
+// Which encoder input to use
+// The fixture uses the EQEP1 pins for step feedback and the alarm stimulus, so
+// the encoder loopback runs on EQEP2
+//#define ENCODER_USE_EQEP1
+#define ENCODER_USE_EQEP2
+
 
 
 
@@ -132,4 +138,46 @@
 #define CPU_CLOCK_HZ (CPU_CLOCK_MHZ * 1000000)
 
 
+
+
+//================================================================================
+//                              STEP RATE TEST
+//
+// Define the limits for the dynamic step test.  The stepper state machine is run
+// at a series of increasing rates and the pulses are counted on the step
+// feedback pin.  A rate is sustained if every step is counted and the drive
+// never falls more than MAX_BUFFERED_STEPS behind, which is the point at which
+// the ELS firmware gives up on a move.
+//================================================================================
+
+// Maximum steps the ELS allows the drive to fall behind (match the ELS setting)
+#define MAX_BUFFERED_STEPS 100
+
+// Lowest sustained step rate that passes, in Hertz
+#define STEP_TEST_MIN_RATE_HZ 50000
+
+// Narrowest step pulse that passes, in nanoseconds
+#define STEP_TEST_MIN_PULSE_NS 2500
+
+
+
+
+//================================================================================
+//                               ENCODER TEST
+//
+// Define the limits for the encoder loopback test.  Quadrature is generated on
+// EPWM3 and jumpered back into the encoder inputs:
+//
+//  GPIO4 (EPWM3A) -> GPIO14 (EQEP2A)
+//  GPIO5 (EPWM3B) -> GPIO15 (EQEP2B)
+//  GPIO8 (index)  -> GPIO26 (EQEP2I)
+//
+// The count rate is swept from a quarter of the maximum spindle speed upward
+// until the inputs can no longer follow.
+//================================================================================
+
+// Fastest spindle speed the encoder must follow, in RPM
+#define ENCODER_TEST_MAX_RPM 4000
+
+
 #endif // __CONFIGURATION_H
@@ -56,6 +56,18 @@
 #error ENCODER_RESOLUTION must be between 100 and 10000
 #endif
 
+#if defined(ENCODER_USE_EQEP1) && defined (ENCODER_USE_EQEP2)
+#error Define only one of ENCODER_USE_EQEP1 or ENCODER_USE_EQEP2
+#endif
+
+#if defined(ENCODER_USE_EQEP1)
+#error The fixture uses the EQEP1 pins for step feedback; use ENCODER_USE_EQEP2
+#endif
+
+#if ENCODER_TEST_MAX_RPM < 100 || ENCODER_TEST_MAX_RPM > 10000
+#error ENCODER_TEST_MAX_RPM must be between 100 and 10000
+#endif
+
 #if defined(LEADSCREW_TPI) && defined(LEADSCREW_HMM)
 #error LEADSCREW_TPI and LEADSCREW_HMM may not both be defined.  Choose only one.
 #endif
@@ -72,6 +84,18 @@
 #endif
 #endif
 
+#if MAX_BUFFERED_STEPS < 1 || MAX_BUFFERED_STEPS > 10000
+#error MAX_BUFFERED_STEPS must be between 1 and 10000
+#endif
+
+#if STEP_TEST_MIN_RATE_HZ < 1000 || STEP_TEST_MIN_RATE_HZ > 1000000/(2*STEPPER_CYCLE_US)
+#error STEP_TEST_MIN_RATE_HZ must be between 1kHz and the stepper state machine maximum
+#endif
+
+#if STEP_TEST_MIN_PULSE_NS < 0 || STEP_TEST_MIN_PULSE_NS > STEPPER_CYCLE_US*1000
+#error STEP_TEST_MIN_PULSE_NS must be between 0 and STEPPER_CYCLE_US
+#endif
+
 
 
 #endif // __SANITYCHECK_H
@@ -98,6 +98,7 @@ public:
     void setDesiredPosition(int32 steps);
     void incrementCurrentPosition(int32 increment);
     void setCurrentPosition(int32 position);
+    int32 getCurrentPosition(void);
 
     bool isAlarm();
 
@@ -119,6 +120,11 @@ inline void StepperDrive :: setCurrentPosition(int32 position)
     this->currentPosition = position;
 }
 
+inline int32 StepperDrive :: getCurrentPosition(void)
+{
+    return this->currentPosition;
+}
+
 inline bool StepperDrive :: isAlarm()
 {
 #ifdef USE_ALARM_PIN
@@ -0,0 +1,326 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TestEncoder.h"
+
+#define INDEX_FEEDBACK GpioDataRegs.GPADAT.bit.GPIO26
+#define A_FEEDBACK GpioDataRegs.GPADAT.bit.GPIO14
+#define B_FEEDBACK GpioDataRegs.GPADAT.bit.GPIO15
+
+#define GPIO_SET_INDEX GpioDataRegs.GPASET.bit.GPIO8 = 1
+#define GPIO_CLEAR_INDEX GpioDataRegs.GPACLEAR.bit.GPIO8 = 1
+
+// one-time software force actions for the generator outputs
+#define FORCE_LOW 1
+#define FORCE_HIGH 2
+
+// action qualifier settings for the leading and lagging outputs
+// the leading output is high for the up-count and low for the down-count;
+// the lagging output is the same, a quarter cycle later
+#define LEADING_ACTIONS 0x0006      // ZRO = set, PRD = clear
+#define LAGGING_ACTIONS_A 0x0060    // CAU = set, CAD = clear
+#define LAGGING_ACTIONS_B 0x0600    // CBU = set, CBD = clear
+
+// generator period limits, in TBCLK cycles; the up-down count gives two
+// periods per quadrature cycle, so four edges every two periods
+#define ENCODER_TEST_MIN_PERIOD 4
+#define ENCODER_TEST_MAX_PERIOD 65534
+
+// tolerance on getRPM(): one count either way at the window edges
+#define ENCODER_TEST_RPM_TOLERANCE (60 * RPM_CALC_RATE_HZ / ENCODER_RESOLUTION + 1)
+
+// one stage of the sweep
+typedef struct ENCODER_TEST_STAGE
+{
+    // count rate, in quarters of the maximum spindle speed
+    Uint16 quarters;
+
+    // count down rather than up
+    bool reverse;
+} ENCODER_TEST_STAGE;
+
+const ENCODER_TEST_STAGE ENCODER_TEST_STAGES[ENCODER_TEST_NUM_RATES] = {
+        { 4, true },        // full speed in reverse, through the counter wrap
+        { 1, false },
+        { 2, false },
+        { 4, false },       // full speed
+        { 8, false },
+        { 16, false },
+        { 32, false },
+        { 64, false },
+        { 128, false },
+        { 256, false },
+        { 512, false },
+        { 1024, false }
+};
+
+
+TestEncoder :: TestEncoder( Encoder *encoder )
+{
+    this->encoder = encoder;
+
+    this->stage = 0;
+    this->running = false;
+    this->timeouts = 0;
+    this->period = ENCODER_TEST_MAX_PERIOD;
+    this->reverse = false;
+    this->startTime = 0;
+    this->startPosition = 0;
+
+    this->pinsPass = false;
+    this->countsPass = false;
+    this->rpmPass = false;
+    this->reversePass = false;
+    this->maxSustainedRate = 0;
+    this->maxSustainedRpm = 0;
+}
+
+void TestEncoder :: initHardware(void)
+{
+    EALLOW;
+    GpioCtrlRegs.GPAMUX1.bit.GPIO4 = 1;     // Configure GPIO4 as EPWM3A
+    GpioCtrlRegs.GPAMUX1.bit.GPIO5 = 1;     // Configure GPIO5 as EPWM3B
+    GpioCtrlRegs.GPAMUX1.bit.GPIO8 = 0;     // index is driven as a plain output
+
+    GpioCtrlRegs.GPADIR.bit.GPIO8 = 1;
+    GPIO_CLEAR_INDEX;
+    EDIS;
+
+    EPwm3Regs.TBCTL.bit.CTRMODE = 3;        // frozen until a stage starts
+    EPwm3Regs.TBCTL.bit.PHSEN = 0;          // no phase loading
+    EPwm3Regs.TBCTL.bit.PRDLD = 1;          // load the period immediately
+    EPwm3Regs.TBCTL.bit.HSPCLKDIV = 0;      // TBCLK = EPWMCLK
+    EPwm3Regs.TBCTL.bit.CLKDIV = 0;
+    EPwm3Regs.TBCTL.bit.FREE_SOFT = 2;      // unaffected by emulation suspend
+    EPwm3Regs.CMPCTL.bit.SHDWAMODE = 1;     // load the compares immediately
+    EPwm3Regs.CMPCTL.bit.SHDWBMODE = 1;
+    EPwm3Regs.AQSFRC.bit.RLDCSF = 3;        // load software forces immediately
+
+    CpuTimer1Regs.TCR.bit.TSS = 0;          // free-running reference for timing stages
+}
+
+void TestEncoder :: test(LED_REG *output)
+{
+    if( this->running ) {
+        // getRPM() clears the timeout, so look first
+        bool timeout = ENCODER_REGS.QFLG.bit.UTO;
+        Uint16 rpm = this->encoder->getRPM();
+
+        // the second window lies wholly within the stage
+        if( timeout && ++this->timeouts >= 2 ) {
+            this->results[this->stage].rpm = rpm;
+            finishStage();
+        }
+    }
+
+    // the pin checks drive the outputs directly, so they run between stages
+    if( ! this->running ) {
+        this->pinsPass = testPins();
+        startStage();
+    }
+
+    output->bit.A = this->pinsPass;
+    output->bit.B = this->countsPass;
+    output->bit.C = this->rpmPass;
+    output->bit.D = this->reversePass;
+}
+
+bool TestEncoder :: testPins(void)
+{
+    bool pass = true;
+
+    // the encoder inputs may be buffered and inverted, so only check that
+    // each one follows its output
+    EPwm3Regs.AQSFRC.bit.ACTSFA = FORCE_HIGH;
+    EPwm3Regs.AQSFRC.bit.OTSFA = 1;
+    DELAY_US(100);
+    bool high = A_FEEDBACK;
+    EPwm3Regs.AQSFRC.bit.ACTSFA = FORCE_LOW;
+    EPwm3Regs.AQSFRC.bit.OTSFA = 1;
+    DELAY_US(100);
+    pass = pass && high != A_FEEDBACK;
+
+    EPwm3Regs.AQSFRC.bit.ACTSFB = FORCE_HIGH;
+    EPwm3Regs.AQSFRC.bit.OTSFB = 1;
+    DELAY_US(100);
+    high = B_FEEDBACK;
+    EPwm3Regs.AQSFRC.bit.ACTSFB = FORCE_LOW;
+    EPwm3Regs.AQSFRC.bit.OTSFB = 1;
+    DELAY_US(100);
+    pass = pass && high != B_FEEDBACK;
+
+    GPIO_SET_INDEX;
+    DELAY_US(100);
+    high = INDEX_FEEDBACK;
+    GPIO_CLEAR_INDEX;
+    DELAY_US(100);
+    pass = pass && high != INDEX_FEEDBACK;
+
+    return pass;
+}
+
+void TestEncoder :: startStage(void)
+{
+    const ENCODER_TEST_STAGE *settings = &ENCODER_TEST_STAGES[this->stage];
+
+    Uint32 rate = ENCODER_TEST_MAX_RATE * settings->quarters / 4;
+    Uint32 period = 2 * (Uint32)CPU_CLOCK_HZ / rate;
+    if( period > ENCODER_TEST_MAX_PERIOD ) period = ENCODER_TEST_MAX_PERIOD;
+    if( period < ENCODER_TEST_MIN_PERIOD ) period = ENCODER_TEST_MIN_PERIOD;
+    this->period = period & ~1;
+    this->reverse = settings->reverse;
+
+    // start with the leading output high, as if the counter had just passed
+    // zero, so the first edge is the same whether or not the zero event fires.
+    // One output at a time, so the eQEP never sees both change together.
+    EPwm3Regs.AQSFRC.bit.ACTSFA = this->reverse ? FORCE_LOW : FORCE_HIGH;
+    EPwm3Regs.AQSFRC.bit.OTSFA = 1;
+    DELAY_US(1);
+    EPwm3Regs.AQSFRC.bit.ACTSFB = this->reverse ? FORCE_HIGH : FORCE_LOW;
+    EPwm3Regs.AQSFRC.bit.OTSFB = 1;
+    DELAY_US(1);
+
+    EPwm3Regs.TBCTR = 0;
+    EPwm3Regs.TBPRD = this->period;
+    EPwm3Regs.CMPA.bit.CMPA = this->period / 2;
+    EPwm3Regs.CMPB.bit.CMPB = this->period / 2;
+    EPwm3Regs.AQCTLA.all = this->reverse ? LAGGING_ACTIONS_A : LEADING_ACTIONS;
+    EPwm3Regs.AQCTLB.all = this->reverse ? LEADING_ACTIONS : LAGGING_ACTIONS_B;
+
+    EALLOW;
+    CpuSysRegs.PCLKCR0.bit.TBCLKSYNC = 0;
+    EDIS;
+    EPwm3Regs.TBCTL.bit.CTRMODE = 2;        // up-down count
+
+    // run the reverse stage down through zero, to exercise the wrap
+    if( this->reverse ) {
+        ENCODER_REGS.QPOSCNT = 0;
+    }
+    this->startPosition = this->encoder->getPosition();
+    ENCODER_REGS.QCLR.bit.PHE = 1;
+    this->timeouts = 0;
+
+    DINT;
+    this->startTime = CpuTimer1Regs.TIM.all;
+    EALLOW;
+    CpuSysRegs.PCLKCR0.bit.TBCLKSYNC = 1;
+    EDIS;
+    EINT;
+
+    // discard any unit timeout from before the start
+    this->encoder->getRPM();
+
+    this->running = true;
+}
+
+void TestEncoder :: finishStage(void)
+{
+    // stop the generator; the start took the same path, so the delay
+    // between reading the timer and stopping the clock cancels out
+    DINT;
+    Uint32 elapsed = this->startTime - CpuTimer1Regs.TIM.all;
+    EALLOW;
+    CpuSysRegs.PCLKCR0.bit.TBCLKSYNC = 0;
+    EDIS;
+    EINT;
+
+    // let the last edge through the input qualification
+    DELAY_US(10);
+
+    // where the generator stopped within its cycle gives the exact edge
+    // count; the timer only has to be good to within a period
+    Uint32 cycle = 2 * (Uint32)this->period;
+    Uint32 count = EPwm3Regs.TBCTR;
+    Uint32 phase = EPwm3Regs.TBSTS.bit.CTRDIR ? count : cycle - count;
+    Uint32 cycles = (elapsed + this->period - phase) / cycle;
+    int32 expected = cycles * 4 + phase / (this->period / 2);
+
+    Uint32 delta = (this->encoder->getPosition() - this->startPosition) & _ENCODER_MAX_COUNT;
+    int32 counted = (delta > _ENCODER_MAX_COUNT / 2) ? (int32)delta - (int32)(_ENCODER_MAX_COUNT + 1) : (int32)delta;
+
+    // leave the counter frozen with its clock running, so the outputs can be forced
+    EPwm3Regs.TBCTL.bit.CTRMODE = 3;
+    EALLOW;
+    CpuSysRegs.PCLKCR0.bit.TBCLKSYNC = 1;
+    EDIS;
+
+    // counts in one RPM window, as getRPM() sees them
+    Uint32 windowCounts = 2 * ((Uint32)CPU_CLOCK_HZ / RPM_CALC_RATE_HZ) / this->period;
+    Uint32 expectedRpm = windowCounts * 60 * RPM_CALC_RATE_HZ / ENCODER_RESOLUTION;
+
+    ENCODER_RATE_RESULT *result = &this->results[this->stage];
+    result->rate = 2 * (Uint32)CPU_CLOCK_HZ / this->period;
+    result->expected = this->reverse ? -expected : expected;
+    result->counted = counted;
+    result->phaseError = ENCODER_REGS.QFLG.bit.PHE;
+    result->rpmChecked = expectedRpm <= 0xffff;
+    result->expectedRpm = result->rpmChecked ? expectedRpm : 0xffff;
+    result->countsMatch = ! result->phaseError
+            && result->counted - result->expected <= 1
+            && result->expected - result->counted <= 1;
+    result->rpmMatch = ! result->rpmChecked
+            || ((Uint32)result->rpm <= (Uint32)result->expectedRpm + ENCODER_TEST_RPM_TOLERANCE
+                && (Uint32)result->rpm + ENCODER_TEST_RPM_TOLERANCE >= result->expectedRpm);
+
+    this->running = false;
+
+    if( ++this->stage >= ENCODER_TEST_NUM_RATES ) {
+        this->stage = 0;
+        finishSweep();
+    }
+}
+
+void TestEncoder :: finishSweep(void)
+{
+    this->countsPass = true;
+    this->rpmPass = true;
+    this->reversePass = true;
+    this->maxSustainedRate = 0;
+    bool failed = false;
+
+    for( Uint16 i = 0; i < ENCODER_TEST_NUM_RATES; i++ ) {
+        ENCODER_RATE_RESULT *result = &this->results[i];
+        bool sustained = result->countsMatch && result->rpmMatch;
+
+        if( ENCODER_TEST_STAGES[i].reverse ) {
+            this->reversePass = this->reversePass && sustained;
+            continue;
+        }
+
+        // everything up to the maximum spindle speed must work
+        if( ENCODER_TEST_STAGES[i].quarters <= 4 ) {
+            this->countsPass = this->countsPass && result->countsMatch;
+            this->rpmPass = this->rpmPass && result->rpmMatch;
+        }
+
+        // the sustained rate is the last one before the first failure
+        failed = failed || ! sustained;
+        if( ! failed ) {
+            this->maxSustainedRate = result->rate;
+        }
+    }
+
+    this->maxSustainedRpm = this->maxSustainedRate * 60 / ENCODER_RESOLUTION;
+}
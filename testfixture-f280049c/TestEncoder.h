@@ -0,0 +1,110 @@
+// Clough42 Electronic Leadscrew
+// https://github.com/clough42/electronic-leadscrew
+//
+// MIT License
+//
+// Copyright (c) 2019 James Clough
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef __TEST_ENCODER_H
+#define __TEST_ENCODER_H
+
+#include "F28x_Project.h"
+#include "ControlPanel.h"
+#include "Encoder.h"
+
+// number of stages in the count rate sweep
+#define ENCODER_TEST_NUM_RATES 12
+
+// count rate at the maximum spindle speed, in counts per second
+#define ENCODER_TEST_MAX_RATE ((Uint32)ENCODER_TEST_MAX_RPM * ENCODER_RESOLUTION / 60)
+
+
+// Result of generating quadrature at one count rate
+typedef struct ENCODER_RATE_RESULT
+{
+    // generated count rate, in counts per second
+    Uint32 rate;
+
+    // edges generated and the change in Encoder::getPosition()
+    int32 expected;
+    int32 counted;
+
+    // RPM expected and reported by Encoder::getRPM()
+    Uint16 expectedRpm;
+    Uint16 rpm;
+
+    // the RPM fits in getRPM()'s range and was compared
+    bool rpmChecked;
+
+    // the eQEP saw A and B change together
+    bool phaseError;
+
+    // the position and RPM matched what was generated
+    bool countsMatch;
+    bool rpmMatch;
+} ENCODER_RATE_RESULT;
+
+
+class TestEncoder
+{
+private:
+    Encoder *encoder;
+
+    //
+    // Current stage
+    //
+    Uint16 stage;
+    bool running;
+    Uint16 timeouts;
+    Uint16 period;
+    bool reverse;
+    Uint32 startTime;
+    Uint32 startPosition;
+
+    //
+    // Sweep results, for inspection in the debugger
+    //
+    bool pinsPass;
+    bool countsPass;
+    bool rpmPass;
+    bool reversePass;
+    ENCODER_RATE_RESULT results[ENCODER_TEST_NUM_RATES];
+    Uint32 maxSustainedRate;
+    Uint32 maxSustainedRpm;
+
+    bool testPins(void);
+    void startStage(void);
+    void finishStage(void);
+    void finishSweep(void);
+
+public:
+    TestEncoder(Encoder *encoder);
+
+    // initialize the hardware for operation
+    void initHardware(void);
+
+    // execute test
+    void test(LED_REG *output);
+};
+
+
+#endif // __TEST_ENCODER_H
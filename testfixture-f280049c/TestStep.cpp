@@ -29,15 +29,42 @@
 #define DIRECTION_FEEDBACK GpioDataRegs.GPBDAT.bit.GPIO40;
 #define ENABLE_FEEDBACK GpioDataRegs.GPBDAT.bit.GPIO56;
 
+// step rates for the dynamic sweep, in Hertz
+// the last one is beyond the state machine's limit and should never sustain
+const Uint32 STEP_TEST_RATES[STEP_TEST_NUM_RATES] = {
+        5000, 10000, 20000, 30000, 40000, 50000, 60000, 80000, 100000, 125000
+};
+
+// longest the drive is given to catch up at the end of a stage, in 100us units
+#define STEP_TEST_DRAIN_TIMEOUT 1000
+
 TestStep :: TestStep( StepperDrive *stepperDrive )
 {
     this->stepperDrive = stepperDrive;
+
+    this->running = false;
+    this->draining = false;
+    this->rate = 0;
+    this->phase = 0;
+    this->desiredPosition = 0;
+    this->startPosition = 0;
+    this->startCount = 0;
+    this->ticks = 0;
+    this->maxBacklog = 0;
+    this->minPulseCycles = 0xffffffff;
+
+    this->stage = 0;
+    this->sweepPass = false;
+    this->maxSustainedRate = 0;
+    this->minPulseNs = 0;
+    this->missedSteps = 0;
 }
 
 void TestStep :: initHardware(void)
 {
     EALLOW;
-    GpioCtrlRegs.GPBMUX1.bit.GPIO37 = 0;
+    GpioCtrlRegs.GPBMUX1.bit.GPIO37 = 1;    // Configure GPIO37 as EQEP1B to count steps
+    GpioCtrlRegs.GPBGMUX1.bit.GPIO37 = 2;
     GpioCtrlRegs.GPBMUX1.bit.GPIO40 = 0;
     GpioCtrlRegs.GPBMUX2.bit.GPIO56 = 0;
 
@@ -45,10 +72,51 @@ void TestStep :: initHardware(void)
     GpioCtrlRegs.GPBDIR.bit.GPIO40 = 0;
     GpioCtrlRegs.GPBDIR.bit.GPIO56 = 0;
 
+    InputXbarRegs.INPUT7SELECT = 37;        // Route GPIO37 to ECAP1 to time steps
     EDIS;
+
+    EQep1Regs.QDECCTL.bit.QSRC = 2;         // up-count mode, clock from the B input
+    EQep1Regs.QDECCTL.bit.SWAP = 1;         // swap so the clock is taken from EQEP1B
+    EQep1Regs.QDECCTL.bit.XCR = 1;          // count rising edges only
+    EQep1Regs.QEPCTL.bit.FREE_SOFT = 2;     // unaffected by emulation suspend
+    EQep1Regs.QEPCTL.bit.PCRM = 1;          // position count reset on maximum position
+    EQep1Regs.QPOSMAX = 0xffffffff;         // count through the full range
+    EQep1Regs.QEPCTL.bit.QPEN = 1;          // QEP enable
+
+    ECap1Regs.ECCTL0.bit.INPUTSEL = 6;      // capture from INPUTXBAR7
+#ifdef INVERT_STEP_PIN
+    ECap1Regs.ECCTL1.bit.CAP1POL = 1;       // leading edge of the step is falling
+    ECap1Regs.ECCTL1.bit.CAP2POL = 0;       // trailing edge is rising
+#else
+    ECap1Regs.ECCTL1.bit.CAP1POL = 0;       // leading edge of the step is rising
+    ECap1Regs.ECCTL1.bit.CAP2POL = 1;       // trailing edge is falling
+#endif
+    ECap1Regs.ECCTL1.bit.CTRRST1 = 1;       // reset the counter on the leading edge
+    ECap1Regs.ECCTL1.bit.CTRRST2 = 0;       // so CAP2 holds the pulse width
+    ECap1Regs.ECCTL1.bit.CAPLDEN = 1;       // load the capture registers
+    ECap1Regs.ECCTL1.bit.PRESCALE = 0;      // no prescale
+    ECap1Regs.ECCTL1.bit.FREE_SOFT = 2;     // unaffected by emulation suspend
+    ECap1Regs.ECCTL2.bit.CAP_APWM = 0;      // capture mode
+    ECap1Regs.ECCTL2.bit.CONT_ONESHT = 0;   // continuous
+    ECap1Regs.ECCTL2.bit.STOP_WRAP = 1;     // wrap after the second event
+    ECap1Regs.ECCTL2.bit.TSCTRSTOP = 1;     // start the counter
 }
 
 void TestStep :: test(LED_REG *output)
+{
+    // the static checks drive the pins directly, so the dynamic test
+    // runs between calls, one rate per call
+    finishStage();
+
+    bool pass = testStatic();
+
+    startStage();
+
+    output->bit.STEP_GREEN = pass && this->sweepPass;
+    output->bit.STEP_RED = !(pass && this->sweepPass);
+}
+
+bool TestStep :: testStatic(void)
 {
     bool pass = true;
 
@@ -97,6 +165,80 @@ void TestStep :: test(LED_REG *output)
     pass = pass && ! DIRECTION_FEEDBACK;
     pass = pass && ! ENABLE_FEEDBACK;
 
-    output->bit.STEP_GREEN = pass;
-    output->bit.STEP_RED = !pass;
+    return pass;
+}
+
+void TestStep :: startStage(void)
+{
+    this->rate = STEP_TEST_RATES[this->stage];
+    this->phase = 0;
+    this->ticks = 0;
+    this->maxBacklog = 0;
+    this->minPulseCycles = 0xffffffff;
+
+    this->desiredPosition = this->startPosition = this->stepperDrive->getCurrentPosition();
+    this->stepperDrive->setDesiredPosition(this->desiredPosition);
+    this->startCount = EQep1Regs.QPOSCNT;
+
+    // restart the capture sequence on the next leading edge
+    ECap1Regs.ECCTL2.bit.CTRFILTRESET = 1;
+
+    // the static checks leave the pins low; put them back the way the drive left them
+    GPIO_SET_DIRECTION;
+    GPIO_SET_ENABLE;
+
+    this->draining = false;
+    this->running = true;
+}
+
+void TestStep :: finishStage(void)
+{
+    if( ! this->running ) {
+        return;
+    }
+
+    // stop requesting steps and let the drive catch up
+    this->draining = true;
+    Uint32 issuedAtRate = this->stepperDrive->getCurrentPosition() - this->startPosition;
+    for( Uint16 i = 0; i < STEP_TEST_DRAIN_TIMEOUT && this->stepperDrive->getCurrentPosition() != this->desiredPosition; i++ ) {
+        DELAY_US(100);
+    }
+    DELAY_US(STEPPER_CYCLE_US * 2);
+    this->running = false;
+
+    STEP_RATE_RESULT *result = &this->results[this->stage];
+    result->rate = this->rate;
+    result->achieved = this->ticks ? (Uint64)issuedAtRate * STEP_TEST_ISR_HZ / this->ticks : 0;
+    result->issued = this->stepperDrive->getCurrentPosition() - this->startPosition;
+    result->counted = EQep1Regs.QPOSCNT - this->startCount;
+    result->maxBacklog = this->maxBacklog;
+    result->minPulseNs = this->minPulseCycles == 0xffffffff ? 0 : this->minPulseCycles * 1000 / CPU_CLOCK_MHZ;
+    result->sustained = result->issued == result->counted
+            && result->maxBacklog <= MAX_BUFFERED_STEPS
+            && (Uint64)result->achieved * 100 >= (Uint64)result->rate * 99;
+
+    if( ++this->stage >= STEP_TEST_NUM_RATES ) {
+        this->stage = 0;
+
+        // the sustained rate is the last one before the first failure
+        this->maxSustainedRate = 0;
+        this->minPulseNs = 0xffffffff;
+        this->missedSteps = 0;
+        bool failed = false;
+        for( Uint16 i = 0; i < STEP_TEST_NUM_RATES; i++ ) {
+            failed = failed || ! this->results[i].sustained;
+            if( ! failed ) {
+                this->maxSustainedRate = this->results[i].rate;
+            }
+            if( this->results[i].minPulseNs < this->minPulseNs ) {
+                this->minPulseNs = this->results[i].minPulseNs;
+            }
+            if( this->results[i].issued > this->results[i].counted ) {
+                this->missedSteps += this->results[i].issued - this->results[i].counted;
+            }
+        }
+
+        this->sweepPass = this->maxSustainedRate >= STEP_TEST_MIN_RATE_HZ
+                && this->minPulseNs >= STEP_TEST_MIN_PULSE_NS;
+    }
 }
@@ -31,11 +31,70 @@
 #include "ControlPanel.h"
 #include "StepperDrive.h"
 
+// stepper state machine interrupt rate
+#define STEP_TEST_ISR_HZ (1000000 / STEPPER_CYCLE_US)
+
+// number of rates in the dynamic sweep
+#define STEP_TEST_NUM_RATES 10
+
+
+// Result of running the stepper at one rate
+typedef struct STEP_RATE_RESULT
+{
+    // requested step rate, in Hertz
+    Uint32 rate;
+
+    // step rate the drive actually produced, in Hertz
+    Uint32 achieved;
+
+    // steps issued by the drive and pulses counted on the feedback pin
+    Uint32 issued;
+    Uint32 counted;
+
+    // greatest number of steps the drive fell behind
+    int32 maxBacklog;
+
+    // narrowest pulse seen on the feedback pin, in nanoseconds
+    Uint32 minPulseNs;
+
+    // every step arrived and the drive kept up
+    bool sustained;
+} STEP_RATE_RESULT;
+
+
 class TestStep
 {
 private:
     StepperDrive *stepperDrive;
 
+    //
+    // Dynamic test state shared with the ISR
+    //
+    volatile bool running;
+    volatile bool draining;
+    Uint32 rate;
+    Uint32 phase;
+    int32 desiredPosition;
+    int32 startPosition;
+    Uint32 startCount;
+    volatile Uint32 ticks;
+    volatile int32 maxBacklog;
+    volatile Uint32 minPulseCycles;
+
+    //
+    // Sweep results, for inspection in the debugger
+    //
+    Uint16 stage;
+    bool sweepPass;
+    STEP_RATE_RESULT results[STEP_TEST_NUM_RATES];
+    Uint32 maxSustainedRate;
+    Uint32 minPulseNs;
+    Uint32 missedSteps;
+
+    bool testStatic(void);
+    void finishStage(void);
+    void startStage(void);
+
 public:
     TestStep(StepperDrive *stepperDrive);
 
@@ -44,7 +103,41 @@ public:
 
     // execute test
     void test(LED_REG *output);
+
+    // drive the stepper during the dynamic test
+    void ISR(void);
 };
 
 
+inline void TestStep :: ISR(void)
+{
+    if( this->running ) {
+        if( ! this->draining ) {
+            this->phase += this->rate;
+            if( this->phase >= STEP_TEST_ISR_HZ ) {
+                this->phase -= STEP_TEST_ISR_HZ;
+                this->stepperDrive->setDesiredPosition(++this->desiredPosition);
+            }
+            this->ticks++;
+        }
+
+        this->stepperDrive->ISR();
+
+        int32 backlog = this->desiredPosition - this->stepperDrive->getCurrentPosition();
+        if( backlog > this->maxBacklog ) {
+            this->maxBacklog = backlog;
+        }
+
+        // width of the last pulse, from the leading to the trailing edge
+        if( ECap1Regs.ECFLG.bit.CEVT2 ) {
+            Uint32 width = ECap1Regs.CAP2;
+            if( width < this->minPulseCycles ) {
+                this->minPulseCycles = width;
+            }
+            ECap1Regs.ECCLR.bit.CEVT2 = 1;
+        }
+    }
+}
+
+
 #endif // __TEST_STEP_H
@@ -30,12 +30,14 @@
 #include "ControlPanel.h"
 #include "EEPROM.h"
 #include "StepperDrive.h"
+#include "Encoder.h"
 #include "Debug.h"
 #include "TestKeys.h"
 #include "TestEEPROM.h"
 #include "TestVREG.h"
 #include "TestStep.h"
 #include "TestAlarm.h"
+#include "TestEncoder.h"
 
 
 __interrupt void cpu_timer0_isr(void);
@@ -62,12 +64,16 @@ EEPROM eeprom(&spiBus);
 // Stepper driver
 StepperDrive stepperDrive;
 
+// Encoder driver
+Encoder encoder;
+
 // Tests
 TestKeys testKeys;
 TestEEPROM testEeprom(&eeprom);
 TestVREG testVreg;
 TestStep testStep(&stepperDrive);
 TestAlarm testAlarm(&stepperDrive);
+TestEncoder testEncoder(&encoder);
 
 void main(void)
 {
@@ -118,11 +124,13 @@ void main(void)
     controlPanel.initHardware();
     eeprom.initHardware();
     stepperDrive.initHardware();
+    encoder.initHardware();
     testKeys.initHardware();
     testEeprom.initHardware();
     testVreg.initHardware();
     testStep.initHardware();
     testAlarm.initHardware();
+    testEncoder.initHardware();
 
     // Enable CPU INT1 which is connected to CPU-Timer 0
     IER |= M_INT1;
@@ -147,6 +155,8 @@ void main(void)
 
         keys = controlPanel.getKeys();
 
+        // the key test takes over the A-D LEDs while its keys are held
+        testEncoder.test(&leds);
         testKeys.test(keys, &leds);
         testEeprom.test(&leds);
         testVreg.test(&leds);
@@ -174,6 +184,9 @@ cpu_timer0_isr(void)
     // flag entrance to ISR for timing
     debug.begin1();
 
+    // run the stepper for the dynamic step test
+    testStep.ISR();
+
     // flag exit from ISR for timing
     debug.end1();
 
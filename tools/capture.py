@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+#
+# Clough42 Electronic Leadscrew
+# https://github.com/clough42/electronic-leadscrew
+#
+# MIT License
+#
+# Copyright (c) 2019 James Clough
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Record, inspect and play back ELS encoder captures.
+
+The firmware built with USE_ENCODER_CAPTURE streams the spindle encoder count
+from every ISR tick out of the serial port (see EncoderCapture.h in
+els-f280049c for the frame layout).  A capture file is just the raw bytes.
+
+    record   save the stream from the serial port to a file (needs pyserial)
+    info     summarize a capture: length, travel, speed, damage
+    csv      write the count at every tick, or every Nth, as CSV
+    play     stream a capture to the EncoderSimulator sketch, which turns it
+             back into quadrature for a real ELS on the bench
+
+To run a capture through the engine on a PC, use the replayer in host/:
+
+    make -C host replay CAPTURE=spindle.cap
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+SYNC = b"\xC3\x3C"
+FRAME_BYTES = 44
+BLOCK_TICKS = 128
+HEADER = struct.Struct("<HIH")          # sequence, start count, escapes
+MAX_COUNT = 0x00FFFFFF
+TICK_SECONDS = 5e-6
+
+STILL, FORWARD, ESCAPE, BACKWARD = 0, 1, 2, 3
+
+# EncoderSimulator replay stream
+PLAY_BAUD = 1000000
+PLAY_WAIT = 0x00                        # no count for 128 ticks
+PLAY_BACKWARD = 0x80
+PLAY_CREDIT = 32                        # bytes the sketch uses per '+' it sends
+PLAY_WINDOW = 64                        # its receive buffer
+
+
+def fletcher16(data):
+    sum1 = sum2 = 0
+    for byte in data:
+        sum1 = (sum1 + byte) % 255
+        sum2 = (sum2 + sum1) % 255
+    return sum1, sum2
+
+
+def difference(to, frm):
+    """Signed difference between two encoder counts, the short way round."""
+    d = (to - frm) & MAX_COUNT
+    return d - (MAX_COUNT + 1) if d > MAX_COUNT // 2 else d
+
+
+class Capture:
+    """A decoded capture: the encoder count at every tick.
+
+    Mirrors host/replay/CaptureReader: escapes take the difference between
+    the block's end and the next block's start, and missing blocks are filled
+    by moving the count steadily across the gap.
+    """
+
+    def __init__(self, data):
+        self.frames = self.bad = self.missing = self.escapes = self.unresolved = 0
+        blocks = []
+        at = 0
+        while at + FRAME_BYTES <= len(data):
+            if data[at:at + 2] != SYNC:
+                at += 1
+                continue
+            frame = data[at:at + FRAME_BYTES]
+            if fletcher16(frame[2:FRAME_BYTES - 2]) != (frame[-2], frame[-1]):
+                self.bad += 1
+                at += 1
+                continue
+            sequence, start, _ = HEADER.unpack(bytes(frame[2:10]))
+            codes = [(frame[10 + tick // 4] >> ((tick % 4) * 2)) & 3 for tick in range(BLOCK_TICKS)]
+            blocks.append((sequence, start, codes))
+            self.frames += 1
+            at += FRAME_BYTES
+
+        self.counts = []
+        for index, (sequence, start, codes) in enumerate(blocks):
+            if index > 0:
+                missing = (sequence - blocks[index - 1][0] - 1) & 0xFFFF
+                ticks = missing * BLOCK_TICKS
+                self.missing += missing
+                frm = self.counts[-1]
+                travel = difference(start, frm)
+                for tick in range(1, ticks + 1):
+                    self.counts.append((frm + int(travel * tick / (ticks + 1))) & MAX_COUNT)
+
+            known = codes.count(FORWARD) - codes.count(BACKWARD)
+            escapes = codes.count(ESCAPE)
+            self.escapes += escapes
+            share = extra = 0
+            if escapes:
+                if index + 1 < len(blocks) and (blocks[index + 1][0] - sequence) & 0xFFFF == 1:
+                    rest = difference(blocks[index + 1][1], start) - known
+                    share = int(rest / escapes)
+                    extra = rest - share * escapes
+                else:
+                    self.unresolved += escapes
+
+            count = start
+            for code in codes:
+                if code == FORWARD:
+                    count += 1
+                elif code == BACKWARD:
+                    count -= 1
+                elif code == ESCAPE:
+                    count += share + extra
+                    extra = 0
+                count &= MAX_COUNT
+                self.counts.append(count)
+
+    def moves(self):
+        """Yield the change in count at each tick after the first."""
+        for previous, count in zip(self.counts, self.counts[1:]):
+            yield difference(count, previous)
+
+
+def load(path):
+    with open(path, "rb") as stream:
+        capture = Capture(stream.read())
+    if not capture.counts:
+        sys.exit("%s: no capture frames" % path)
+    return capture
+
+
+def open_port(port, baud, timeout):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("the serial port needs pyserial (pip install pyserial)")
+    return serial.Serial(port, baud, timeout=timeout)
+
+
+def record(args):
+    port = open_port(args.port, args.baud, 0.1)
+    end = time.time() + args.seconds if args.seconds else None
+    total = 0
+    with open(args.output, "wb") as out:
+        try:
+            while end is None or time.time() < end:
+                data = port.read(65536)
+                out.write(data)
+                total += len(data)
+        except KeyboardInterrupt:
+            pass
+    print("%d bytes, about %.1f seconds" % (total, total / FRAME_BYTES * BLOCK_TICKS * TICK_SECONDS),
+          file=sys.stderr)
+
+
+def info(args):
+    capture = load(args.capture)
+    window = int(0.01 / TICK_SECONDS)
+    travel = window_travel = 0
+    top = 0.0
+    for tick, move in enumerate(capture.moves(), 1):
+        travel += move
+        window_travel += move
+        if tick % window == 0:
+            top = max(top, abs(window_travel) / args.resolution / (window * TICK_SECONDS) * 60)
+            window_travel = 0
+    print("%s: %.3fs, %.1f revolutions net, top speed %.0f RPM" % (
+        args.capture, len(capture.counts) * TICK_SECONDS, travel / args.resolution, top))
+    print("%d frames, %d bad, %d blocks missing, %d escapes, %d unresolved" % (
+        capture.frames, capture.bad, capture.missing, capture.escapes, capture.unresolved))
+
+
+def csv(args):
+    capture = load(args.capture)
+    out = open(args.output, "w") if args.output else sys.stdout
+    out.write("tick,time,count\n")
+    for tick in range(0, len(capture.counts), args.every):
+        out.write("%d,%.6f,%d\n" % (tick, tick * TICK_SECONDS, capture.counts[tick]))
+    if out is not sys.stdout:
+        out.close()
+
+
+def play_records(capture, speed):
+    """One byte per count: ticks since the last count, and the direction."""
+    records = bytearray()
+    due = 0.0                   # ticks since the last count, at playback speed
+    for move in capture.moves():
+        due += 1 / speed
+        for _ in range(abs(move)):
+            interval = max(1, int(round(due)))
+            due -= interval
+            while interval > 127:
+                records.append(PLAY_WAIT)
+                interval -= 128
+            if interval < 1:
+                # a wait ran right up to this count; take the tick from the next
+                due += interval - 1
+                interval = 1
+            records.append(interval | (PLAY_BACKWARD if move < 0 else 0))
+    return records
+
+
+def play(args):
+    capture = load(args.capture)
+    records = play_records(capture, args.speed)
+    port = open_port(args.port, PLAY_BAUD, 1.0)
+    time.sleep(2)               # the sketch restarts when the port opens
+    port.reset_input_buffer()
+
+    sent = 0
+    credit = PLAY_WINDOW
+    started = time.time()
+    try:
+        while sent < len(records):
+            if credit < PLAY_CREDIT:
+                reply = port.read(1)
+                if not reply:
+                    sys.exit("no reply from the encoder simulator")
+                credit += PLAY_CREDIT
+            chunk = records[sent:sent + credit]
+            port.write(chunk)
+            sent += len(chunk)
+            credit -= len(chunk)
+    except KeyboardInterrupt:
+        pass
+    took = time.time() - started
+    print("%d counts in %.1fs, capture was %.1fs" % (
+        len(records), took, len(capture.counts) * TICK_SECONDS), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    command = commands.add_parser("record", help="save the stream from the serial port")
+    command.add_argument("output", help="capture file to write")
+    command.add_argument("-p", "--port", required=True, help="serial port the ELS is on")
+    command.add_argument("-b", "--baud", type=int, default=1562500, help="SERIAL_BAUD (default 1562500)")
+    command.add_argument("-s", "--seconds", type=float, help="stop after this long (default Ctrl-C)")
+    command.set_defaults(run=record)
+
+    command = commands.add_parser("info", help="summarize a capture")
+    command.add_argument("capture")
+    command.add_argument("-r", "--resolution", type=int, default=4096, help="ENCODER_RESOLUTION (default 4096)")
+    command.set_defaults(run=info)
+
+    command = commands.add_parser("csv", help="write the counts as CSV")
+    command.add_argument("capture")
+    command.add_argument("-o", "--output", help="CSV file to write (default stdout)")
+    command.add_argument("-e", "--every", type=int, default=1, help="write every Nth tick (default 1)")
+    command.set_defaults(run=csv)
+
+    command = commands.add_parser("play", help="stream a capture to the EncoderSimulator sketch")
+    command.add_argument("capture")
+    command.add_argument("-p", "--port", required=True, help="serial port the sketch is on")
+    command.add_argument("--speed", type=float, default=1.0,
+                         help="playback speed; the sketch manages about 100000 counts/s (default 1)")
+    command.set_defaults(run=play)
+
+    args = parser.parse_args()
+    if getattr(args, "every", 1) < 1 or getattr(args, "speed", 1) <= 0:
+        parser.error("--every and --speed must be positive")
+    args.run(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+#
+# Clough42 Electronic Leadscrew
+# https://github.com/clough42/electronic-leadscrew
+#
+# MIT License
+#
+# Copyright (c) 2019 James Clough
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Check an ISR benchmark report against a stored baseline.
+
+Reads the CSV report from the ENABLE_ISR_BENCHMARK firmware (from a file or
+straight from the serial port; needs pyserial) or from the host build in
+host/, and compares the worst-case cycles of every case with the baseline
+for the same platform and math configuration:
+
+    <baselines>/<platform>-<float|integer>.csv
+
+A case regresses when its worst time grows by more than the tolerance plus
+the slack.  Regressions are listed and the exit status is 1, as it is when
+there is no baseline yet; --save stores the report as the baseline instead.
+Cases only in one of the two files (table rows added or removed) are noted
+but don't fail the check.
+
+Noisy timing (the host build) can pass several reports from the same code.
+A saved baseline keeps every case's slowest worst time and a check its
+fastest, so a case only regresses when every run is slower than any run the
+baseline was taken from.
+"""
+
+import argparse
+import os
+import sys
+
+DEFAULT_BASELINES = os.path.join(os.path.dirname(os.path.abspath(__file__)), "isr_baselines")
+
+
+def read_report(lines):
+    """Return (math, {(case, table, row): (max, mean)}) from report lines."""
+    math = None
+    results = {}
+    for line in lines:
+        line = line.strip()
+        if not line:
+            continue
+        if line.startswith("#"):
+            if "isr benchmark" in line:
+                math = "float" if "floating point" in line else "integer"
+            if line.startswith("# end"):
+                break
+            continue
+        fields = line.split(",")
+        if fields[0] == "case" or len(fields) != 5:
+            continue
+        results[tuple(fields[:3])] = (int(fields[3]), int(fields[4]))
+    if math is None:
+        sys.exit("no benchmark report found")
+    return math, results
+
+
+def merge_reports(reports, pick):
+    """Combine reports of the same math, keeping pick() of each case's times."""
+    math = reports[0][0]
+    results = {}
+    for report_math, report in reports:
+        if report_math != math:
+            sys.exit("reports mix floating point and integer math")
+        for key, (worst, mean) in report.items():
+            if key in results:
+                worst = pick(worst, results[key][0])
+                mean = pick(mean, results[key][1])
+            results[key] = (worst, mean)
+    return math, results
+
+
+def serial_lines(args):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("reading a serial port needs pyserial (pip install pyserial)")
+    port = serial.Serial(args.port, args.baud, timeout=30)
+    while True:
+        line = port.readline()
+        if not line:
+            sys.exit("serial port timed out before the end of the report")
+        line = line.decode("ascii", "replace")
+        yield line
+        if line.startswith("# end"):
+            return
+
+
+def write_report(path, math, results):
+    os.makedirs(os.path.dirname(path) or ".", exist_ok=True)
+    with open(path, "w") as out:
+        out.write("# isr benchmark, %s math, cycles per call\n" %
+                  ("floating point" if math == "float" else "integer"))
+        out.write("case,table,row,max,mean\n")
+        for key, (worst, mean) in results.items():
+            out.write("%s,%d,%d\n" % (",".join(key), worst, mean))
+        out.write("# end, %d cases\n" % len(results))
+
+
+def name(key):
+    case, table, row = key
+    return "%s %s %s" % (case, table, row) if table else case
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", nargs="*", default=["-"], help="report files (default stdin)")
+    parser.add_argument("-p", "--port", help="read the report from this serial port instead")
+    parser.add_argument("-b", "--baud", type=int, default=781250, help="SERIAL_BAUD (default 781250)")
+    parser.add_argument("--platform", default="target", help="target or host (default target)")
+    parser.add_argument("--baselines", default=DEFAULT_BASELINES, help="baseline directory (default tools/isr_baselines)")
+    parser.add_argument("--tolerance", type=float, default=5, help="allowed growth in percent (default 5)")
+    parser.add_argument("--slack", type=int, default=2, help="allowed growth in cycles on top (default 2)")
+    parser.add_argument("--save", action="store_true", help="store the report as the new baseline")
+    args = parser.parse_args()
+
+    if args.port:
+        reports = [read_report(serial_lines(args))]
+    else:
+        reports = [read_report(sys.stdin if path == "-" else open(path)) for path in args.input]
+    math, results = merge_reports(reports, max if args.save else min)
+
+    baseline_path = os.path.join(args.baselines, "%s-%s.csv" % (args.platform, math))
+    worst = max(worst for worst, mean in results.values())
+    print("%d cases, %s math, worst %d cycles over %d report(s)" % (len(results), math, worst, len(reports)))
+
+    if args.save:
+        write_report(baseline_path, math, results)
+        print("saved baseline %s" % baseline_path)
+        return
+    if not os.path.exists(baseline_path):
+        sys.exit("no baseline %s; check the code out at a good commit and run with --save" % baseline_path)
+
+    with open(baseline_path) as stream:
+        _, baseline = read_report(stream)
+    print("baseline %s, worst %d cycles" % (baseline_path, max(worst for worst, mean in baseline.values())))
+
+    regressions = []
+    for key, (worst, mean) in results.items():
+        if key not in baseline:
+            print("new case: %s" % name(key))
+            continue
+        limit = baseline[key][0] * (1 + args.tolerance / 100) + args.slack
+        if worst > limit:
+            regressions.append((key, baseline[key][0], worst))
+    for key in baseline:
+        if key not in results:
+            print("case no longer run: %s" % name(key))
+
+    for key, before, after in regressions:
+        print("REGRESSION %s: worst %d -> %d cycles" % (name(key), before, after))
+    if regressions:
+        print("%d of %d cases regressed" % (len(regressions), len(results)))
+        sys.exit(1)
+    print("no regressions")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+#
+# Clough42 Electronic Leadscrew
+# https://github.com/clough42/electronic-leadscrew
+#
+# MIT License
+#
+# Copyright (c) 2019 James Clough
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Build a feed and thread table image for the ELS EEPROM.
+
+The input is a text file with up to four sections, one value per line:
+
+    [inch threads]      threads per inch, to 0.1      e.g. 11.5
+    [inch feeds]        inches per revolution, to .001  e.g. .004
+    [metric threads]    millimeters of pitch, to .01    e.g. 1.25
+    [metric feeds]      millimeters per revolution, to .01
+
+Mark the row to select by default with a '*' after the value.  Blank lines
+and anything after '#' are ignored.  A section that is left out keeps the
+built-in table.
+
+Every row is checked against the leadscrew, stepper and encoder settings in
+Configuration.h: a row whose step count would overflow the firmware's signed
+32-bit position at the full encoder range is an error.
+
+The output is the raw image, high byte of each word first, to be written to
+the EEPROM at the offset printed for your hardware version.  See
+FeedTableFactory in els-f280049c/Tables.h for the layout.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x7AB1
+PAGE_SIZE_WORDS = 8
+PAGE_COUNT = {1: 32, 2: 64}             # 25AA040A, AT25080B
+OVERHEAD = 2 + 4 + 1                    # header, table headers, CRC
+
+# section name, decimals, label style, as in table_formats in Tables.cpp
+FIXED, BLANK_ZEROS, TRIM_ZEROS = range(3)
+SECTIONS = [
+    ("inch threads", 1, TRIM_ZEROS),
+    ("inch feeds", 3, FIXED),
+    ("metric threads", 2, BLANK_ZEROS),
+    ("metric feeds", 2, FIXED),
+]
+LABEL_CELLS = 4
+LABEL_LENGTH = 5
+
+ENCODER_MAX_COUNT = 0x00FFFFFF          # _ENCODER_MAX_COUNT in Encoder.h
+DEFAULT_CONFIG = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              "..", "els-f280049c", "Configuration.h")
+
+
+def crc16(words, crc=0xFFFF):
+    """CRC-16/CCITT over words, high byte first, as crc16() in CRC.cpp."""
+    for word in words:
+        for byte in (word >> 8, word & 0xFF):
+            crc ^= byte << 8
+            for _ in range(8):
+                crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+                crc &= 0xFFFF
+    return crc
+
+
+def format_label(value, decimals, style):
+    """The label the firmware will show for a row; see formatLabel()."""
+    digits = str(value).rjust(decimals + 1, "0")
+    integer, fraction = digits[:len(digits) - decimals], digits[len(digits) - decimals:]
+    if integer == "0":
+        integer = ""
+    stripped = fraction.rstrip("0")
+    if style == FIXED:
+        shown, blanks = fraction, 0
+    else:
+        shown = stripped
+        blanks = len(fraction) - len(stripped) if style == BLANK_ZEROS else 0
+    text = integer + ("." + shown if shown else "") + " " * blanks
+    cells = len(integer) + len(shown) + blanks + (1 if shown and not integer else 0)
+    if cells > LABEL_CELLS or LABEL_CELLS - cells + len(text) > LABEL_LENGTH:
+        return "-" * LABEL_CELLS
+    return " " * (LABEL_CELLS - cells) + text
+
+
+def parse_value(text, decimals, where):
+    whole, _, fraction = text.partition(".")
+    if not (whole + fraction).isdigit() or len(fraction) > decimals:
+        raise ValueError("%s: '%s' is not a number with at most %d decimals" % (where, text, decimals))
+    value = int((whole or "0") + fraction.ljust(decimals, "0"))
+    if value < 1 or value > 0xFFFF:
+        raise ValueError("%s: '%s' is out of range" % (where, text))
+    return value
+
+
+def read_config(path):
+    """The numeric #defines in Configuration.h that aren't commented out."""
+    defines = {}
+    with open(path) as f:
+        for line in f:
+            match = re.match(r"\s*#define\s+(\w+)\s+([^/]+)", line)
+            if not match:
+                continue
+            try:
+                defines[match.group(1)] = eval(match.group(2), {}, dict(defines))
+            except Exception:
+                pass                    # not a number
+    return defines
+
+
+def ratio(name, value, config):
+    """The row's gear ratio, numerator and denominator, as buildRow() in Tables.cpp."""
+    encoder = config["ENCODER_RESOLUTION"]
+    if name.endswith("feeds"):
+        stepper = config["STEPPER_RESOLUTION_FEED"] * config["STEPPER_MICROSTEPS_FEED"]
+    else:
+        stepper = config["STEPPER_RESOLUTION"] * config["STEPPER_MICROSTEPS"]
+    tpi = config.get("LEADSCREW_TPI")
+    hmm = config.get("LEADSCREW_HMM")
+
+    if name == "inch threads":
+        return (tpi * stepper * 10, value * encoder) if tpi else (254 * 100 * stepper, value * encoder * hmm)
+    if name == "inch feeds":
+        return (value * tpi * stepper, encoder * 1000) if tpi else (value * 254 * stepper, encoder * 100 * hmm)
+    return (value * 10 * tpi * stepper, encoder * 254 * 100) if tpi else (value * stepper, encoder * hmm)
+
+
+def check(tables, config):
+    """Fail on any row the firmware would refuse, as ratioInRange() in Tables.h."""
+    for name, decimals, style in SECTIONS:
+        for value in tables.get(name, {"rows": []})["rows"]:
+            numerator, denominator = ratio(name, value, config)
+            if denominator == 0 or ENCODER_MAX_COUNT * numerator // denominator > 0x7FFFFFFF:
+                raise ValueError("[%s] '%s' needs more steps than the firmware can count"
+                                 % (name, format_label(value, decimals, style).strip()))
+
+
+def parse(lines, filename):
+    tables = {}
+    current = None
+    for number, line in enumerate(lines, 1):
+        where = "%s:%d" % (filename, number)
+        line = line.split("#", 1)[0].strip()
+        if not line:
+            continue
+        if line.startswith("["):
+            name = line.strip("[]").strip().lower()
+            if name not in [s[0] for s in SECTIONS]:
+                raise ValueError("%s: unknown section [%s]" % (where, name))
+            if name in tables:
+                raise ValueError("%s: section [%s] appears twice" % (where, name))
+            current = tables[name] = {"rows": [], "default": None}
+            continue
+        if current is None:
+            raise ValueError("%s: value outside of a section" % where)
+        default = line.endswith("*")
+        text = line.rstrip("*").strip()
+        decimals = [s[1] for s in SECTIONS if tables.get(s[0]) is current][0]
+        if default:
+            if current["default"] is not None:
+                raise ValueError("%s: more than one default row" % where)
+            current["default"] = len(current["rows"])
+        current["rows"].append(parse_value(text, decimals, where))
+    return tables
+
+
+def build(tables, hardware):
+    words = [MAGIC, 0]
+    for name, decimals, style in SECTIONS:
+        table = tables.get(name, {"rows": [], "default": None})
+        if len(table["rows"]) > 255:
+            raise ValueError("[%s] has more than 255 rows" % name)
+        default = table["default"] or 0
+        words.append((len(table["rows"]) << 8) | default)
+        words.extend(table["rows"])
+    words[1] = len(words) + 1
+
+    capacity = (PAGE_COUNT[hardware] - PAGE_COUNT[hardware] // 2) * PAGE_SIZE_WORDS
+    if words[1] > capacity:
+        raise ValueError("%d rows won't fit; hardware version %d has room for %d"
+                         % (words[1] - OVERHEAD, hardware, capacity - OVERHEAD))
+
+    words.append(crc16(words))
+    return words
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", help="table description")
+    parser.add_argument("-o", "--output", required=True, help="binary image to write")
+    parser.add_argument("--hardware", type=int, choices=sorted(PAGE_COUNT), default=2,
+                        help="hardware version, as HARDWARE_VERSION in Configuration.h")
+    parser.add_argument("--config", default=DEFAULT_CONFIG,
+                        help="firmware Configuration.h (default els-f280049c/Configuration.h)")
+    parser.add_argument("-v", "--verbose", action="store_true", help="list the labels")
+    args = parser.parse_args()
+
+    try:
+        with open(args.input) as f:
+            tables = parse(f.readlines(), args.input)
+        check(tables, read_config(args.config))
+        words = build(tables, args.hardware)
+    except ValueError as e:
+        sys.exit("error: %s" % e)
+
+    with open(args.output, "wb") as f:
+        f.write(struct.pack(">%dH" % len(words), *words))
+
+    offset = (PAGE_COUNT[args.hardware] // 2) * PAGE_SIZE_WORDS * 2
+    print("%s: %d words, write at EEPROM byte offset 0x%03X" % (args.output, len(words), offset))
+    for name, decimals, style in SECTIONS:
+        table = tables.get(name)
+        if table is None:
+            print("  %-15s built-in" % name)
+            continue
+        print("  %-15s %d rows" % (name, len(table["rows"])))
+        if args.verbose:
+            for i, value in enumerate(table["rows"]):
+                mark = " *" if i == (table["default"] or 0) else ""
+                print("      '%s'%s" % (format_label(value, decimals, style), mark))
+
+
+if __name__ == "__main__":
+    main()
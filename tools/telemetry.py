@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+#
+# Clough42 Electronic Leadscrew
+# https://github.com/clough42/electronic-leadscrew
+#
+# MIT License
+#
+# Copyright (c) 2019 James Clough
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+"""Decode the ELS telemetry stream to CSV.
+
+Reads the binary stream sent with USE_TELEMETRY enabled, either from a
+capture file or straight from the serial port (needs pyserial), and writes
+one CSV row per sample:
+
+    sample      sample number, counting any the firmware dropped
+    time        seconds since the first sample
+    spindle     spindle encoder count
+    position    carriage position, in steps
+    desired     desired carriage position, in steps
+    backlog     steps the drive is behind the desired position
+    rpm         spindle RPM
+
+Frames with a bad checksum are skipped and the decoder resynchronizes on the
+next sync bytes.  Dropped samples and bad frames are counted on stderr.  See
+Telemetry.h in els-f280049c for the frame layout.
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = b"\xA5\x5A"
+FRAME_BYTES = 18
+PAYLOAD = struct.Struct("<HIihH")       # sequence, spindle, position, backlog, rpm
+
+
+def fletcher16(data):
+    sum1 = sum2 = 0
+    for byte in data:
+        sum1 = (sum1 + byte) % 255
+        sum2 = (sum2 + sum1) % 255
+    return sum1, sum2
+
+
+class Decoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.sample = None
+        self.last_sequence = None
+        self.dropped = 0
+        self.bad = 0
+
+    def feed(self, data):
+        """Add bytes from the stream, yielding each complete sample."""
+        self.buffer += data
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                # keep a trailing first sync byte, in case the second follows
+                del self.buffer[:max(0, len(self.buffer) - 1)]
+                return
+            if len(self.buffer) - start < FRAME_BYTES:
+                del self.buffer[:start]
+                return
+
+            frame = self.buffer[start:start + FRAME_BYTES]
+            if fletcher16(frame[2:16]) != (frame[16], frame[17]):
+                # not a real frame; look for the next sync after this one
+                self.bad += 1
+                del self.buffer[:start + 1]
+                continue
+            del self.buffer[:start + FRAME_BYTES]
+
+            sequence, spindle, position, backlog, rpm = PAYLOAD.unpack(bytes(frame[2:16]))
+            if self.last_sequence is None:
+                self.sample = 0
+            else:
+                step = (sequence - self.last_sequence) & 0xFFFF
+                self.dropped += step - 1
+                self.sample += step
+            self.last_sequence = sequence
+
+            yield self.sample, spindle, position, position + backlog, backlog, rpm
+
+
+def open_input(args):
+    if args.port:
+        try:
+            import serial
+        except ImportError:
+            sys.exit("reading a serial port needs pyserial (pip install pyserial)")
+        port = serial.Serial(args.port, args.baud, timeout=0.1)
+        return lambda: port.read(4096)
+    stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb")
+    return lambda: stream.read(4096) or None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("input", nargs="?", default="-", help="capture file (default stdin)")
+    parser.add_argument("-p", "--port", help="read from this serial port instead")
+    parser.add_argument("-b", "--baud", type=int, default=781250, help="SERIAL_BAUD (default 781250)")
+    parser.add_argument("-r", "--rate", type=float, default=2500, help="TELEMETRY_RATE_HZ (default 2500)")
+    parser.add_argument("-o", "--output", help="CSV file to write (default stdout)")
+    args = parser.parse_args()
+
+    read = open_input(args)
+    out = open(args.output, "w") if args.output else sys.stdout
+    decoder = Decoder()
+
+    out.write("sample,time,spindle,position,desired,backlog,rpm\n")
+    try:
+        while True:
+            data = read()
+            if data is None:
+                break
+            for sample, spindle, position, desired, backlog, rpm in decoder.feed(data):
+                out.write("%d,%.6f,%d,%d,%d,%d,%d\n" % (
+                    sample, sample / args.rate, spindle, position, desired, backlog, rpm))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if out is not sys.stdout:
+            out.close()
+        print("%d samples dropped, %d bad frames" % (decoder.dropped, decoder.bad), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()